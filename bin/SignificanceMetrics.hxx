@@ -242,7 +242,7 @@ class SignificanceMetric
                     s2 += significance2(isig, ibg, backgroundOut, insig, inbg, nbackgroundOut);
                 }
             }
-       
+            return s2;
         }
 
         double significance2(TH1D* hsignal, TH1D* hbackground, TH1D* hdata, TH1D* hnsignal, TH1D* hnbackground, TH1D* hndata)
@@ -276,7 +276,7 @@ class SignificanceMetric
                     s2 += significance2(isig, ibg, backgroundOut, dataOut, insig, inbg, nbackgroundOut, ndataOut);
                 }
             }
-       
+            return s2;
         }
 };
 
@@ -80,15 +80,14 @@ void TMVAClassificationApplication_H2Mu( TString myMethodList = "" )
    TString weightfile_multi = dir+"f_Opt_v1_multi_all_sig_all_bkg_ge0j_BDTG_UF_v1.weights.xml";
 
    /////////////////////////////////////////////////////
-   // Book training and spectator vars into reader
+   // Load the classifiers, read only after loading
 
-   std::map<TString, Float_t> tmap;
-   std::map<TString, Float_t> smap;
-   TMVA::Reader* reader = TMVATools::bookVars(methodName, weightfile, tmap, smap);
-   
-   std::map<TString, Float_t> tmap_multi;
-   std::map<TString, Float_t> smap_multi;
-   TMVA::Reader* reader_multi = TMVATools::bookVars(methodName, weightfile_multi, tmap_multi, smap_multi);
+   std::shared_ptr<const BDTForest> classifier = TMVATools::getClassifier(weightfile);
+   std::shared_ptr<const BDTForest> classifier_multi = TMVATools::getClassifier(weightfile_multi);
+   if(!classifier || !classifier_multi) return;
+
+   ClassifierInputs bdtInputs;
+   ClassifierInputs bdtInputs_multi;
    
    std::vector<TString> classes; 
    TMVATools::getClassNames(weightfile_multi, classes);
@@ -176,10 +175,10 @@ void TMVAClassificationApplication_H2Mu( TString myMethodList = "" )
       //CollectionCleaner::cleanByDR(s->vars.validJets, s->vars.validElectrons, 0.4);
 
       std::cout << std::endl;
-      Float_t valb = TMVATools::getClassifierScore(reader, methodName, tmap, s->vars);
+      Float_t valb = TMVATools::getClassifierScore(*classifier, bdtInputs, s->vars);
       printf("!!! %d) BDT_Prediction: %f\n", s->vars.eventInfo->event, valb);
 
-      std::vector<float> vals = TMVATools::getMulticlassScores(reader_multi, methodName, tmap_multi, s->vars);
+      std::vector<float> vals = TMVATools::getMulticlassScores(*classifier_multi, bdtInputs_multi, s->vars);
       for(unsigned int j=0; j<vals.size(); j++)
       {
           printf("!!! %d) %s: %f\n", s->vars.eventInfo->event, classes[j].Data(), vals[j]);
@@ -191,8 +190,6 @@ void TMVAClassificationApplication_H2Mu( TString myMethodList = "" )
    sw.Stop();
    std::cout << "--- End of event loop: "; sw.Print();
 
-   delete reader;
-    
    std::cout << "==> TMVAClassificationApplication_H2Mu is done!" << std::endl << std::endl;
 }
 
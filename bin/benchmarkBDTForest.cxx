@@ -0,0 +1,263 @@
+/////////////////////////////////////////////////////////////////////////////
+//                           benchmarkBDTForest.cxx                        //
+//=========================================================================//
+//                                                                         //
+// Compare the BDTForest flat array evaluation to TMVA::Reader for a       //
+// weights file. Generates random events inside the training ranges of     //
+// the variables, evaluates them with Reader::EvaluateMVA, with            //
+// BDTForest::evaluate, and with BDTForest::evaluateBatch, checks that     //
+// the scores agree within float tolerance and outputs the timing.         //
+// With a multiclass weights file the multiclass forest is checked        //
+// against Reader::EvaluateMulticlass, and the FusedClassifier of the      //
+// binary and the multiclass forest is checked and timed against the two  //
+// separate BDTForest evaluations.                                         //
+//                                                                         //
+// Set MAIN=benchmarkBDTForest in the makefile then run via                //
+// ./benchmarkBDTForest <nevents> <weightfile> <methodName> <weightfile_multi> <methodName_multi>
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+#include "BDTForest.h"
+#include "FusedClassifier.h"
+#include "TMVATools.h"
+
+#include "TStopwatch.h"
+#include "TRandom3.h"
+#include "TMath.h"
+
+#include <sstream>
+#include <vector>
+#include <map>
+#include <iostream>
+#include <memory>
+#include <algorithm>
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+    int nevents = 100000;
+    TString weightfile = "classification/f_Opt_v1_all_sig_all_bkg_ge0j_BDTG_UF_v1.weights.xml";
+    TString methodName = "BDTG_UF_v1";
+    float tolerance = 1e-5;
+
+    if(argc > 1)
+    {
+        std::stringstream ss;
+        ss << argv[1];
+        ss >> nevents;
+    }
+    if(argc > 2) weightfile = argv[2];
+    if(argc > 3) methodName = argv[3];
+    TString weightfile_multi = (argc > 4) ? argv[4] : "";
+    TString methodName_multi = (argc > 5) ? argv[5] : "";
+
+    BDTForest forest(weightfile);
+    if(!forest.loaded) return 1;
+
+    std::map<TString, Float_t> tmap;
+    std::map<TString, Float_t> smap;
+    TMVA::Reader* reader = TMVATools::bookVars(methodName, weightfile, tmap, smap);
+
+    std::cout << Form("  /// %s: %d trees, %d nodes, %d variables \n", forest.methodName.Data(), forest.ntrees(), forest.nnodes(), forest.nvars);
+
+    // training ranges of the variables
+    std::vector<TString> mins, maxs;
+    TMVATools::getNames(weightfile, "Variable", "Min", mins);
+    TMVATools::getNames(weightfile, "Variable", "Max", maxs);
+
+    // generate the events up front so that only the evaluation is timed. The ranges have long
+    // tails so half of the values are drawn from the low end of the range where most events are
+    unsigned int nvars = forest.nvars;
+    TRandom3 r(42);
+    std::vector<float> x(nevents*nvars);
+    for(int i=0; i<nevents; i++)
+    {
+        for(unsigned int v=0; v<nvars; v++)
+        {
+            double lo = mins[v].Atof();
+            double hi = maxs[v].Atof();
+            if(r.Rndm() < 0.5) hi = lo + 0.1*(hi-lo);
+            x[i*nvars+v] = r.Uniform(lo, hi);
+        }
+    }
+
+    std::vector<float> reference(nevents), single(nevents), batch(nevents);
+    TStopwatch timer;
+
+    timer.Start();
+    for(int i=0; i<nevents; i++)
+    {
+        for(unsigned int v=0; v<nvars; v++)
+            tmap[forest.varnames[v]] = x[i*nvars+v];
+        reference[i] = reader->EvaluateMVA(methodName);
+    }
+    timer.Stop();
+    double treader = timer.RealTime();
+
+    timer.Start();
+    for(int i=0; i<nevents; i++)
+        single[i] = forest.evaluate(&x[i*nvars]);
+    timer.Stop();
+    double tsingle = timer.RealTime();
+
+    timer.Start();
+    forest.evaluateBatch(x.data(), nevents, batch.data());
+    timer.Stop();
+    double tbatch = timer.RealTime();
+
+    // the scores should agree up to the float rounding of the final transform
+    int nmismatch = 0;
+    double maxdiff = 0;
+    for(int i=0; i<nevents; i++)
+    {
+        double d = TMath::Max(TMath::Abs(reference[i]-single[i]), TMath::Abs(reference[i]-batch[i]));
+        if(d > maxdiff) maxdiff = d;
+        if(d > tolerance) nmismatch++;
+    }
+
+    std::cout << Form("  /// nevents:          %d \n", nevents);
+    std::cout << Form("  /// TMVA::Reader:     %8.3f s, %8.1f ns/event \n", treader, 1e9*treader/nevents);
+    std::cout << Form("  /// BDTForest single: %8.3f s, %8.1f ns/event \n", tsingle, 1e9*tsingle/nevents);
+    std::cout << Form("  /// BDTForest batch:  %8.3f s, %8.1f ns/event \n", tbatch, 1e9*tbatch/nevents);
+    std::cout << Form("  /// speedup single:   %8.2f \n", tsingle > 0 ? treader/tsingle : 0);
+    std::cout << Form("  /// speedup batch:    %8.2f \n", tbatch > 0 ? treader/tbatch : 0);
+    std::cout << Form("  /// max |diff|:       %g \n", maxdiff);
+    std::cout << Form("  /// mismatches:       %d \n", nmismatch);
+
+    delete reader;
+
+    ///////////////////////////////////////////////////////////////////
+    // FUSED BINARY + MULTICLASS --------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    std::vector< std::shared_ptr<const BDTForest> > forests;
+    forests.push_back(std::make_shared<BDTForest>(forest));
+    std::shared_ptr<BDTForest> multi;
+    if(weightfile_multi != "")
+    {
+        multi = std::make_shared<BDTForest>(weightfile_multi);
+        if(!multi->loaded) return 1;
+        forests.push_back(multi);
+    }
+
+    FusedClassifier fused(forests);
+    if(!fused.built) return 1;
+
+    // the binary forest's variables come first in the fused inputs, the values of the
+    // variables that only the multiclass forest uses are drawn from its training ranges
+    unsigned int nfused = fused.nvars;
+    std::vector<float> xf(nevents*nfused);
+    std::vector<TString> mmins, mmaxs;
+    if(multi)
+    {
+        TMVATools::getNames(weightfile_multi, "Variable", "Min", mmins);
+        TMVATools::getNames(weightfile_multi, "Variable", "Max", mmaxs);
+    }
+    for(int i=0; i<nevents; i++)
+    {
+        for(unsigned int v=0; v<nvars; v++)
+            xf[i*nfused+v] = x[i*nvars+v];
+        for(unsigned int v=nvars; v<nfused; v++)
+        {
+            unsigned int m = std::find(multi->varnames.begin(), multi->varnames.end(), fused.varnames[v]) - multi->varnames.begin();
+            xf[i*nfused+v] = r.Uniform(mmins[m].Atof(), mmaxs[m].Atof());
+        }
+    }
+
+    // inputs of the multiclass forest in its own order
+    unsigned int nmulti = multi ? multi->nvars : 0;
+    unsigned int nclasses = multi ? multi->nclasses : 0;
+    std::vector<float> xm(nevents*nmulti);
+    for(unsigned int v=0; v<nmulti; v++)
+    {
+        unsigned int f = std::find(fused.varnames.begin(), fused.varnames.end(), multi->varnames[v]) - fused.varnames.begin();
+        for(int i=0; i<nevents; i++)
+            xm[i*nmulti+v] = xf[i*nfused+f];
+    }
+
+    std::vector<float> separate(nevents*(1+nclasses)), together(nevents*fused.noutputs);
+
+    timer.Start();
+    for(int i=0; i<nevents; i++)
+    {
+        separate[i*(1+nclasses)] = forest.evaluate(&x[i*nvars]);
+        if(multi) multi->evaluateMulticlass(&xm[i*nmulti], &separate[i*(1+nclasses)+1]);
+    }
+    timer.Stop();
+    double tseparate = timer.RealTime();
+
+    timer.Start();
+    for(int i=0; i<nevents; i++)
+        fused.evaluate(&xf[i*nfused], &together[i*fused.noutputs]);
+    timer.Stop();
+    double tfused = timer.RealTime();
+
+    int nmismatchFused = 0;
+    double maxdiffFused = 0;
+    for(int i=0; i<nevents; i++)
+    {
+        for(unsigned int o=0; o<1+nclasses; o++)
+        {
+            double d = TMath::Abs(separate[i*(1+nclasses)+o] - together[i*fused.noutputs+o]);
+            if(d > maxdiffFused) maxdiffFused = d;
+            if(d > tolerance) nmismatchFused++;
+        }
+    }
+
+    // the multiclass forest against TMVA
+    if(multi)
+    {
+        if(methodName_multi == "") methodName_multi = multi->methodName;
+        std::map<TString, Float_t> tmapMulti;
+        std::map<TString, Float_t> smapMulti;
+        TMVA::Reader* readerMulti = TMVATools::bookVars(methodName_multi, weightfile_multi, tmapMulti, smapMulti);
+
+        std::vector<float> referenceMulti(nevents*nclasses);
+        timer.Start();
+        for(int i=0; i<nevents; i++)
+        {
+            for(unsigned int v=0; v<nmulti; v++)
+                tmapMulti[multi->varnames[v]] = xm[i*nmulti+v];
+            const std::vector<float>& scores = readerMulti->EvaluateMulticlass(methodName_multi);
+            for(unsigned int c=0; c<nclasses && c<scores.size(); c++)
+                referenceMulti[i*nclasses+c] = scores[c];
+        }
+        timer.Stop();
+        double treaderMulti = timer.RealTime();
+
+        int nmismatchMulti = 0;
+        double maxdiffMulti = 0;
+        for(int i=0; i<nevents; i++)
+        {
+            for(unsigned int c=0; c<nclasses; c++)
+            {
+                double d = TMath::Abs(referenceMulti[i*nclasses+c] - separate[i*(1+nclasses)+1+c]);
+                if(d > maxdiffMulti) maxdiffMulti = d;
+                if(d > tolerance) nmismatchMulti++;
+            }
+        }
+
+        std::cout << std::endl;
+        std::cout << Form("  /// %s: %d trees, %d classes \n", multi->methodName.Data(), multi->ntrees(), nclasses);
+        std::cout << Form("  /// Reader multiclass: %8.3f s, %8.1f ns/event \n", treaderMulti, 1e9*treaderMulti/nevents);
+        std::cout << Form("  /// max |diff|:        %g \n", maxdiffMulti);
+        std::cout << Form("  /// mismatches:        %d \n", nmismatchMulti);
+        nmismatch += nmismatchMulti;
+
+        delete readerMulti;
+    }
+
+    std::cout << std::endl;
+    std::cout << Form("  /// fused forests:    %d, %d outputs, %d inputs \n", (int)forests.size(), fused.noutputs, fused.nvars);
+    std::cout << Form("  /// separate:         %8.3f s, %8.1f ns/event \n", tseparate, 1e9*tseparate/nevents);
+    std::cout << Form("  /// fused:            %8.3f s, %8.1f ns/event \n", tfused, 1e9*tfused/nevents);
+    std::cout << Form("  /// speedup fused:    %8.2f \n", tfused > 0 ? tseparate/tfused : 0);
+    std::cout << Form("  /// max |diff|:       %g \n", maxdiffFused);
+    std::cout << Form("  /// mismatches:       %d \n", nmismatchFused);
+    nmismatch += nmismatchFused;
+
+    return nmismatch == 0 ? 0 : 1;
+}
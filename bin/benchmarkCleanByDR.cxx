@@ -0,0 +1,141 @@
+/////////////////////////////////////////////////////////////////////////////
+//                           benchmarkCleanByDR.cxx                        //
+//=========================================================================//
+//                                                                         //
+// Microbenchmark for CollectionCleaner::cleanByDR. Generates random       //
+// jet/muon/electron-like collections, cleans them with the old erase      //
+// based DeltaR loop and with the current mark-and-compact dR^2 kernel,    //
+// checks that both give the same collections and outputs the timing.     //
+//                                                                         //
+// Set MAIN=benchmarkCleanByDR in the makefile then run via                //
+// ./benchmarkCleanByDR <nevents>                                          //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+#include "CollectionCleaner.hxx"
+
+#include "TLorentzVector.h"
+#include "TStopwatch.h"
+#include "TRandom3.h"
+#include "TMath.h"
+
+#include <sstream>
+#include <vector>
+#include <iostream>
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+void legacyCleanByDR(std::vector<TLorentzVector>& cleanThis, std::vector<TLorentzVector>& fromThis, float dRmin)
+{
+// the original implementation, kept here as the reference
+    for(unsigned int i=0; i<fromThis.size(); i++)
+    {
+        for(unsigned int j=0; j<cleanThis.size(); j++)
+        {
+            if(cleanThis[j].DeltaR(fromThis[i]) < dRmin)
+            {
+                cleanThis.erase(cleanThis.begin()+j);
+                j--;
+            }
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+void fillCollection(TRandom3& r, std::vector<TLorentzVector>& v, int n, float etamax, std::vector<TLorentzVector>* near=0)
+{
+// random objects, some of them placed right on top of an object in near
+// so that the cleaning actually has something to remove
+    v.clear();
+    for(int i=0; i<n; i++)
+    {
+        TLorentzVector p;
+        if(near && near->size() > 0 && r.Rndm() < 0.3)
+        {
+            TLorentzVector& q = near->at(r.Integer(near->size()));
+            p.SetPtEtaPhiM(r.Uniform(10, 200), q.Eta() + r.Gaus(0, 0.2), q.Phi() + r.Gaus(0, 0.2), r.Uniform(0, 20));
+        }
+        else
+            p.SetPtEtaPhiM(r.Uniform(10, 200), r.Uniform(-etamax, etamax), r.Uniform(-TMath::Pi(), TMath::Pi()), r.Uniform(0, 20));
+        v.push_back(p);
+    }
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+    int nevents = 200000;
+    float dRmin = 0.4;
+
+    for(int i=1; i<argc; i++)
+    {
+        std::stringstream ss;
+        ss << argv[i];
+        ss >> nevents;
+    }
+
+    // generate the events up front so that only the cleaning is timed
+    TRandom3 r(42);
+    std::vector< std::vector<TLorentzVector> > muons(nevents), electrons(nevents), jets(nevents);
+    for(int i=0; i<nevents; i++)
+    {
+        fillCollection(r, muons[i], 2 + r.Poisson(0.3), 2.4);
+        fillCollection(r, electrons[i], r.Poisson(0.5), 2.5, &muons[i]);
+        fillCollection(r, jets[i], r.Poisson(4), 4.7, &muons[i]);
+    }
+
+    // same cleaning sequence as categorize: jets and electrons from muons, then jets from electrons
+    auto runCleaning = [&](bool legacy, std::vector< std::vector<TLorentzVector> >& outjets,
+                           std::vector< std::vector<TLorentzVector> >& outelectrons)
+    {
+        outjets = jets;
+        outelectrons = electrons;
+        TStopwatch timer;
+        timer.Start();
+        for(int i=0; i<nevents; i++)
+        {
+            if(legacy)
+            {
+                legacyCleanByDR(outjets[i], muons[i], dRmin);
+                legacyCleanByDR(outelectrons[i], muons[i], dRmin);
+                legacyCleanByDR(outjets[i], outelectrons[i], dRmin);
+            }
+            else
+            {
+                CollectionCleaner::cleanByDR(outjets[i], muons[i], dRmin);
+                CollectionCleaner::cleanByDR(outelectrons[i], muons[i], dRmin);
+                CollectionCleaner::cleanByDR(outjets[i], outelectrons[i], dRmin);
+            }
+        }
+        timer.Stop();
+        return timer.RealTime();
+    };
+
+    std::vector< std::vector<TLorentzVector> > legacyJets, legacyElectrons, newJets, newElectrons;
+    double tlegacy = runCleaning(true, legacyJets, legacyElectrons);
+    double tnew    = runCleaning(false, newJets, newElectrons);
+
+    // the two implementations should remove exactly the same objects
+    int nmismatch = 0;
+    for(int i=0; i<nevents; i++)
+    {
+        if(legacyJets[i] != newJets[i] || legacyElectrons[i] != newElectrons[i])
+            nmismatch++;
+    }
+
+    std::cout << Form("  /// nevents:        %d \n", nevents);
+    std::cout << Form("  /// legacy cleaning: %8.3f s, %8.1f ns/event \n", tlegacy, 1e9*tlegacy/nevents);
+    std::cout << Form("  /// dR^2 cleaning:   %8.3f s, %8.1f ns/event \n", tnew, 1e9*tnew/nevents);
+    std::cout << Form("  /// speedup:         %8.2f \n", tnew > 0 ? tlegacy/tnew : 0);
+    std::cout << Form("  /// mismatches:      %d \n", nmismatch);
+
+    return nmismatch == 0 ? 0 : 1;
+}
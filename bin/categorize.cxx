@@ -18,6 +18,14 @@
 #include "JetCollectionCleaner.h"
 #include "MuonCollectionCleaner.h"
 #include "EleCollectionCleaner.h"
+#include "FusedCollectionCleaner.h"
+#include "FillPlan.hxx"
+#include "MassRecord.hxx"
+#include "PlotWorkers.hxx"
+#include "CompletionQueue.hxx"
+#include "HistBundle.hxx"
+#include "ResultCache.hxx"
+#include "AutoBinning.hxx"
 
 #include "EventTools.h"
 #include "TMVATools.h"
@@ -36,6 +44,8 @@
 #include "TSystem.h"
 #include "TBranchElement.h"
 #include "TROOT.h"
+#include "TObjArray.h"
+#include "TObjString.h"
 //#include "TStreamerInfo.h"
 
 //////////////////////////////////////////////////////////////////
@@ -54,9 +64,11 @@ struct Settings
     
     bool rebin = true;        // rebin the ratio plots so that each point has small errors
     int nthreads = 20;        // number of threads to use in parallelization
+    int plotWorkers = 4;      // number of forked processes drawing the stacks, 0 to draw them in this process
     bool fitratio = 0;        // fit the ratio plot (data/mc) under the stack w/ a straight line
     
     TString xmlfile;          // filename for the xmlcategorizer, if you chose to use one 
+    TString plugin;           // name of a categorizer plugin from generateCategorizer, used instead of the xmlfile
 
     float luminosity = 36814;                // pb-1
     float reductionFactor = 1;               // reduce the number of events you run over in case you want to debug or some such thing
@@ -70,6 +82,20 @@ struct Settings
 
     float subleadPt = 20;     // subleading muon pt cut
     bool sig_xlumi = true;    // if true, scale signal by xsec*lumi
+
+    TString scoreCache = "rootfiles/score_cache/";   // where to keep the classifier scores between runs, "" to always recompute
+    bool multiclass = false;                         // also set the multiclass scores, bdt_ggh_out ... bdt_top_out
+    TString resultCache = "rootfiles/result_cache/"; // where to keep the unscaled fills of each sample between runs, "" to always rerun
+
+    TString cube = "";        // ResultCube file to add every category x sample x variable of the run to, "" for none
+    TString cubeVars = "";    // more variables for the cube, "name:bins:min:max name:bins:min:max ..."
+
+    TString massRecord = "";  // MassRecord file for the unbinned masses of each category x sample x systematic, "" for none
+    int bundle = 0;           // also save the histos to a .hbnd HistBundle next to the .root file, 1 raw, 2 compressed
+
+    int autoBinning = 0;      // range and bins from the values in the same pass, 1 equal width, 2 equal statistics, 0 to use initPlotSettings
+    int autoBins = 0;         // number of bins for the auto binning, 0 for the initPlotSettings number
+    double autoTail = 0.001;  // fraction of the expected yield the auto binning leaves out of the range on each side
 };
 
 //////////////////////////////////////////////////////////////////
@@ -293,7 +319,7 @@ void initPlotSettings(Settings& settings)
 //---------------------------------------------------------------
 //////////////////////////////////////////////////////////////////
 
-Categorizer* plotWithSystematic(TString systematic, Settings& settings)
+Categorizer* plotWithSystematic(TString systematic, Settings& settings, ResultCube* cube, MassRecord* massRecord, AutoBinning* autoBinning)
 {
     gROOT->SetBatch();
 
@@ -301,6 +327,10 @@ Categorizer* plotWithSystematic(TString systematic, Settings& settings)
     // the number used to fill originally rather than the scaling
     TH1::SetDefaultSumw2();
 
+    // the histograms are booked in the threads, keep them out of gDirectory, which isn't thread safe.
+    // They are saved through the lists below.
+    TH1::AddDirectory(kFALSE);
+
     // Use this as the main database and choose from it to make the vector
     std::map<TString, Sample*> samples;
 
@@ -355,6 +385,8 @@ Categorizer* plotWithSystematic(TString systematic, Settings& settings)
     ///////////////////////////////////////////////////////////////////
 
     // set nbins, min, max, and var to plot based upon input from the terminal: varNumber and settings.binning
+    // with auto binning the histos are booked with this binning too, the cube keeps it for every
+    // systematic and the histos are remade with the binning the first systematic settled on
     initPlotSettings(settings);
 
     std::cout << "@@@ nCPUs Available: " << getNumCPUs() << std::endl;
@@ -364,6 +396,7 @@ Categorizer* plotWithSystematic(TString systematic, Settings& settings)
     // print out settings.xmlfilename if using xmlcategorizer otherwise print out 1 or 2
     TString categoryString = Form("%d", settings.whichCategories);
     if(settings.whichCategories == 3) categoryString = settings.xmlfile;
+    if(settings.whichCategories == 3 && settings.plugin != "") categoryString = "plugins/lib"+settings.plugin+".so";
 
     std::cout << std::endl;
     std::cout << "======== Plot Configs ========" << std::endl;
@@ -374,6 +407,7 @@ Categorizer* plotWithSystematic(TString systematic, Settings& settings)
     std::cout << "max            : " << settings.max << std::endl;
     std::cout << "bins           : " << settings.bins << std::endl;
     std::cout << "binning        : " << settings.binning << std::endl;
+    std::cout << "auto binning   : " << settings.autoBinning << std::endl;
     std::cout << "sig xlumi      : " << settings.sig_xlumi << std::endl;
     std::cout << "reductionFactor: " << settings.reductionFactor << std::endl;
     std::cout << "whichDY        : " << settings.whichDY << std::endl;
@@ -386,7 +420,70 @@ Categorizer* plotWithSystematic(TString systematic, Settings& settings)
     // Define Task for Parallelization -------------------------------
     ///////////////////////////////////////////////////////////////////
 
-    auto makeHistoForSample = [settings, systematic](Sample* s)
+    /////////////////////////////////////////////////////
+    // Load TMVA classifiers, once for all of the samples and systematics
+
+    TString dir    = "classification/";
+    //TString methodName = "BDTG_default";
+    TString methodName = "BDTG_UF_v1";
+
+    // sig vs bkg and multiclass (ggf, vbf, ... drell yan, ttbar) weight files
+    TString weightfile = dir+"f_Opt_v1_all_sig_all_bkg_ge0j_BDTG_UF_v1.weights.xml";
+    //TString weightfile = dir+"binaryclass_amc.weights.xml";
+    TString weightfile_multi = dir+"f_Opt_v1_multi_all_sig_all_bkg_ge0j_BDTG_UF_v1.weights.xml";
+
+    // the forests are read only after loading, so all of the threads share them.
+    // With the multiclass scores the binary and the multiclass forests are evaluated together.
+    std::shared_ptr<const BDTForest> classifier;
+    std::shared_ptr<const FusedClassifier> classifier_fused;
+    if(settings.whichCategories >= 2)
+    {
+        classifier = TMVATools::getClassifier(weightfile);
+        if(!classifier) return 0;
+    }
+    if(settings.whichCategories >= 2 && settings.multiclass)
+    {
+        classifier_fused = TMVATools::getFusedClassifier({weightfile, weightfile_multi});
+        if(!classifier_fused) return 0;
+    }
+
+    // make sure the categorizer plugin loads before the threads each load it
+    if(settings.whichCategories == 3 && settings.plugin != "")
+    {
+        Categorizer* test = loadCategorizerPlugin(settings.plugin);
+        if(test == 0) return 0;
+        delete test;
+    }
+
+    // Everything the fills of every sample depend on, the executable stands in for the code version and
+    // the compiled in parameters. The samples add their own inputs and selection to this, see ResultCache.hxx.
+    ResultKey runKey;
+    if(settings.resultCache != "")
+    {
+        runKey.addFileContents("/proc/self/exe");
+        runKey.add(systematic.Data());
+        runKey.add(settings.varname.Data());
+        runKey.add((double)settings.bins);
+        runKey.add(settings.min);
+        runKey.add(settings.max);
+        runKey.add((double)settings.binning);
+        runKey.add((double)settings.whichCategories);
+        runKey.add(settings.subleadPt);
+        runKey.add(settings.reductionFactor);
+        runKey.add((double)settings.multiclass);
+        runKey.add(settings.cubeVars.Data());
+        if(settings.whichCategories == 3 && settings.plugin != "") runKey.addFileContents(("plugins/lib"+settings.plugin+".so").Data());
+        else if(settings.whichCategories == 3) runKey.addFileContents(settings.xmlfile.Data());
+        if(settings.whichCategories >= 2) runKey.addFileContents(weightfile.Data());
+        if(settings.whichCategories >= 2 && settings.multiclass) runKey.addFileContents(weightfile_multi.Data());
+    }
+
+    // the weights file is hashed once per process for the names of the score caches
+    unsigned long long weightsHash = 0;
+    if(settings.whichCategories >= 2 && !settings.multiclass && settings.scoreCache != "")
+        weightsHash = ScoreCache::hashWeights(weightfile.Data());
+
+    auto makeHistoForSample = [settings, systematic, classifier, classifier_fused, weightfile, weightsHash, cube, massRecord, autoBinning, runKey](Sample* s)
     {
 
       // info to check that this event is different than the last event
@@ -407,36 +504,9 @@ Categorizer* plotWithSystematic(TString systematic, Settings& settings)
       }
 
 
-      /////////////////////////////////////////////////////
-      // Load TMVA classifiers
-     
-      TString dir    = "classification/";
-      //TString methodName = "BDTG_default";
-      TString methodName = "BDTG_UF_v1";
-
-
-      // sig vs bkg and multiclass (ggf, vbf, ... drell yan, ttbar) weight files
-      TString weightfile = dir+"f_Opt_v1_all_sig_all_bkg_ge0j_BDTG_UF_v1.weights.xml";
-      //TString weightfile = dir+"binaryclass_amc.weights.xml";
-      TString weightfile_multi = dir+"f_Opt_v1_multi_all_sig_all_bkg_ge0j_BDTG_UF_v1.weights.xml";
-
-      /////////////////////////////////////////////////////
-      // Book training and spectator vars into reader
-
-      TMVA::Reader* reader = 0;
-      std::map<TString, Float_t> tmap;
-      std::map<TString, Float_t> smap;
-
-      //TMVA::Reader* reader_multi = 0;
-      //std::map<TString, Float_t> tmap_multi;
-      //std::map<TString, Float_t> smap_multi;
-
-      // load tmva binary classification and multiclass classifiers
-      if(settings.whichCategories >= 2)
-      {
-          reader       = TMVATools::bookVars(methodName, weightfile, tmap, smap);
-          //reader_multi = TMVATools::bookVars(methodName, weightfile_multi, tmap_multi, smap_multi);
-      }
+      // per thread classifier inputs, resolved to VarSet handles on the first event
+      ClassifierInputs bdtInputs;
+      ClassifierInputs bdtInputs_fused;
 
       ///////////////////////////////////////////////////////////////////
       // INIT Cuts and Categories ---------------------------------------
@@ -447,6 +517,10 @@ Categorizer* plotWithSystematic(TString systematic, Settings& settings)
       MuonCollectionCleaner     muonCollectionCleaner;
       EleCollectionCleaner      eleCollectionCleaner;
 
+      // muons, electrons, jets selected and cleaned from each other in one pass,
+      // configured from the cleaners above with dR = 0.4
+      FusedCollectionCleaner    fusedCollectionCleaner(jetCollectionCleaner, muonCollectionCleaner, eleCollectionCleaner, 0.4);
+
       Run2MuonSelectionCuts  run2MuonSelection;
       Run2EventSelectionCuts run2EventSelection;
       run2MuonSelection.cMinPt = settings.subleadPt; 
@@ -455,6 +529,8 @@ Categorizer* plotWithSystematic(TString systematic, Settings& settings)
 
       if(settings.whichCategories == 1) categorySelection = new CategorySelectionRun1();                  // run1 categories
       else if(settings.whichCategories == 2) categorySelection = new CategorySelectionBDT();              // run2 categories
+      else if(settings.whichCategories == 3 && settings.plugin != "")
+          categorySelection = loadCategorizerPlugin(settings.plugin);                                     // XML compiled to code
       else if(settings.whichCategories == 3 && settings.xmlfile.Contains("hybrid")) 
           categorySelection = new CategorySelectionHybrid(settings.xmlfile);                              // XML + object cuts
       else if(settings.whichCategories == 3) categorySelection = new XMLCategorizer(settings.xmlfile);    // XML only
@@ -471,6 +547,12 @@ Categorizer* plotWithSystematic(TString systematic, Settings& settings)
       else if(settings.varname.Contains("Roch")) pf_roch_or_kamu = "Roch";
       else if(settings.varname.Contains("KaMu")) pf_roch_or_kamu = "KaMu";
 
+      // classifier scores from earlier runs with the same weights file, calibration, and systematic
+      ScoreCache scoreCache;
+      // only the binary score is cached
+      bool useScoreCache = settings.whichCategories >= 2 && !settings.multiclass && settings.scoreCache != "" &&
+                           scoreCache.open(settings.scoreCache.Data(), s->name.Data(), weightsHash, pf_roch_or_kamu.Data(), systematic.Data());
+
       ///////////////////////////////////////////////////////////////////
       // INIT HISTOGRAMS TO FILL ----------------------------------------
       ///////////////////////////////////////////////////////////////////
@@ -497,13 +579,71 @@ Categorizer* plotWithSystematic(TString systematic, Settings& settings)
 
       }
 
+      // resolve the category x variable histograms and the variable once, before the event loop
+      // with auto binning the variable also fills a fine grid per category, the histograms are remade
+      // from the grids once all of the samples are done, the later systematics fill the binning the
+      // first one decided. The cube keeps the initPlotSettings binning.
+      FillPlan fillPlan;
+      fillPlan.autoBinning = autoBinning != 0;
+      if(autoBinning) fillPlan.autoGrid = autoBinning->makeGrid();
+      fillPlan.addVariable(settings.varname, hkey);
+      if(cube)
+      {
+          // name:bins:min:max
+          TString tok;
+          Ssiz_t from = 0;
+          while(settings.cubeVars.Tokenize(tok, from, " "))
+          {
+              TObjArray* fields = tok.Tokenize(":");
+              if(fields->GetEntries() == 4)
+                  fillPlan.addVariable(((TObjString*)fields->At(0))->GetString(), ((TObjString*)fields->At(1))->GetString().Atoi(),
+                                       ((TObjString*)fields->At(2))->GetString().Atof(), ((TObjString*)fields->At(3))->GetString().Atof());
+              else
+                  std::cout << Form("  !!! cube variable %s is not name:bins:min:max \n", tok.Data());
+              delete fields;
+          }
+      }
+      fillPlan.build(*categorySelection, s->vars);
+
+      // unbinned masses of the sample, one row per event and category
+      MassColumns massColumns;
+
+      // the fills of an earlier run with the same inputs, the unbinned masses and the auto binning grids aren't cached
+      ResultKey resultKey = runKey;
+      bool useResultCache = settings.resultCache != "" && !massRecord && !autoBinning;
+      bool cached = false;
+      if(useResultCache)
+      {
+          resultKey.add(s->name.Data());
+          for(auto& f: s->filenames) resultKey.addFileIdentity(f.Data());
+          for(Cut* cut: std::vector<Cut*>{&run2EventSelection, &run2MuonSelection})
+          {
+              for(auto& c: cut->cutset.cuts)
+              {
+                  resultKey.add(c.name.Data());
+                  resultKey.add((double)c.on);
+                  if(c.cutvalue) resultKey.add(*c.cutvalue);
+              }
+          }
+          for(double p: {fusedCollectionCleaner.cMuonSelectionPtMin, fusedCollectionCleaner.cMuonSelectionEtaMax, fusedCollectionCleaner.cMuonSelectionIsoMax,
+                         (float)fusedCollectionCleaner.cMuonSelectionID, (float)fusedCollectionCleaner.cUseMedium2016,
+                         fusedCollectionCleaner.cElectronSelectionPtMin, fusedCollectionCleaner.cElectronSelectionEtaMax, fusedCollectionCleaner.cElectronSelectionIsoMax,
+                         (float)fusedCollectionCleaner.cElectronSelectionID, fusedCollectionCleaner.cJetSelectionPtMin, fusedCollectionCleaner.cJetSelectionEtaMax,
+                         fusedCollectionCleaner.cJetSelectionBTagMin, fusedCollectionCleaner.cJetSelectionBJetEtaMax, fusedCollectionCleaner.cOverlapdRMin,
+                         (float)fusedCollectionCleaner.cCleanJetsFromElectrons, (float)fusedCollectionCleaner.cCleanBJetsFromLeptons})
+              resultKey.add(p);
+
+          cached = ResultCache::load(settings.resultCache.Data(), s->name.Data(), resultKey, fillPlan.accumulators);
+          if(cached) std::cout << Form("  /// %s: fills from the result cache %s \n", s->name.Data(), resultKey.hex().c_str());
+      }
+
 
       ///////////////////////////////////////////////////////////////////
       // LOOP OVER EVENTS -----------------------------------------------
       ///////////////////////////////////////////////////////////////////
 
       // Sift the events into the different categories and fill the histograms for each sample x category
-      for(unsigned int i=0; i<s->N/settings.reductionFactor; i++)
+      for(unsigned int i=0; !cached && i<s->N/settings.reductionFactor; i++)
       {
         // We are stitching together zjets_ht from 70-inf. We use the inclusive for
         // ht from 0-70, using the inclusive for 70 and beyond would double count.
@@ -610,22 +750,9 @@ Categorizer* plotWithSystematic(TString systematic, Settings& settings)
           s->branches.getEntry(i);
           s->vars.setCalibrationType(pf_roch_or_kamu); // reloaded the branches, need to set mass,pt to correct calibrations again
 
-          // clear vectors for the valid collections
-          s->vars.validMuons.clear();
-          s->vars.validExtraMuons.clear();
-          s->vars.validElectrons.clear();
-          s->vars.validJets.clear();
-          s->vars.validBJets.clear();
-
-          // load valid collections from s->vars raw collections
-          jetCollectionCleaner.getValidJets(s->vars, s->vars.validJets, s->vars.validBJets);
-          muonCollectionCleaner.getValidMuons(s->vars, s->vars.validMuons, s->vars.validExtraMuons);
-          eleCollectionCleaner.getValidElectrons(s->vars, s->vars.validElectrons);
-
+          // load valid collections from s->vars raw collections.
           // Clean jets and electrons from muons, then clean remaining jets from remaining electrons
-          CollectionCleaner::cleanByDR(s->vars.validJets, s->vars.validMuons, 0.4);
-          CollectionCleaner::cleanByDR(s->vars.validElectrons, s->vars.validMuons, 0.4);
-          CollectionCleaner::cleanByDR(s->vars.validJets, s->vars.validElectrons, 0.4);
+          fusedCollectionCleaner.getValidCollections(s->vars);
 
           //std::pair<int,int> e(s->vars.eventInfo.run, s->vars.eventInfo.event); // create a pair that identifies the event uniquely
 
@@ -640,49 +767,34 @@ Categorizer* plotWithSystematic(TString systematic, Settings& settings)
 
               //std::cout << i << " !!! SETTING JETS " << std::endl;
               //s->vars.setJets();    // jets sorted and paired by mjj, turn this off to simply take the leading two jets
-              s->vars.bdt_out = TMVATools::getClassifierScore(reader, methodName, tmap, s->vars); // set tmva's bdt score
-
-              // load multi results into varset
-              //std::vector<float> bdt_multi_scores = TMVATools::getMulticlassScores(reader_multi, methodName, tmap_multi, s->vars);
-              //s->vars.bdt_ggh_out = bdt_multi_scores[0];
-              //s->vars.bdt_vbf_out = bdt_multi_scores[1];
-              //s->vars.bdt_vh_out  = bdt_multi_scores[2];
-              //s->vars.bdt_ewk_out = bdt_multi_scores[3];
-              //s->vars.bdt_top_out = bdt_multi_scores[4];
-          }
-
-          // Figure out which category the event belongs to
-          categorySelection->evaluate(s->vars);
-
-          // Look at each category, if the event belongs to that category fill the histogram for the sample x category
-          for(auto &c : categorySelection->categoryMap)
-          {
-              // skip categories that we decided to hide (usually some intermediate categories)
-              if(c.second.hide) continue;
-              if(!c.second.inCategory) continue;
-
-              ///////////////////////////////////////////////////////////////////
-              // FILL HISTOGRAMS FOR REQUESTED VARIABLE -------------------------
-              ///////////////////////////////////////////////////////////////////
-
-              // now that we have a lot of these in the VarSet map we should just fill the s->vars.getValue("varName")
-              // would save a lot of explicit code here ...
-
-              if(settings.varname.Contains("dimu_mass")) 
+              if(classifier_fused)
               {
-                  if(isData && dimu.mass > 120 && dimu.mass < 130 && isblinded) continue; // blind signal region
-
-                  // if the event is in the current category then fill the category's histogram for the given sample and variable
-                  c.second.histoMap[hkey]->Fill(s->vars.getValue(settings.varname.Data()), s->getWeight());
-                  //std::cout << "    " << c.first << ": " << varvalue;
-                  continue;
+                  // binary and multiclass scores from one pass over the inputs, sets bdt_out and bdt_ggh_out ... bdt_top_out
+                  TMVATools::setClassifierScores(*classifier_fused, bdtInputs_fused, s->vars);
               }
               else
               {
-                  c.second.histoMap[hkey]->Fill(s->vars.getValue(settings.varname.Data()), s->getWeight());
+                  int candidate = &dimu - &s->vars.muPairs->at(0);
+                  s->vars.bdt_out = TMVATools::getClassifierScore(*classifier, bdtInputs, s->vars, // set tmva's bdt score
+                                                                  useScoreCache?&scoreCache:0, i, candidate);
               }
+          }
+
+          // Figure out which category the event belongs to
+          categorySelection->evaluate(s->vars);
 
-          } // end category loop
+          // Fill the histograms of the categories the event is in for the sample x category,
+          // the weight and the blinding are worked out once for the event
+          double weight = isData?1.0:s->getWeight();
+          bool blindEvent = isData && isblinded && dimu.mass > 120 && dimu.mass < 130; // blind signal region
+          fillPlan.fill(*categorySelection, s->vars, weight, blindEvent);
+
+          if(massRecord && !blindEvent)
+          {
+              for(int id : categorySelection->inIds)
+                  if(!categorySelection->categories[id]->hide)
+                      massColumns.add(id, dimu.mass_PF, dimu.mass_Roch, dimu.mass_KaMu, weight);
+          }
 
           ////////////////////////////////////////////////////////////////////
           // DEBUG ----------------------------------------------------------
@@ -702,15 +814,37 @@ Categorizer* plotWithSystematic(TString systematic, Settings& settings)
         } // end dimu cand loop //
       } // end event loop //
 
-      if(settings.whichCategories >= 2) delete reader;
-      //if(settings.whichCategories >= 2) delete reader_multi;
+      fillPlan.flush();
+      if(useResultCache && !cached) ResultCache::save(settings.resultCache.Data(), s->name.Data(), resultKey, fillPlan.accumulators);
+
+      if(useScoreCache)
+      {
+          std::cout << Form("  /// %s: %lld cached classifier scores, %lld computed \n", s->name.Data(), scoreCache.nhits, scoreCache.nmisses);
+          scoreCache.save();
+      }
 
       // Scale according to settings.luminosity and sample xsec now that the histograms are done being filled for that sample
+      // Only used half of the signal events in this case, need to boost the normalization by 2 to make up for that
+      double scale = s->getLumiScaleFactor(settings.luminosity);
+      if(settings.whichCategories >= 2 && isSignal && settings.binning < 0) scale *= 2;
       for(auto &c : categorySelection->categoryMap)
+          c.second.histoMap[hkey]->Scale(scale);
+
+      // every category x variable of the sample into the cube with the same normalization
+      if(cube) fillPlan.addToCube(*cube, *categorySelection, s->name, s->sampleType, systematic, pf_roch_or_kamu, scale);
+
+      if(autoBinning)
+      {
+          for(int id=0; id<fillPlan.ncategories; id++)
+              if(!categorySelection->categories[id]->hide)
+                  autoBinning->add(categorySelection->categories[id]->name.Data(), s->name.Data(), fillPlan.grids[id], scale);
+      }
+
+      if(massRecord)
       {
-          // Only used half of the signal events in this case, need to boost the normalization by 2 to make up for that
-          if(settings.whichCategories >= 2 && isSignal && settings.binning < 0) c.second.histoMap[hkey]->Scale(2*s->getLumiScaleFactor(settings.luminosity));
-          else c.second.histoMap[hkey]->Scale(s->getLumiScaleFactor(settings.luminosity));
+          std::vector<std::string> categoryNames;
+          for(auto& c: categorySelection->categories) categoryNames.push_back(c->name.Data());
+          massRecord->append(s->name.Data(), s->sampleType.Data(), scale, systematic.Data(), categoryNames, massColumns);
       }
 
       std::cout << Form("  /// Done processing %s \n", s->name.Data());
@@ -723,11 +857,21 @@ Categorizer* plotWithSystematic(TString systematic, Settings& settings)
    // PARALLELIZE BY SAMPLE -----------------------------------------
    ///////////////////////////////////////////////////////////////////
 
+    // declared before the pool so that the pool's threads are joined first
+    CompletionQueue<Categorizer*> completed;
     ThreadPool pool(settings.nthreads);
-    std::vector< std::future<Categorizer*> > results;
 
+    // the tasks delete their samples, keep what the merge needs
+    std::vector<TString> sampleOrder;
+    std::map<TString, TString> sampleTypes;
     for(auto &s : samplevec)
-        results.push_back(pool.enqueue(makeHistoForSample, s));
+    {
+        sampleOrder.push_back(s->name);
+        sampleTypes[s->name] = s->sampleType;
+    }
+
+    for(auto &s : samplevec)
+        completed.enqueue(pool, makeHistoForSample, s);
 
    ///////////////////////////////////////////////////////////////////
    // Gather all the Histos into one Categorizer----------------------
@@ -736,33 +880,79 @@ Categorizer* plotWithSystematic(TString systematic, Settings& settings)
     Categorizer* cAll = 0;
     if(settings.whichCategories == 1) cAll = new CategorySelectionRun1();                            // run1 categories 
     else if(settings.whichCategories == 2) cAll = new CategorySelectionBDT();                        // run2 categories
+    else if(settings.whichCategories == 3 && settings.plugin != "")
+        cAll = loadCategorizerPlugin(settings.plugin);                                               // XML compiled to code
     else if(settings.whichCategories == 3 && settings.xmlfile.Contains("hybrid")) 
         cAll = new CategorySelectionHybrid(settings.xmlfile);                                        // XML + Object cuts
     else if(settings.whichCategories == 3) cAll = new XMLCategorizer(settings.xmlfile);              // XML only
 
-    // get histos from all categorizers and put them into one categorizer
-    for(auto && categorizer: results)  // loop through each Categorizer object, one per sample
+    // take the histos from each sample's categorizer as soon as the sample is done, then free the
+    // categorizer, so only the samples in flight have a categorizer alive
+    while(completed.pending() > 0)
     {
-        int i = 0;
-        for(auto& category: categorizer.get()->categoryMap) // loop through each category for the given sample
+        Categorizer* categorizer = completed.pop();
+        for(auto& category: categorizer->categoryMap)
         {
             // category.first is the category name, category.second is the Category object
-            if(category.second.hide) continue;
-            for(auto& h: category.second.histoMap) // loop through each histogram in this category's histo map
+            // we defined hkey = h.first as the sample name earlier so we have
+            // our histomap : category.histoMap<samplename, TH1D*>
+            for(auto& h: category.second.histoMap)
             {
-                // std::cout << Form("%s: %f", h.first.Data(), h.second->Integral()) << std::endl;
-                // we defined hkey = h.first as the sample name earlier so we have 
-                // our histomap : category.histoMap<samplename, TH1D*>
-                Sample* s = samples[h.first];
+                if(category.second.hide) delete h.second;   // intermediate categories aren't saved
+                else cAll->categoryMap[category.first].histoMap[h.first] = h.second;
+            }
 
-                cAll->categoryMap[category.first].histoMap[h.first] = h.second;
-                cAll->categoryMap[category.first].histoList->Add(h.second);
+            // the lists don't own the histos
+            delete category.second.histoList;
+            delete category.second.signalList;
+            delete category.second.bkgList;
+            delete category.second.dataList;
+        }
+        delete categorizer;
+    }
 
-                if(s->sampleType.EqualTo("signal"))          cAll->categoryMap[category.first].signalList->Add(h.second);
-                else if(s->sampleType.EqualTo("background")) cAll->categoryMap[category.first].bkgList->Add(h.second);
-                else                                         cAll->categoryMap[category.first].dataList->Add(h.second);
+    // all of the samples are in, settle the binning and remake the histos with it
+    if(autoBinning)
+    {
+        const HistAccumulator& binning = autoBinning->decide();
+        for(auto& category: cAll->categoryMap)
+        {
+            if(category.second.hide) continue;
+            for(auto& h: category.second.histoMap)
+            {
+                TH1D* hauto = autoBinning->makeTH1D(category.second.name.Data(), h.first.Data(), h.second->GetName(), h.second->GetTitle());
+                if(hauto == 0) continue;
+                hauto->GetXaxis()->SetTitle(settings.varname);
+                delete h.second;
+                h.second = hauto;
             }
         }
+        autoBinning->clear();
+
+        if(binning.nbins > 0)
+        {
+            settings.bins = binning.nbins;
+            settings.min = binning.min;
+            settings.max = binning.max;
+            std::cout << Form("  /// auto binning: %d %s bins in [%g, %g] \n", binning.nbins, binning.edges.empty()?"equal width":"equal statistics",
+                              binning.min, binning.max);
+        }
+    }
+
+    // fill the lists in the sample order, by xsec, for the stack and ratio plot
+    for(auto& category: cAll->categoryMap)
+    {
+        if(category.second.hide) continue;
+        for(auto& name: sampleOrder)
+        {
+            auto h = category.second.histoMap.find(name);
+            if(h == category.second.histoMap.end()) continue;
+
+            category.second.histoList->Add(h->second);
+            if(sampleTypes[name].EqualTo("signal"))          category.second.signalList->Add(h->second);
+            else if(sampleTypes[name].EqualTo("background")) category.second.bkgList->Add(h->second);
+            else                                             category.second.dataList->Add(h->second);
+        }
     }
 
     return cAll;
@@ -801,6 +991,11 @@ int main(int argc, char* argv[])
             else
                 ss >> settings.whichCategories;
         }
+        else if(option=="plugin")
+        {
+            settings.plugin = value;
+            settings.whichCategories = 3;
+        }
         else if(option=="var")             settings.varname = value;
         else if(option=="binning")         ss >> settings.binning;
         else if(option=="nthreads")        ss >> settings.nthreads;
@@ -811,6 +1006,17 @@ int main(int argc, char* argv[])
         else if(option=="subleadPt")       ss >> settings.subleadPt;
         else if(option=="whichDY")         settings.whichDY = value;
         else if(option=="sig_xlumi")       ss >> settings.sig_xlumi;
+        else if(option=="scoreCache")      settings.scoreCache = value;
+        else if(option=="multiclass")      ss >> settings.multiclass;
+        else if(option=="resultCache")     settings.resultCache = value;
+        else if(option=="cube")            settings.cube = value;
+        else if(option=="cubeVars")        settings.cubeVars = value;
+        else if(option=="massRecord")      settings.massRecord = value;
+        else if(option=="plotWorkers")     ss >> settings.plotWorkers;
+        else if(option=="bundle")          ss >> settings.bundle;
+        else if(option=="autoBinning")     ss >> settings.autoBinning;
+        else if(option=="autoBins")        ss >> settings.autoBins;
+        else if(option=="autoTail")        ss >> settings.autoTail;
         else if(option=="systematics")
         {
             TString tok;
@@ -841,6 +1047,35 @@ int main(int argc, char* argv[])
     TList* datalist = new TList();       // list to save all of the data histos
     TList* netlist = new TList();        // list to save all of the net histos
 
+    // The stacks are drawn in forked workers as soon as the net histos of a category are done,
+    // while this process goes on with the next category and systematic. Each worker saves its
+    // canvas to a temporary file that is put into the stacks directory at the end.
+    PlotWorkers plotWorkers(settings.plotWorkers);
+    std::vector< std::pair<TString, TString> > stackfiles;   // stackname, temporary file
+
+    // earlier runs for other systematics or calibrations stay in the cube
+    ResultCube cube;
+    if(settings.cube != "" && !gSystem->AccessPathName(settings.cube)) cube.read(settings.cube.Data());
+
+    MassRecord massRecord;
+    massRecord.calibration = "PF";
+    if(settings.varname.Contains("Roch")) massRecord.calibration = "Roch";
+    else if(settings.varname.Contains("KaMu")) massRecord.calibration = "KaMu";
+
+    // the mass has its windows and blinding from settings.binning, the auto binning is for the other variables
+    if(settings.autoBinning > 0 && settings.varname.Contains("dimu_mass"))
+    {
+        std::cout << "  !!! the auto binning isn't used for dimu_mass, use --binning" << std::endl;
+        settings.autoBinning = 0;
+    }
+    AutoBinning autoBinning;
+    autoBinning.mode = settings.autoBinning;
+    autoBinning.tail = settings.autoTail;
+    if(settings.autoBinning > 0)
+    {
+        initPlotSettings(settings);
+        autoBinning.nbins = settings.autoBins > 0 ? settings.autoBins : settings.bins;
+    }
 
     for(auto& systematic: systematics)
     {
@@ -853,7 +1088,9 @@ int main(int argc, char* argv[])
         std::cout << "/////////////////////////////////////////////////////////////////////" << std::endl;
         std::cout << std::endl;
 
-        Categorizer* cAll = plotWithSystematic(systematic, settings);
+        Categorizer* cAll = plotWithSystematic(systematic, settings, settings.cube != ""?&cube:0, settings.massRecord != ""?&massRecord:0,
+                                               settings.autoBinning > 0?&autoBinning:0);
+        if(cAll == 0) return 1;
 
         ///////////////////////////////////////////////////////////////////
         // Gather All of the Histos---------------------------------------
@@ -913,8 +1150,23 @@ int main(int argc, char* argv[])
             //stackedHistogramsAndRatio(TList* list, TString name, TString title, TString xaxistitle, TString yaxistitle, bool settings.rebin = false, bool fit = true,
                                       //TString ratiotitle = "Data/MC", bool log = true, bool stats = false, int legend = 0);
             // stack signal, bkg, and data
-            TCanvas* stack = DiMuPlottingSystem::stackedHistogramsAndRatio(groupedlist, stackname, stackname, settings.varname, "Num Entries", settings.rebin, settings.fitratio);
-            varstacklist->Add(stack);
+            TString stackfile = Form("%s/categorize_%d_%s.root", gSystem->TempDirectory(), (int)getpid(), stackname.Data());
+            TString pngname = "imgs/"+settings.varname+"_"+stackname+"_"+settings.whichDY+Form("_b%d.png", settings.binning);
+            stackfiles.push_back(std::make_pair(stackname, stackfile));
+
+            // the worker gets the histos as they are now, before the signal is unscaled below.
+            // Style them here, the styling in a forked worker wouldn't reach the saved histos.
+            DiMuPlottingSystem::styleStack(groupedlist);
+            plotWorkers.submit([groupedlist, stackname, stackfile, pngname, settings]()
+            {
+                TCanvas* stack = DiMuPlottingSystem::stackedHistogramsAndRatio(groupedlist, stackname, stackname, settings.varname, "Num Entries", settings.rebin, settings.fitratio);
+                stack->SaveAs(pngname);
+
+                TFile f(stackfile, "RECREATE");
+                stack->Write();
+                f.Close();
+                return 0;
+            });
 
             // we scaled by lumi*xsec/n_weighted for the stack comparisons
             // the limit setting needs the signal scaled only by 1/n_weighted
@@ -948,13 +1200,32 @@ int main(int argc, char* argv[])
             netlist->Add(hNetSignal130);
             netlist->Add(hNetBkg);
             netlist->Add(groupedlist);
-           
-            stack->SaveAs("imgs/"+settings.varname+"_"+stackname+"_"+settings.whichDY+Form("_b%d.png", settings.binning));
+
         }
         timerWatch.Stop();
         std::cout << "### DONE " << timerWatch.RealTime() << " seconds" << std::endl;
     }
 
+    ///////////////////////////////////////////////////////////////////
+    // Collect the Stacks ---------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    if(plotWorkers.waitAll() > 0) std::cout << Form("  !!! %d stack plots failed \n", plotWorkers.nfailed);
+
+    std::vector<TFile*> stacktfiles;
+    for(auto& sf: stackfiles)
+    {
+        TFile* f = TFile::Open(sf.second);
+        TCanvas* stack = (f && !f->IsZombie())?(TCanvas*)f->Get(sf.first):0;
+        if(stack == 0)
+        {
+            std::cout << Form("  !!! no stack for %s \n", sf.first.Data());
+            continue;
+        }
+        varstacklist->Add(stack);
+        stacktfiles.push_back(f);
+    }
+
     ///////////////////////////////////////////////////////////////////
     // Save the Histos ------------------------------------------------
     ///////////////////////////////////////////////////////////////////
@@ -1008,6 +1279,44 @@ int main(int argc, char* argv[])
     netlist->Write();
 
     savefile->Close();
+
+    for(auto& f: stacktfiles) f->Close();
+
+    // same histos and directories without the stacks, for fast reading in the fitters
+    if(settings.bundle > 0)
+    {
+        TString bundlename = savename;
+        bundlename.ReplaceAll(".root", ".hbnd");
+        std::cout << "  /// Saving the histos to " << bundlename << " ..." << std::endl;
+
+        HistBundle bundle;
+        bundle.compress = settings.bundle == 2;
+        bundle.addList("signal_histos", signallist);
+        bundle.addList("bg_histos", bglist);
+        bundle.addList("data_histos", datalist);
+        bundle.addList("net_histos", netlist);
+        bundle.write(bundlename.Data());
+    }
+    for(auto& sf: stackfiles) gSystem->Unlink(sf.second);
+
+    if(settings.cube != "")
+    {
+        // queryCube unscales the signal like above when sig_xlumi is false
+        cube.luminosity = settings.luminosity;
+        cube.sigXlumi = settings.sig_xlumi;
+        cube.xsecs.assign(cube.samples.size(), 0);
+        for(unsigned int i=0; i<cube.samples.size(); i++)
+            if(samples.find(cube.samples[i].c_str()) != samples.end()) cube.xsecs[i] = samples[cube.samples[i].c_str()]->xsec;
+
+        std::cout << "  /// Saving the cube to " << settings.cube << " ..." << std::endl;
+        cube.write(settings.cube.Data());
+    }
+
+    if(settings.massRecord != "")
+    {
+        std::cout << Form("  /// Saving %lld unbinned masses to %s ...", massRecord.size(), settings.massRecord.Data()) << std::endl;
+        massRecord.write(settings.massRecord.Data());
+    }
  
     return 0;
 }
@@ -0,0 +1,258 @@
+/////////////////////////////////////////////////////////////////////////////
+//                           checkCategorizerPlugin.cxx                    //
+//=========================================================================//
+//                                                                         //
+// Check that a categorizer plugin from ./generateCategorizer puts every   //
+// event in the same categories as the XMLCategorizer for the XML it was   //
+// generated from. The categories and their ids are compared first, then   //
+// the selected events of the signal, the backgrounds, and the data are    //
+// evaluated with the same classifier score by the plugin, by evaluate     //
+// (the flat nodes the plugin was generated from), and by the original     //
+// evaluateRecursive, so a bug in the flattening shows up too. Returns 1   //
+// if there is any difference.                                             //
+//                                                                         //
+// Set MAIN=checkCategorizerPlugin in the makefile then run via            //
+// ./checkCategorizerPlugin <xmlfile> <name> [reductionFactor] [nthreads]  //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+#include "Sample.h"
+#include "EventSelection.h"
+#include "MuonSelection.h"
+#include "CategorySelection.h"
+#include "JetCollectionCleaner.h"
+#include "MuonCollectionCleaner.h"
+#include "EleCollectionCleaner.h"
+#include "FusedCollectionCleaner.h"
+
+#include "TMVATools.h"
+#include "SampleDatabase.cxx"
+#include "ThreadPool.hxx"
+
+#include <sstream>
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include "TROOT.h"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct CheckResult
+{
+    long long nevents = 0;
+    long long nmismatch = 0;
+    long long nmismatchRecursive = 0;
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+// same categories, names, and ids in both categorizers
+bool sameCategories(Categorizer& a, Categorizer& b)
+{
+    if(a.categories.size() != b.categories.size())
+    {
+        std::cout << Form("  !!! %d categories in the XML, %d in the plugin \n", (int)a.categories.size(), (int)b.categories.size());
+        return false;
+    }
+
+    bool same = true;
+    for(unsigned int i=0; i<a.categories.size(); i++)
+    {
+        Category* ca = a.categories[i];
+        Category* cb = b.categories[i];
+        if(ca->key != cb->key || ca->name != cb->name || ca->hide != cb->hide || ca->isTerminal != cb->isTerminal)
+        {
+            std::cout << Form("  !!! category %d: %s (%s) in the XML, %s (%s) in the plugin \n", i,
+                              ca->key.Data(), ca->name.Data(), cb->key.Data(), cb->name.Data());
+            same = false;
+        }
+    }
+    return same;
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+    gROOT->SetBatch();
+
+    if(argc < 3)
+    {
+        std::cout << "usage: ./checkCategorizerPlugin <xmlfile> <name> [reductionFactor] [nthreads]" << std::endl;
+        return 1;
+    }
+
+    TString xmlfile = argv[1];
+    TString name = argv[2];
+    float reductionFactor = 10;
+    int nthreads = 10;
+    if(argc > 3)
+    {
+        std::stringstream ss;
+        ss << argv[3];
+        ss >> reductionFactor;
+    }
+    if(argc > 4)
+    {
+        std::stringstream ss;
+        ss << argv[4];
+        ss >> nthreads;
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // CATEGORIES -----------------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    XMLCategorizer reference(xmlfile);
+    Categorizer* plugin = loadCategorizerPlugin(name);
+    if(plugin == 0) return 1;
+    if(!sameCategories(reference, *plugin)) return 1;
+    std::cout << Form("  /// %d categories match \n", (int)reference.categories.size());
+    delete plugin;
+
+    std::shared_ptr<const BDTForest> classifier = TMVATools::getClassifier("classification/f_Opt_v1_all_sig_all_bkg_ge0j_BDTG_UF_v1.weights.xml");
+    if(!classifier) return 1;
+
+    ///////////////////////////////////////////////////////////////////
+    // SAMPLES---------------------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    std::map<TString, Sample*> samples;
+    GetSamples(samples, "UF", "ALL_dyAMC-J");
+
+    std::vector<Sample*> samplevec;
+    for(auto& s: samples)
+    {
+        s.second->setBranchAddresses("");
+        samplevec.push_back(s.second);
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // COMPARE EVENT BY EVENT -----------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    auto checkSample = [xmlfile, name, classifier, reductionFactor](Sample* s)
+    {
+        CheckResult result;
+
+        XMLCategorizer xmlCategorizer(xmlfile);
+        XMLCategorizer recursiveCategorizer(xmlfile);
+        Categorizer* pluginCategorizer = loadCategorizerPlugin(name);
+        if(pluginCategorizer == 0)
+        {
+            result.nmismatch = -1;
+            return result;
+        }
+
+        JetCollectionCleaner      jetCollectionCleaner;
+        MuonCollectionCleaner     muonCollectionCleaner;
+        EleCollectionCleaner      eleCollectionCleaner;
+        FusedCollectionCleaner    fusedCollectionCleaner(jetCollectionCleaner, muonCollectionCleaner, eleCollectionCleaner, 0.4);
+
+        Run2MuonSelectionCuts  run2MuonSelection;
+        Run2EventSelectionCuts run2EventSelection;
+        ClassifierInputs bdtInputs;
+
+        std::vector<int> idsXML, idsRecursive, idsPlugin;
+
+        for(unsigned int i=0; i<s->N/reductionFactor; i++)
+        {
+            s->branches.muPairs->GetEntry(i);
+            s->branches.muons->GetEntry(i);
+            s->branches.eventInfo->GetEntry(i);
+            if(s->vars.muPairs->size() < 1) continue;
+
+            // the first candidate that passes the selection, as in categorize
+            for(auto& dimu: (*s->vars.muPairs))
+            {
+                s->vars.dimuCand = &dimu;
+                MuonInfo& mu1 = s->vars.muons->at(dimu.iMu1);
+                MuonInfo& mu2 = s->vars.muons->at(dimu.iMu2);
+                s->vars.setCalibrationType("PF");
+
+                if(!run2EventSelection.evaluate(s->vars)) continue;
+                if(!mu1.isMediumID || !mu2.isMediumID) continue;
+                if(!run2MuonSelection.evaluate(s->vars)) continue;
+
+                s->branches.getEntry(i);
+                s->vars.setCalibrationType("PF");
+                fusedCollectionCleaner.getValidCollections(s->vars);
+                s->vars.setVBFjets();
+                s->vars.bdt_out = TMVATools::getClassifierScore(*classifier, bdtInputs, s->vars);
+
+                xmlCategorizer.reset();
+                recursiveCategorizer.reset();
+                pluginCategorizer->reset();
+                xmlCategorizer.evaluate(s->vars);
+                recursiveCategorizer.evaluateRecursive(s->vars, recursiveCategorizer.rootNode);
+                pluginCategorizer->evaluate(s->vars);
+
+                idsXML = xmlCategorizer.inIds;
+                idsRecursive = recursiveCategorizer.inIds;
+                idsPlugin = pluginCategorizer->inIds;
+                std::sort(idsXML.begin(), idsXML.end());
+                std::sort(idsRecursive.begin(), idsRecursive.end());
+                std::sort(idsPlugin.begin(), idsPlugin.end());
+
+                result.nevents++;
+                if(idsXML != idsPlugin)
+                {
+                    if(result.nmismatch < 10)
+                        std::cout << Form("  !!! %s entry %d: %d categories from the XML, %d from the plugin \n",
+                                          s->name.Data(), i, (int)idsXML.size(), (int)idsPlugin.size());
+                    result.nmismatch++;
+                }
+                if(idsRecursive != idsPlugin)
+                {
+                    if(result.nmismatchRecursive < 10)
+                        std::cout << Form("  !!! %s entry %d: %d categories from evaluateRecursive, %d from the plugin \n",
+                                          s->name.Data(), i, (int)idsRecursive.size(), (int)idsPlugin.size());
+                    result.nmismatchRecursive++;
+                }
+                break;
+            }
+        }
+
+        std::cout << Form("  /// %s: %lld events, %lld mismatches, %lld vs evaluateRecursive \n", s->name.Data(),
+                          result.nevents, result.nmismatch, result.nmismatchRecursive);
+        delete pluginCategorizer;
+        delete s;
+        return result;
+    };
+
+    ThreadPool pool(nthreads);
+    std::vector< std::future<CheckResult> > results;
+    for(auto& s: samplevec)
+        results.push_back(pool.enqueue(checkSample, s));
+
+    long long nevents = 0;
+    long long nmismatch = 0;
+    long long nmismatchRecursive = 0;
+    bool failed = false;
+    for(auto& r: results)
+    {
+        CheckResult result = r.get();
+        if(result.nmismatch < 0) failed = true;
+        else
+        {
+            nevents += result.nevents;
+            nmismatch += result.nmismatch;
+            nmismatchRecursive += result.nmismatchRecursive;
+        }
+    }
+
+    std::cout << std::endl;
+    std::cout << Form("  /// %s vs %s \n", xmlfile.Data(), name.Data());
+    std::cout << Form("  /// events:     %lld \n", nevents);
+    std::cout << Form("  /// mismatches: %lld \n", nmismatch);
+    std::cout << Form("  /// mismatches vs evaluateRecursive: %lld \n", nmismatchRecursive);
+
+    return (failed || nmismatch > 0 || nmismatchRecursive > 0) ? 1 : 0;
+}
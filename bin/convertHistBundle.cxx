@@ -0,0 +1,173 @@
+/////////////////////////////////////////////////////////////////////////////
+//                         convertHistBundle.cxx                           //
+//=========================================================================//
+//                                                                         //
+// Convert a categorize output between the ROOT file and the HistBundle    //
+// side file, either way. Every TH1D in the top directory and in the       //
+// directories one level down (signal_histos, bg_histos, data_histos,      //
+// net_histos) goes into the bundle; the stack canvases aren't             //
+// histograms and are skipped. A bundle converts back into a ROOT file     //
+// with the same directories and histograms.                               //
+//                                                                         //
+// Set MAIN=convertHistBundle in the makefile then run via                 //
+// ./convertHistBundle --in=rootfiles/validate_....root --compress=1       //
+// ./convertHistBundle --in=rootfiles/validate_....hbnd --out=rootfiles/from_bundle.root
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+#include "HistBundle.hxx"
+
+#include <sstream>
+#include <set>
+
+#include "TFile.h"
+#include "TKey.h"
+#include "TList.h"
+#include "TH1D.h"
+#include "TROOT.h"
+#include "TStopwatch.h"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct Settings
+{
+// default settings here, may be overwritten by terminal input, see main() below
+
+    TString in = "";          // .root or .hbnd
+    TString out = "";         // default is the input with the other extension
+    bool compress = false;    // zlib compress the bundle
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+// add the TH1Ds in dir to the bundle under dirname, each name once at its last cycle
+int addDirectory(HistBundle& bundle, TDirectory* dir, const std::string& dirname, int& nskipped)
+{
+    int nadded = 0;
+    std::set<std::string> seen;
+    TIter next(dir->GetListOfKeys());
+    TKey* key = 0;
+    while((key = (TKey*)next()))
+    {
+        std::string name = key->GetName();
+        if(seen.count(name)) continue;    // keys are ordered by cycle, highest first
+        seen.insert(name);
+
+        TString classname = key->GetClassName();
+        if(classname == "TH1D")
+        {
+            TH1D* h = (TH1D*)key->ReadObj();
+            bundle.add(dirname, h);
+            delete h;
+            nadded++;
+        }
+        else if(dirname == "" && classname.BeginsWith("TDirectory"))
+            nadded += addDirectory(bundle, (TDirectory*)key->ReadObj(), name, nskipped);
+        else nskipped++;
+    }
+    return nadded;
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+    Settings settings;
+
+    for(int i=1; i<argc; i++)
+    {
+        std::stringstream ss;
+        TString in = argv[i];
+        TString option = in(0, in.First("="));
+        option = option.ReplaceAll("--", "");
+        TString value  = in(in.First("=")+1, in.Length());
+        value = value.ReplaceAll("\"", "");
+        ss << value.Data();
+
+        if(option=="in")                   settings.in = value;
+        else if(option=="out")             settings.out = value;
+        else if(option=="compress")        ss >> settings.compress;
+        else
+        {
+            std::cout << Form("!!! %s is not a recognized option.", option.Data()) << std::endl;
+        }
+    }
+
+    gROOT->SetBatch();
+    TH1::AddDirectory(kFALSE);
+
+    TStopwatch timerWatch;
+    timerWatch.Start();
+
+    bool toBundle = settings.in.EndsWith(".root");
+    if(!toBundle && !settings.in.EndsWith(".hbnd"))
+    {
+        std::cout << "!!! --in should be a .root or a .hbnd file" << std::endl;
+        return 1;
+    }
+    if(settings.out == "")
+    {
+        settings.out = settings.in;
+        if(toBundle) settings.out.Replace(settings.out.Length()-5, 5, ".hbnd");
+        else settings.out.Replace(settings.out.Length()-5, 5, ".root");
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // ROOT -> Bundle -------------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    if(toBundle)
+    {
+        TFile* infile = TFile::Open(settings.in);
+        if(!infile || infile->IsZombie()) return 1;
+
+        HistBundle bundle;
+        bundle.compress = settings.compress;
+        int nskipped = 0;
+        int nadded = addDirectory(bundle, infile, "", nskipped);
+        infile->Close();
+
+        if(!bundle.write(settings.out.Data())) return 1;
+        std::cout << Form("  /// %d histos -> %s, %d other objects skipped \n", nadded, settings.out.Data(), nskipped);
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // Bundle -> ROOT -------------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    else
+    {
+        HistBundle bundle;
+        if(!bundle.open(settings.in.Data())) return 1;
+
+        TFile* savefile = new TFile(settings.out, "RECREATE");
+        for(unsigned int i=0; i<bundle.entries.size(); i++)
+        {
+            const BundleEntry& e = bundle.entries[i];
+            TDirectory* dir = savefile;
+            if(e.dir != "")
+            {
+                dir = savefile->GetDirectory(e.dir.c_str());
+                if(dir == 0) dir = savefile->mkdir(e.dir.c_str());
+            }
+
+            TH1D* h = bundle.getTH1D(i);
+            if(h == 0) return 1;
+            dir->cd();
+            h->Write();
+            delete h;
+        }
+        savefile->Close();
+        std::cout << Form("  /// %d histos -> %s \n", (int)bundle.entries.size(), settings.out.Data());
+    }
+
+    timerWatch.Stop();
+    std::cout << "### DONE " << timerWatch.RealTime() << " seconds" << std::endl;
+    return 0;
+}
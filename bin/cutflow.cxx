@@ -0,0 +1,321 @@
+/////////////////////////////////////////////////////////////////////////////
+//                           cutflow.cxx                                   //
+//=========================================================================//
+//                                                                         //
+// N-1 plots, sequential cutflows, and per cut efficiencies for the        //
+// Run2EventSelectionCuts and Run2MuonSelectionCuts in every category and  //
+// sample from a single pass over the data. Replaces rerunning nm1 once    //
+// per cut configuration. Uses CutFlow in ../lib/.                         //
+//                                                                         //
+// The candidate used for an event is the first dimuon candidate passing  //
+// all of the cuts that are on, or the leading candidate if none pass.    //
+//                                                                         //
+// Set MAIN=cutflow in the makefile then run via                           //
+// ./cutflow --categories=1 --nthreads=10                                  //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+#include "Sample.h"
+#include "DiMuPlottingSystem.h"
+#include "EventSelection.h"
+#include "MuonSelection.h"
+#include "CategorySelection.h"
+#include "JetCollectionCleaner.h"
+#include "MuonCollectionCleaner.h"
+#include "EleCollectionCleaner.h"
+#include "FusedCollectionCleaner.h"
+#include "CutFlow.h"
+
+#include "TMVATools.h"
+
+#include "SampleDatabase.cxx"
+#include "ThreadPool.hxx"
+
+#include <sstream>
+#include <map>
+#include <vector>
+#include <utility>
+
+#include "TSystem.h"
+#include "TFile.h"
+#include "TStopwatch.h"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct Settings
+{
+// default settings here, may be overwritten by terminal input, see main() below
+
+    int whichCategories = 1;                 // run1categories = 1, run2categories = 2, "categories.xml" = 3 -> xmlcategories
+    TString xmlfile;                         // filename for the xmlcategorizer, if you chose to use one
+    int nthreads = 20;                       // number of threads to use in parallelization
+    float luminosity = 36814;                // pb-1
+    float reductionFactor = 1;               // reduce the number of events you run over
+    TString whichDY = "dyAMC-J";             // use amc@nlo or madgraph for Drell Yan : {"dyAMC", "dyAMC-J", "dyMG"}
+    TString calibration = "Roch";            // PF, Roch, or KaMu
+    float subleadPt = 20;                    // subleading muon pt cut
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+Categorizer* makeCategorizer(Settings& settings)
+{
+    if(settings.whichCategories == 1) return new CategorySelectionRun1();
+    if(settings.whichCategories == 2) return new CategorySelectionBDT();
+    if(settings.xmlfile.Contains("hybrid")) return new CategorySelectionHybrid(settings.xmlfile);
+    return new XMLCategorizer(settings.xmlfile);
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+    Settings settings;
+
+    for(int i=1; i<argc; i++)
+    {
+        std::stringstream ss;
+        TString in = argv[i];
+        TString option = in(0, in.First("="));
+        option = option.ReplaceAll("--", "");
+        TString value  = in(in.First("=")+1, in.Length());
+        value = value.ReplaceAll("\"", "");
+        ss << value.Data();
+
+        if(option=="categories")
+        {
+            if(value.Contains(".xml"))
+            {
+                settings.xmlfile = value;
+                settings.whichCategories = 3;
+            }
+            else
+                ss >> settings.whichCategories;
+        }
+        else if(option=="nthreads")        ss >> settings.nthreads;
+        else if(option=="reductionFactor") ss >> settings.reductionFactor;
+        else if(option=="luminosity")      ss >> settings.luminosity;
+        else if(option=="subleadPt")       ss >> settings.subleadPt;
+        else if(option=="whichDY")         settings.whichDY = value;
+        else if(option=="calibration")     settings.calibration = value;
+        else
+        {
+            std::cout << Form("!!! %s is not a recognized option.", option.Data()) << std::endl;
+        }
+    }
+
+    TH1::SetDefaultSumw2();
+
+    ///////////////////////////////////////////////////////////////////
+    // SAMPLES---------------------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    std::map<TString, Sample*> samples;
+    std::vector<Sample*> samplevec;
+
+    GetSamples(samples, "UF", "ALL_"+settings.whichDY);
+
+    for(auto &i : samples)
+    {
+        i.second->setBranchAddresses("");
+        samplevec.push_back(i.second);
+    }
+    std::sort(samplevec.begin(), samplevec.end(), [](Sample* a, Sample* b){ return a->xsec < b->xsec; });
+
+    TStopwatch timerWatch;
+    timerWatch.Start();
+
+    ///////////////////////////////////////////////////////////////////
+    // Define Task for Parallelization -------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    // the forest is read only after loading, so all of the threads share it, same as categorize
+    TString weightfile = "classification/f_Opt_v1_all_sig_all_bkg_ge0j_BDTG_UF_v1.weights.xml";
+    std::shared_ptr<const BDTForest> classifier;
+    if(settings.whichCategories >= 2)
+    {
+        classifier = TMVATools::getClassifier(weightfile);
+        if(!classifier) return 1;
+    }
+
+    auto cutflowForSample = [settings, classifier](Sample* s)
+    {
+      Settings sets = settings;
+      std::cout << Form("  /// Processing %s \n", s->name.Data());
+
+      // per thread classifier inputs, resolved to VarSet handles on the first event
+      ClassifierInputs bdtInputs;
+
+      FusedCollectionCleaner fusedCollectionCleaner;
+
+      Run2MuonSelectionCuts  run2MuonSelection;
+      Run2EventSelectionCuts run2EventSelection;
+      run2MuonSelection.cMinPt = sets.subleadPt;
+      run2MuonSelection.makeCutSet();
+
+      // event selection cuts get bits 0-2, muon selection cuts get bits 3-8
+      CutFlow* cutflow = new CutFlow(s->name);
+      cutflow->addCut(&run2EventSelection);
+      cutflow->addCut(&run2MuonSelection);
+
+      Categorizer* categorySelection = makeCategorizer(sets);
+      bool isData = s->sampleType.EqualTo("data");
+
+      for(unsigned int i=0; i<s->N/sets.reductionFactor; i++)
+      {
+        if(!isData)
+        {
+            s->branches.lhe_ht->GetEntry(i);
+            if(s->name == "ZJets_MG" && s->vars.lhe_ht >= 70) continue;
+        }
+
+        s->branches.muPairs->GetEntry(i);
+        s->branches.muons->GetEntry(i);
+        s->branches.eventInfo->GetEntry(i);
+
+        if(s->vars.muPairs->size() < 1) continue;
+
+        // avoid double counting in RunF
+        if(s->name == "RunF_1" && s->vars.eventInfo->run > 278801) continue;
+        if(s->name == "RunF_2" && s->vars.eventInfo->run < 278802) continue;
+
+        // first candidate with medium id muons passing all the cuts that are on,
+        // otherwise the first candidate with medium id muons
+        int chosen = -1;
+        for(unsigned int d=0; d<s->vars.muPairs->size(); d++)
+        {
+            MuPairInfo& dimu = s->vars.muPairs->at(d);
+            s->vars.dimuCand = &dimu;
+            s->vars.setCalibrationType(sets.calibration);
+
+            if(!s->vars.muons->at(dimu.iMu1).isMediumID || !s->vars.muons->at(dimu.iMu2).isMediumID) continue;
+            if(chosen < 0) chosen = d;
+            if(cutflow->passes(cutflow->evaluate(s->vars)))
+            {
+                chosen = d;
+                break;
+            }
+        }
+        if(chosen < 0) continue;
+
+        // load everything and categorize the chosen candidate
+        s->branches.getEntry(i);
+        s->vars.dimuCand = &s->vars.muPairs->at(chosen);
+        s->vars.setCalibrationType(sets.calibration);
+
+        ULong64_t mask = cutflow->evaluate(s->vars);
+
+        fusedCollectionCleaner.getValidCollections(s->vars);
+        s->vars.setVBFjets();
+        if(sets.whichCategories >= 2) s->vars.bdt_out = TMVATools::getClassifierScore(*classifier, bdtInputs, s->vars);
+
+        categorySelection->reset();
+        categorySelection->evaluate(s->vars);
+
+        double weight = s->getWeight();
+        for(int id : categorySelection->inIds)
+        {
+            Category& c = *categorySelection->categories[id];
+            if(c.hide) continue;
+            cutflow->fill(c.name, mask, weight);
+        }
+      }
+
+      cutflow->scale(s->getLumiScaleFactor(sets.luminosity));
+      delete categorySelection;
+
+      // the selection objects go out of scope here, the CutFlow keeps its own copy of the cuts
+      cutflow->cutObjects.clear();
+
+      std::cout << Form("  /// Done processing %s \n", s->name.Data());
+      return cutflow;
+    };
+
+   ///////////////////////////////////////////////////////////////////
+   // PARALLELIZE BY SAMPLE -----------------------------------------
+   ///////////////////////////////////////////////////////////////////
+
+    // the histograms are booked in the threads, keep them out of gDirectory, which isn't thread safe
+    TH1::AddDirectory(kFALSE);
+
+    ThreadPool pool(settings.nthreads);
+    std::vector< std::future<CutFlow*> > results;
+
+    for(auto &s : samplevec)
+        results.push_back(pool.enqueue(cutflowForSample, s));
+
+    std::vector<CutFlow*> cutflows;
+    for(auto && result: results)
+        cutflows.push_back(result.get());
+
+    ///////////////////////////////////////////////////////////////////
+    // Sum by sample type, output efficiencies, save ------------------
+    ///////////////////////////////////////////////////////////////////
+
+    // net signal, background, and data cutflows for each category, same layout as the per sample ones
+    std::map<TString, CutFlow*> netCutflows;
+    TList* samplelist = new TList();
+    TList* netlist = new TList();
+
+    for(auto& cutflow: cutflows)
+    {
+        samplelist->Add(cutflow->getList());
+        TString type = samples[cutflow->suffix]->sampleType;
+        if(netCutflows.find(type) == netCutflows.end())
+        {
+            netCutflows[type] = new CutFlow("Net_"+type);
+            netCutflows[type]->cuts = cutflow->cuts;
+        }
+        CutFlow* net = netCutflows[type];
+
+        for(auto& h: cutflow->histos)
+        {
+            CutFlowHistos& nh = net->book(h.first);
+            nh.cutflow->Add(h.second.cutflow);
+            nh.passed->Add(h.second.passed);
+            for(unsigned int i=0; i<nh.nm1.size(); i++)
+                nh.nm1[i]->Add(h.second.nm1[i]);
+        }
+    }
+
+    for(auto& net: netCutflows)
+    {
+        for(auto& h: net.second->histos)
+            net.second->outputEfficiencies(h.first);
+        netlist->Add(net.second->getList());
+    }
+
+    TString categoryString = Form("%d", settings.whichCategories);
+    if(settings.whichCategories == 3)
+    {
+        Ssiz_t i = settings.xmlfile.Last('/');
+        categoryString = settings.xmlfile(i+1, settings.xmlfile.Length());
+        categoryString = categoryString.ReplaceAll(".xml", "");
+    }
+
+    TString savename = Form("rootfiles/cutflow_categories_%s_%s_%s_minpt%d.root", categoryString.Data(), settings.whichDY.Data(),
+                            settings.calibration.Data(), (int)settings.subleadPt);
+    std::cout << "  /// Saving cutflows to " << savename << " ..." << std::endl;
+
+    TFile* savefile = new TFile(savename, "RECREATE");
+    TDirectory* sample_histos = savefile->mkdir("sample_histos");
+    TDirectory* net_histos    = savefile->mkdir("net_histos");
+
+    sample_histos->cd();
+    samplelist->Write();
+
+    net_histos->cd();
+    netlist->Write();
+
+    savefile->Close();
+
+    timerWatch.Stop();
+    std::cout << "### DONE " << timerWatch.RealTime() << " seconds" << std::endl;
+    return 0;
+}
@@ -677,11 +677,12 @@ int main(int argc, char* argv[])
           categorySelection->evaluate(s->vars);
 
           // Fill the histogram for the variable we are plotting for each sample x category
-          for(auto &c : categorySelection->categoryMap)
+          for(int id : categorySelection->inIds)
           {
+              Category& c = *categorySelection->categories[id];
+
               // skip categories that we decided to hide (usually some intermediate categories)
-              if(c.second.hide) continue;
-              if(!c.second.inCategory) continue;
+              if(c.hide) continue;
 
               ///////////////////////////////////////////////////////////////////
               // FILL HISTOGRAM APPROPRIATELY  ----------------------------------
@@ -693,37 +694,37 @@ int main(int argc, char* argv[])
                   if(isData && varvalue > 120 && varvalue < 130 && isblinded) continue; // blind signal region
 
                   // if the event is in the current category then fill the category's histogram for the given sample and variable
-                  c.second.histoMap[hkey]->Fill(varvalue, s->getWeight());
-                  //std::cout << "    " << c.first << ": " << varvalue;
+                  c.histoMap[hkey]->Fill(varvalue, s->getWeight());
+                  //std::cout << "    " << c.key << ": " << varvalue;
                   continue;
               }
 
               if(varname.Contains("dimu_pt"))
               {
                   // if the event is in the current category then fill the category's histogram for the given sample and variable
-                  c.second.histoMap[hkey]->Fill(dimu.pt, s->getWeight());
+                  c.histoMap[hkey]->Fill(dimu.pt, s->getWeight());
                   continue;
               }
               // mu_pt is a substring of dimu_pt so we need the else if
               else if(varname.Contains("mu_pt"))
               {
-                  c.second.histoMap[hkey]->Fill(mu1.pt, s->getWeight());
-                  c.second.histoMap[hkey]->Fill(mu2.pt, s->getWeight());
+                  c.histoMap[hkey]->Fill(mu1.pt, s->getWeight());
+                  c.histoMap[hkey]->Fill(mu2.pt, s->getWeight());
                   continue;
               }
 
               // recoMu_Eta
               if(varname.EqualTo("mu_eta"))
               {
-                  c.second.histoMap[hkey]->Fill(mu1.eta, s->getWeight());
-                  c.second.histoMap[hkey]->Fill(mu2.eta, s->getWeight());
+                  c.histoMap[hkey]->Fill(mu1.eta, s->getWeight());
+                  c.histoMap[hkey]->Fill(mu2.eta, s->getWeight());
                   continue;
               }
 
               // NPV
               if(varname.EqualTo("NPV"))
               {
-                   c.second.histoMap[hkey]->Fill(s->vars.nVertices, s->getWeight());
+                   c.histoMap[hkey]->Fill(s->vars.nVertices, s->getWeight());
                    continue;
               }
 
@@ -731,7 +732,7 @@ int main(int argc, char* argv[])
               if(varname.EqualTo("jet_pt"))
               {
                    for(auto& jet: s->vars.validJets)
-                       c.second.histoMap[hkey]->Fill(jet.Pt(), s->getWeight());
+                       c.histoMap[hkey]->Fill(jet.Pt(), s->getWeight());
                    continue;
               }
 
@@ -739,14 +740,14 @@ int main(int argc, char* argv[])
               if(varname.EqualTo("jet_eta"))
               {
                    for(auto& jet: s->vars.validJets)
-                       c.second.histoMap[hkey]->Fill(jet.Eta(), s->getWeight());
+                       c.histoMap[hkey]->Fill(jet.Eta(), s->getWeight());
                    continue;
               }
 
               // nValJets
               if(varname.EqualTo("nValJets"))
               {
-                   c.second.histoMap[hkey]->Fill(s->vars.validJets.size(), s->getWeight());
+                   c.histoMap[hkey]->Fill(s->vars.validJets.size(), s->getWeight());
                    continue;
               }
 
@@ -756,7 +757,7 @@ int main(int argc, char* argv[])
                    if(s->vars.validJets.size() >= 2)
                    {
                        TLorentzVector dijet = s->vars.validJets[0] + s->vars.validJets[1];
-                       c.second.histoMap[hkey]->Fill(dijet.M(), s->getWeight());
+                       c.histoMap[hkey]->Fill(dijet.M(), s->getWeight());
                    }
                    continue;
               }
@@ -767,7 +768,7 @@ int main(int argc, char* argv[])
                    if(s->vars.validJets.size() >= 2)
                    {
                        float dEta = s->vars.validJets[0].Eta() - s->vars.validJets[1].Eta();
-                       c.second.histoMap[hkey]->Fill(dEta, s->getWeight());
+                       c.histoMap[hkey]->Fill(dEta, s->getWeight());
                    }
                    continue;
               }
@@ -775,14 +776,14 @@ int main(int argc, char* argv[])
               // N_valid_muons
               if(varname.EqualTo("N_valid_muons"))
               {
-                   c.second.histoMap[hkey]->Fill(s->vars.validMuons.size(), s->getWeight());
+                   c.histoMap[hkey]->Fill(s->vars.validMuons.size(), s->getWeight());
                    continue;
               }
 
               // nExtraMu
               if(varname.EqualTo("nExtraMu"))
               {
-                   c.second.histoMap[hkey]->Fill(s->vars.validExtraMuons.size(), s->getWeight());
+                   c.histoMap[hkey]->Fill(s->vars.validExtraMuons.size(), s->getWeight());
                    continue;
               }
 
@@ -790,7 +791,7 @@ int main(int argc, char* argv[])
               if(varname.EqualTo("extra_muon_pt"))
               {
                   for(auto& mu: s->vars.validExtraMuons)
-                      c.second.histoMap[hkey]->Fill(mu.Pt(), s->getWeight());
+                      c.histoMap[hkey]->Fill(mu.Pt(), s->getWeight());
                   continue;
               }
 
@@ -798,14 +799,14 @@ int main(int argc, char* argv[])
               if(varname.EqualTo("extra_muon_eta"))
               {
                   for(auto& mu: s->vars.validExtraMuons)
-                      c.second.histoMap[hkey]->Fill(mu.Eta(), s->getWeight());
+                      c.histoMap[hkey]->Fill(mu.Eta(), s->getWeight());
                   continue;
               }
 
               // nEle
               if(varname.EqualTo("nEle"))
               {
-                   c.second.histoMap[hkey]->Fill(s->vars.validElectrons.size(), s->getWeight());
+                   c.histoMap[hkey]->Fill(s->vars.validElectrons.size(), s->getWeight());
                    continue;
               }
 
@@ -813,28 +814,28 @@ int main(int argc, char* argv[])
               if(varname.EqualTo("electron_pt"))
               {
                   for(auto& e: s->vars.validElectrons)
-                      c.second.histoMap[hkey]->Fill(e.Pt(), s->getWeight());
+                      c.histoMap[hkey]->Fill(e.Pt(), s->getWeight());
                   continue;
               }
               // electron_eta
               if(varname.EqualTo("electron_eta"))
               {
                   for(auto& e: s->vars.validElectrons)
-                      c.second.histoMap[hkey]->Fill(e.Eta(), s->getWeight());
+                      c.histoMap[hkey]->Fill(e.Eta(), s->getWeight());
                   continue;
               }
 
               // nExtraLep
               if(varname.EqualTo("nExtraLep"))
               {
-                   c.second.histoMap[hkey]->Fill(s->vars.validElectrons.size() + s->vars.validExtraMuons.size(), s->getWeight());
+                   c.histoMap[hkey]->Fill(s->vars.validElectrons.size() + s->vars.validExtraMuons.size(), s->getWeight());
                    continue;
               }
 
               // nValBTags
               if(varname.EqualTo("nValBTags"))
               {
-                   c.second.histoMap[hkey]->Fill(s->vars.validBJets.size(), s->getWeight());
+                   c.histoMap[hkey]->Fill(s->vars.validBJets.size(), s->getWeight());
                    continue;
               }
 
@@ -842,7 +843,7 @@ int main(int argc, char* argv[])
               if(varname.EqualTo("bjet_pt"))
               {
                   for(auto& bjet: s->vars.validBJets)
-                      c.second.histoMap[hkey]->Fill(bjet.Pt(), s->getWeight());
+                      c.histoMap[hkey]->Fill(bjet.Pt(), s->getWeight());
                   continue;
               }
 
@@ -850,7 +851,7 @@ int main(int argc, char* argv[])
               if(varname.EqualTo("bjet_eta"))
               {
                   for(auto& bjet: s->vars.validBJets)
-                      c.second.histoMap[hkey]->Fill(bjet.Eta(), s->getWeight());
+                      c.histoMap[hkey]->Fill(bjet.Eta(), s->getWeight());
                   continue;
               }
               // m_bb
@@ -859,7 +860,7 @@ int main(int argc, char* argv[])
                    if(s->vars.validBJets.size() >= 2)
                    {
                        TLorentzVector dijet = s->vars.validBJets[0] + s->vars.validBJets[1];
-                       c.second.histoMap[hkey]->Fill(dijet.M(), s->getWeight());
+                       c.histoMap[hkey]->Fill(dijet.M(), s->getWeight());
                    }
                    continue;
               }
@@ -874,7 +875,7 @@ int main(int argc, char* argv[])
               //         TLorentzVector bjet_t(bjet.Px(), bjet.Py(), 0, bjet.Et());
               //         TLorentzVector bmet_t = met + bjet_t;
 
-              //         c.second.histoMap[hkey]->Fill(bmet_t.M(), s->getWeight());
+              //         c.histoMap[hkey]->Fill(bmet_t.M(), s->getWeight());
               //     }
               //     continue;
               //}
@@ -882,7 +883,7 @@ int main(int argc, char* argv[])
               // MHT
               if(varname.EqualTo("MHT"))
               {
-                  c.second.histoMap[hkey]->Fill(s->vars.mht->pt, s->getWeight());
+                  c.histoMap[hkey]->Fill(s->vars.mht->pt, s->getWeight());
               }
 
               // dEta_jj_mumu
@@ -892,7 +893,7 @@ int main(int argc, char* argv[])
                    {
                        TLorentzVector dijet = s->vars.validJets[0] + s->vars.validJets[1];
                        float dEta = dijet.Eta() - s->vars.dimuCand->eta;
-                       c.second.histoMap[hkey]->Fill(dEta, s->getWeight());
+                       c.histoMap[hkey]->Fill(dEta, s->getWeight());
                    }
                    continue;
               }
@@ -0,0 +1,195 @@
+/////////////////////////////////////////////////////////////////////////////
+//                           generateCategorizer.cxx                       //
+//=========================================================================//
+//                                                                         //
+// Write a categorization XML from the autocategorizer as a C++            //
+// Categorizer subclass. The splits become nested ifs with the thresholds  //
+// as constants and the category ids as constants, so nothing about the    //
+// tree is looked up per event. The class is written to plugins/<name>.cxx //
+// with a createCategorizer_<name> factory. Build the plugin with          //
+//   make plugins/lib<name>.so                                             //
+// and load it in categorize with --plugin=<name>. Check it against the    //
+// XMLCategorizer with ./checkCategorizerPlugin <xmlfile> <name>.          //
+//                                                                         //
+// Set MAIN=generateCategorizer in the makefile then run via               //
+// ./generateCategorizer tree_categorization_final.xml TreeCategorizationFinal
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+#include "CategorySelection.h"
+
+#include "TSystem.h"
+#include "TString.h"
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <iostream>
+#include <cctype>
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct Generator
+{
+    XMLCategorizer& xmlcat;
+    std::vector<TString> varnames;   // distinct split variables, h[i] in the generated code
+    std::vector<int> varIndex;       // node -> index into varnames
+
+    Generator(XMLCategorizer& x) : xmlcat(x)
+    {
+        for(unsigned int n=0; n<xmlcat.flatNodes.size(); n++)
+        {
+            int index = -1;
+            if(xmlcat.flatNodes[n].left >= 0)
+            {
+                TString var = xmlcat.flatSplitVarNames[n];
+                for(unsigned int v=0; v<varnames.size(); v++)
+                    if(varnames[v] == var) index = v;
+                if(index < 0)
+                {
+                    index = varnames.size();
+                    varnames.push_back(var);
+                }
+            }
+            varIndex.push_back(index);
+        }
+    }
+
+    // escape a category key for a string literal, the keys only have [A-Za-z0-9_] in practice
+    static std::string quote(const TString& s)
+    {
+        std::string out = "\"";
+        for(int i=0; i<s.Length(); i++)
+        {
+            char c = s[i];
+            if(c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out+"\"";
+    }
+
+    void writeNode(std::ostream& out, int n, int indent)
+    {
+        const FlatCategoryNode& node = xmlcat.flatNodes[n];
+        std::string pad(indent, ' ');
+        Category* c = xmlcat.categories[node.category];
+
+        out << pad << "setInCategory(" << node.category << ");    // " << c->key << std::endl;
+        if(node.left < 0 || node.right < 0) return;
+
+        out << pad << "if(vars.getValue(h[" << varIndex[n] << "]) <= " << Form("%.17g", node.splitVal) << ")    // "
+            << xmlcat.flatSplitVarNames[n] << std::endl;
+        out << pad << "{" << std::endl;
+        writeNode(out, node.left, indent+4);
+        out << pad << "}" << std::endl;
+        out << pad << "else" << std::endl;
+        out << pad << "{" << std::endl;
+        writeNode(out, node.right, indent+4);
+        out << pad << "}" << std::endl;
+    }
+
+    void write(std::ostream& out, TString name, TString xmlfile)
+    {
+        out << "/////////////////////////////////////////////////////////////////////////////" << std::endl;
+        out << "// " << name << ".cxx" << std::endl;
+        out << "//=========================================================================//" << std::endl;
+        out << "// Written by ./generateCategorizer from " << xmlfile << std::endl;
+        out << "// " << xmlcat.categories.size() << " categories, " << xmlcat.flatNodes.size() << " nodes. Regenerate rather than edit." << std::endl;
+        out << "/////////////////////////////////////////////////////////////////////////////" << std::endl;
+        out << std::endl;
+        out << "#include \"CategorySelection.h\"" << std::endl;
+        out << std::endl;
+        out << "class " << name << " : public Categorizer" << std::endl;
+        out << "{" << std::endl;
+        out << "    public:" << std::endl;
+        out << "        " << name << "(){ initCategoryMap(); };" << std::endl;
+        out << std::endl;
+        out << "        VarSet::VarHandle h[" << (varnames.size() > 0 ? varnames.size() : 1) << "];" << std::endl;
+        out << "        bool resolved = false;" << std::endl;
+        out << std::endl;
+        out << "        void initCategoryMap()" << std::endl;
+        out << "        {" << std::endl;
+        for(Category* c: xmlcat.categories)
+        {
+            out << "            categoryMap[" << quote(c->key) << "] = Category(" << quote(c->key) << ", "
+                << (c->hide ? "true" : "false") << ", " << (c->isTerminal ? "true" : "false") << ");" << std::endl;
+            if(c->name != c->key)
+                out << "            categoryMap[" << quote(c->key) << "].name = " << quote(c->name) << ";" << std::endl;
+        }
+        out << "            indexCategories();" << std::endl;
+        out << "        };" << std::endl;
+        out << std::endl;
+        out << "        void evaluate(VarSet& vars)" << std::endl;
+        out << "        {" << std::endl;
+        out << "            if(!resolved)" << std::endl;
+        out << "            {" << std::endl;
+        for(unsigned int v=0; v<varnames.size(); v++)
+            out << "                h[" << v << "] = vars.getHandle(" << quote(varnames[v]) << ");" << std::endl;
+        out << "                resolved = true;" << std::endl;
+        out << "            }" << std::endl;
+        out << std::endl;
+        writeNode(out, 0, 12);
+        out << "        };" << std::endl;
+        out << "};" << std::endl;
+        out << std::endl;
+        out << "extern \"C\" Categorizer* createCategorizer_" << name << "()" << std::endl;
+        out << "{" << std::endl;
+        out << "    return new " << name << "();" << std::endl;
+        out << "}" << std::endl;
+    }
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+    if(argc < 3)
+    {
+        std::cout << "usage: ./generateCategorizer <xmlfile> <name> [outdir]" << std::endl;
+        return 1;
+    }
+
+    TString xmlfile = argv[1];
+    TString name = argv[2];
+    TString outdir = (argc > 3) ? argv[3] : "plugins/";
+    if(!outdir.EndsWith("/")) outdir += "/";
+
+    // the name is used for the class and the factory function
+    bool valid = name.Length() > 0 && !isdigit(name[0]);
+    for(int i=0; i<name.Length(); i++)
+        if(!isalnum(name[i]) && name[i] != '_') valid = false;
+    if(!valid)
+    {
+        std::cout << "!!! " << name << " is not a valid C++ identifier" << std::endl;
+        return 1;
+    }
+
+    XMLCategorizer xmlcat(xmlfile);
+    if(xmlcat.flatNodes.size() == 0)
+    {
+        std::cout << "!!! no categories in " << xmlfile << std::endl;
+        return 1;
+    }
+
+    gSystem->mkdir(outdir, true);
+    TString outfile = outdir+name+".cxx";
+    std::ofstream out(outfile.Data());
+    if(!out)
+    {
+        std::cout << "!!! could not open " << outfile << " for writing" << std::endl;
+        return 1;
+    }
+
+    Generator generator(xmlcat);
+    generator.write(out, name, xmlfile);
+    out.close();
+
+    std::cout << Form("  /// wrote %s: %d categories, %d nodes, %d split variables \n", outfile.Data(),
+                      (int)xmlcat.categories.size(), (int)xmlcat.flatNodes.size(), (int)generator.varnames.size());
+    std::cout << Form("  /// build it with: make %slib%s.so \n", outdir.Data(), name.Data());
+    return 0;
+}
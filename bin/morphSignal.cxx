@@ -0,0 +1,309 @@
+/////////////////////////////////////////////////////////////////////////////
+//                             morphSignal.cxx                             //
+//=========================================================================//
+//                                                                         //
+// Signal templates at any Higgs mass from the 120, 125, and 130 GeV ones  //
+// in a categorize output, by moment morphing, see                         //
+// lib/MomentMorphing.hxx. Every histogram in net_histos and signal_histos //
+// with _120 in its name is morphed together with the same name without    //
+// _120 (125 GeV) and with _130. The templates at the new masses are       //
+// named like the 120 GeV one with _120 replaced by _<mass>, e.g.          //
+// c_01_Net_Signal_122p5, and written with the same directories to --out.  //
+// Systematic suffixes carry through. --validate=1 morphs 125 GeV from     //
+// 120 and 130 GeV only and compares it with the 125 GeV sample.           //
+//                                                                         //
+// Set MAIN=morphSignal in the makefile then run via                       //
+// ./morphSignal --in=rootfiles/validate_....root --masses="121 122.5 124" //
+// ./morphSignal --in=rootfiles/validate_....hbnd --massMin=120 --massMax=130 --massStep=0.5
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+#include "MomentMorphing.hxx"
+#include "HistBundle.hxx"
+
+#include <sstream>
+#include <map>
+#include <vector>
+
+#include "TFile.h"
+#include "TKey.h"
+#include "TList.h"
+#include "TH1D.h"
+#include "TROOT.h"
+#include "TStopwatch.h"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct Settings
+{
+// default settings here, may be overwritten by terminal input, see main() below
+
+    TString in = "";              // categorize output, .root or .hbnd
+    TString out = "";             // default is the input with _morphed, same format
+    std::vector<double> masses;   // masses to make templates for
+    double massMin = 0;           // or a scan from massMin to massMax in massStep
+    double massMax = 0;
+    double massStep = 0;
+    bool validate = false;        // morph 125 GeV from 120 and 130 GeV and compare with the sample, the
+                                  // templates written are then made from 120 and 130 GeV only too
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+// the histograms of a directory by name
+typedef std::map<std::string, TH1D*> HistMap;
+
+void loadDirectory(TFile* file, const std::string& dirname, HistMap& histos)
+{
+    TDirectory* dir = file->GetDirectory(dirname.c_str());
+    if(dir == 0) return;
+
+    TIter next(dir->GetListOfKeys());
+    TKey* key = 0;
+    while((key = (TKey*)next()))
+    {
+        std::string name = key->GetName();
+        if(histos.count(name)) continue;    // keys are ordered by cycle, highest first
+        if(TString(key->GetClassName()) != "TH1D") continue;
+        histos[name] = (TH1D*)key->ReadObj();
+    }
+}
+
+void loadDirectory(HistBundle& bundle, const std::string& dirname, HistMap& histos)
+{
+    for(unsigned int i=0; i<bundle.entries.size(); i++)
+        if(bundle.entries[i].dir == dirname)
+            histos[bundle.entries[i].name] = bundle.getTH1D(i);
+}
+
+// 122.5 -> 122p5
+std::string massLabel(double mass)
+{
+    TString label = Form("%g", mass);
+    label.ReplaceAll(".", "p");
+    return label.Data();
+}
+
+// the name with the first _120 replaced by with, "" if it doesn't have _120
+std::string replace120(const std::string& name, const std::string& with)
+{
+    size_t i = name.find("_120");
+    if(i == std::string::npos) return "";
+    return name.substr(0, i)+with+name.substr(i+4);
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+    Settings settings;
+
+    for(int i=1; i<argc; i++)
+    {
+        std::stringstream ss;
+        TString in = argv[i];
+        TString option = in(0, in.First("="));
+        option = option.ReplaceAll("--", "");
+        TString value  = in(in.First("=")+1, in.Length());
+        value = value.ReplaceAll("\"", "");
+        ss << value.Data();
+
+        if(option=="in")                   settings.in = value;
+        else if(option=="out")             settings.out = value;
+        else if(option=="massMin")         ss >> settings.massMin;
+        else if(option=="massMax")         ss >> settings.massMax;
+        else if(option=="massStep")        ss >> settings.massStep;
+        else if(option=="validate")        ss >> settings.validate;
+        else if(option=="masses")
+        {
+            double mass;
+            while(ss >> mass) settings.masses.push_back(mass);
+        }
+        else
+        {
+            std::cout << Form("!!! %s is not a recognized option.", option.Data()) << std::endl;
+        }
+    }
+
+    gROOT->SetBatch();
+    TH1::AddDirectory(kFALSE);
+
+    if(settings.massStep > 0)
+        for(double m=settings.massMin; m<=settings.massMax+1e-9; m+=settings.massStep)
+            settings.masses.push_back(m);
+
+    bool bundleIO = settings.in.EndsWith(".hbnd");
+    if(!bundleIO && !settings.in.EndsWith(".root"))
+    {
+        std::cout << "!!! --in should be a .root or a .hbnd file" << std::endl;
+        return 1;
+    }
+    if(settings.out == "")
+    {
+        settings.out = settings.in;
+        settings.out.Replace(settings.out.Length()-5, 0, "_morphed");
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // Load the Signal Templates --------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    std::vector<std::string> dirs = {"net_histos", "signal_histos"};
+    std::map<std::string, HistMap> histos;
+
+    HistBundle inBundle;
+    TFile* infile = 0;
+    if(bundleIO)
+    {
+        if(!inBundle.open(settings.in.Data())) return 1;
+        for(auto& dir: dirs) loadDirectory(inBundle, dir, histos[dir]);
+    }
+    else
+    {
+        infile = TFile::Open(settings.in);
+        if(!infile || infile->IsZombie()) return 1;
+        for(auto& dir: dirs) loadDirectory(infile, dir, histos[dir]);
+    }
+
+    // the morphings are set up once, then each mass is a pass over the bins
+    struct MorphSet
+    {
+        std::string dir;
+        std::string name120;
+        std::string xtitle;
+        MomentMorphing morphing;
+        TH1D* h125 = 0;
+    };
+    std::vector<MorphSet> sets;
+
+    for(auto& dir: dirs)
+    {
+        for(auto& h: histos[dir])
+        {
+            std::string name125 = replace120(h.first, "");
+            std::string name130 = replace120(h.first, "_130");
+            if(name125 == "" || !histos[dir].count(name125) || !histos[dir].count(name130)) continue;
+
+            MorphSet set;
+            set.dir = dir;
+            set.name120 = h.first;
+            set.xtitle = h.second->GetXaxis()->GetTitle();
+            set.h125 = histos[dir][name125];
+
+            bool ok = set.morphing.addTemplate(120, MomentMorphing::fromTH1D(h.second));
+            if(!settings.validate) ok = ok && set.morphing.addTemplate(125, MomentMorphing::fromTH1D(set.h125));
+            ok = ok && set.morphing.addTemplate(130, MomentMorphing::fromTH1D(histos[dir][name130]));
+            if(!ok)
+            {
+                std::cout << Form("  !!! skipping %s/%s \n", dir.c_str(), h.first.c_str());
+                continue;
+            }
+            sets.push_back(set);
+        }
+    }
+    std::cout << Form("  /// %d signal template sets in %s \n", (int)sets.size(), settings.in.Data());
+
+    ///////////////////////////////////////////////////////////////////
+    // Validate: 125 from 120 and 130 --------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    if(settings.validate)
+    {
+        std::cout << std::endl;
+        std::cout << Form("  %-50s %12s %12s %10s \n", "125 GeV from 120 and 130", "yield", "morphed", "max dCDF");
+        for(auto& set: sets)
+        {
+            HistAccumulator truth = MomentMorphing::fromTH1D(set.h125);
+            HistAccumulator morphed = set.morphing.morph(125);
+
+            double ytruth = 0, ymorphed = 0;
+            for(int b=1; b<=truth.nbins; b++)
+            {
+                ytruth += truth.sumw[b];
+                ymorphed += morphed.sumw[b];
+            }
+
+            // largest difference of the normalized cumulative distributions, as in a KS test
+            double ctruth = 0, cmorphed = 0, dmax = 0;
+            for(int b=1; b<=truth.nbins && ytruth > 0 && ymorphed > 0; b++)
+            {
+                ctruth += truth.sumw[b]/ytruth;
+                cmorphed += morphed.sumw[b]/ymorphed;
+                dmax = std::max(dmax, std::fabs(ctruth-cmorphed));
+            }
+            std::cout << Form("  %-50s %12.5g %12.5g %10.4f \n", (set.dir+"/"+replace120(set.name120, "")).c_str(), ytruth, ymorphed, dmax);
+        }
+        std::cout << std::endl;
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // Morph ----------------------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    TStopwatch timerWatch;
+    timerWatch.Start();
+
+    std::vector< std::pair<std::string, TH1D*> > morphed;   // dir, histogram
+    for(double mass: settings.masses)
+    {
+        if(!sets.empty() && sets[0].morphing.extrapolates(mass))
+            std::cout << Form("  !!! %g GeV is outside of the templates, extrapolating \n", mass);
+
+        int nskipped = 0;
+        for(auto& set: sets)
+        {
+            HistAccumulator acc = set.morphing.morph(mass);
+            if(acc.nbins == 0)
+            {
+                nskipped++;
+                continue;
+            }
+            std::string name = replace120(set.name120, "_"+massLabel(mass));
+            TString title = Form("%s M%g", set.h125->GetTitle(), mass);
+            TH1D* h = acc.makeTH1D(name.c_str(), title);
+            h->GetXaxis()->SetTitle(set.xtitle.c_str());
+            morphed.push_back(std::make_pair(set.dir, h));
+        }
+        if(nskipped > 0)
+            std::cout << Form("  !!! %d templates at %g GeV skipped, the extrapolated width isn't positive \n", nskipped, mass);
+    }
+
+    timerWatch.Stop();
+    int nmorphed = morphed.size();
+    std::cout << Form("  /// %d templates at %d masses in %g ms, %g ms per template \n", nmorphed, (int)settings.masses.size(),
+                      1000*timerWatch.RealTime(), nmorphed > 0 ? 1000*timerWatch.RealTime()/nmorphed : 0.0);
+    if(nmorphed == 0) return 0;
+
+    ///////////////////////////////////////////////////////////////////
+    // Save -----------------------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    if(settings.out.EndsWith(".hbnd"))
+    {
+        HistBundle bundle;
+        for(auto& m: morphed) bundle.add(m.first, m.second);
+        if(!bundle.write(settings.out.Data())) return 1;
+    }
+    else
+    {
+        TFile* savefile = new TFile(settings.out, "RECREATE");
+        for(auto& dir: dirs)
+        {
+            TDirectory* tdir = savefile->mkdir(dir.c_str());
+            tdir->cd();
+            for(auto& m: morphed)
+                if(m.first == dir) m.second->Write();
+        }
+        savefile->Close();
+    }
+    std::cout << Form("  /// Saved the templates to %s \n", settings.out.Data());
+
+    if(infile) infile->Close();
+    return 0;
+}
@@ -20,12 +20,14 @@
 #include "JetCollectionCleaner.h"
 #include "MuonCollectionCleaner.h"
 #include "EleCollectionCleaner.h"
+#include "FusedCollectionCleaner.h"
 #include "SampleDatabase.cxx"
 
 #include "TMVATools.h"
 #include "EventTools.h"
 #include "PUTools.h"
 #include "ThreadPool.hxx"
+#include "HistAccumulator.hxx"
 
 #include "TLorentzVector.h"
 #include "TSystem.h"
@@ -154,7 +156,24 @@ Categorizer* getHistos(TString xmlfile, int nthreads, float reductionFactor, flo
     std::cout << "@@@ nCPUs used     : " << nthreads << std::endl;
     std::cout << "@@@ nSamples used  : " << samplevec.size() << std::endl;
 
-    auto outputSampleInfo = [xmlfile, luminosity, reductionFactor](Sample* s)
+    /////////////////////////////////////////////////////
+    // Load TMVA classifiers, once for all of the samples
+
+    TString dir    = "classification/";
+    //TString methodName = "BDTG_default";
+    TString methodName = "BDTG_UF_v1";
+
+    // sig vs bkg and multiclass (ggf, vbf, ... drell yan, ttbar) weight files
+    TString weightfile = dir+"f_Opt_v1_all_sig_all_bkg_ge0j_BDTG_UF_v1.weights.xml";
+    //TString weightfile = dir+"binaryclass_amc.weights.xml";
+
+    // the forest is read only after loading, so all of the threads share it
+    std::shared_ptr<const BDTForest> classifier = TMVATools::getClassifier(weightfile);
+    if(!classifier) return 0;
+
+    unsigned long long weightsHash = ScoreCache::hashWeights(weightfile.Data());
+
+    auto outputSampleInfo = [xmlfile, luminosity, reductionFactor, classifier, weightsHash](Sample* s)
     {
       // Output some info about the current file
       std::cout << Form("  /// Processing %s \n", s->name.Data());
@@ -167,38 +186,22 @@ Categorizer* getHistos(TString xmlfile, int nthreads, float reductionFactor, flo
       float massmax = 130;
 
 
-      /////////////////////////////////////////////////////
-      // Load TMVA classifiers
-    
-      TString dir    = "classification/";
-      //TString methodName = "BDTG_default";
-      TString methodName = "BDTG_UF_v1";
-
-
-      // sig vs bkg and multiclass (ggf, vbf, ... drell yan, ttbar) weight files
-      TString weightfile = dir+"f_Opt_v1_all_sig_all_bkg_ge0j_BDTG_UF_v1.weights.xml";
-      //TString weightfile = dir+"binaryclass_amc.weights.xml";
-
-      /////////////////////////////////////////////////////
-      // Book training and spectator vars into reader
-
-      TMVA::Reader* reader = 0;
-      std::map<TString, Float_t> tmap;
-      std::map<TString, Float_t> smap;
-
-      //TMVA::Reader* reader_multi = 0;
-      //std::map<TString, Float_t> tmap_multi;
-      //std::map<TString, Float_t> smap_multi;
+      // per thread classifier inputs, resolved to VarSet handles on the first event
+      ClassifierInputs bdtInputs;
 
-      // load tmva binary classification and multiclass classifiers
-      reader       = TMVATools::bookVars(methodName, weightfile, tmap, smap);
-      //reader_multi = TMVATools::bookVars(methodName, weightfile_multi, tmap_multi, smap_multi);
+      // classifier scores from earlier runs, the muon calibration is never changed here
+      ScoreCache scoreCache;
+      bool useScoreCache = scoreCache.open("rootfiles/score_cache/", s->name.Data(), weightsHash, "none", "");
 
       // Objects to help with the cuts and selections
       JetCollectionCleaner      jetCollectionCleaner;
       MuonCollectionCleaner     muonCollectionCleaner;
       EleCollectionCleaner      eleCollectionCleaner;
 
+      // muons, electrons, jets selected and cleaned from each other in one pass,
+      // configured from the cleaners above with dR = 0.4
+      FusedCollectionCleaner    fusedCollectionCleaner(jetCollectionCleaner, muonCollectionCleaner, eleCollectionCleaner, 0.4);
+
       Run2MuonSelectionCuts  run2MuonSelection;
       Run2EventSelectionCuts run2EventSelection;
 
@@ -236,6 +239,14 @@ Categorizer* getHistos(TString xmlfile, int nthreads, float reductionFactor, flo
             if(s->sampleType.Contains("background")) c.second.bkgList->Add(c.second.histoMap[hkeyw]); 
       }   
 
+      // the fills go to accumulators indexed by category id, put into the histograms after the event loop
+      std::vector<HistAccumulator> accn, accw;
+      for(auto& c: categorySelection->categories)
+      {
+          accn.push_back(HistAccumulator(c->histoMap[hkeyn]));
+          accw.push_back(HistAccumulator(c->histoMap[hkeyw]));
+      }
+
       for(unsigned int i=0; i<s->N/reductionFactor; i++)
       {
 
@@ -305,27 +316,16 @@ Categorizer* getHistos(TString xmlfile, int nthreads, float reductionFactor, flo
           // Load the rest of the information needed
           s->branches.getEntry(i);
 
-          // clear vectors for the valid collections
-          s->vars.validMuons.clear();
-          s->vars.validExtraMuons.clear();
-          s->vars.validElectrons.clear();
-          s->vars.validJets.clear();
-          s->vars.validBJets.clear();
-
-          // load valid collections from s->vars raw collections
-          jetCollectionCleaner.getValidJets(s->vars, s->vars.validJets, s->vars.validBJets);
-          muonCollectionCleaner.getValidMuons(s->vars, s->vars.validMuons, s->vars.validExtraMuons);
-          eleCollectionCleaner.getValidElectrons(s->vars, s->vars.validElectrons);
-
+          // load valid collections from s->vars raw collections.
           // Clean jets and electrons from muons, then clean remaining jets from remaining electrons
-          CollectionCleaner::cleanByDR(s->vars.validJets, s->vars.validMuons, 0.4);
-          CollectionCleaner::cleanByDR(s->vars.validElectrons, s->vars.validMuons, 0.4);
-          CollectionCleaner::cleanByDR(s->vars.validJets, s->vars.validElectrons, 0.4);
+          fusedCollectionCleaner.getValidCollections(s->vars);
 
           //std::cout << i << " !!! SETTING JETS " << std::endl;
           //s->vars.setJets();    // jets sorted and paired by mjj, turn this off to simply take the leading two jets
           s->vars.setVBFjets();   // jets sorted and paired by vbf criteria
-          s->vars.bdt_out = TMVATools::getClassifierScore(reader, methodName, tmap, s->vars); // set tmva's bdt score
+          int candidate = &dimu - &s->vars.muPairs->at(0);
+          s->vars.bdt_out = TMVATools::getClassifierScore(*classifier, bdtInputs, s->vars, // set tmva's bdt score
+                                                          useScoreCache?&scoreCache:0, i, candidate);
 
           categorySelection->evaluate(s->vars);
 
@@ -343,12 +343,13 @@ Categorizer* getHistos(TString xmlfile, int nthreads, float reductionFactor, flo
               bin =  diff/interval;
           }
 
-          // Look at each category
-          for(auto &c : categorySelection->categoryMap)
+          // Look at each category the event is in
+          double weight = s->getWeight();
+          for(int id : categorySelection->inIds)
           {
-              // if the event is in the current category then fill the category's histogram for the given sample and variable
-              if(c.second.inCategory) c.second.histoMap[hkeyn]->Fill(bin);
-              if(c.second.inCategory) c.second.histoMap[hkeyw]->Fill(bin, s->getWeight());
+              // fill the category's histogram for the given sample and variable
+              accn[id].fill(bin, 1);
+              accw[id].fill(bin, weight);
           } // end category loop
 
           if(found_good_dimuon) break; // only fill one dimuon, break from dimu cand loop
@@ -356,7 +357,13 @@ Categorizer* getHistos(TString xmlfile, int nthreads, float reductionFactor, flo
         } // end dimucand loop
       } // end event loop
 
-      delete reader;
+      if(useScoreCache) scoreCache.save();
+
+      for(auto& c: categorySelection->categories)
+      {
+          accn[c->id].fillTH1D(c->histoMap[hkeyn]);
+          accw[c->id].fillTH1D(c->histoMap[hkeyw]);
+      }
 
       for(auto& c : categorySelection->categoryMap)
       {
@@ -421,6 +428,9 @@ int main(int argc, char* argv[])
     // the number used to fill originally rather than the scaling
     TH1::SetDefaultSumw2();
 
+    // the histograms are booked in the threads, keep them out of gDirectory, which isn't thread safe
+    TH1::AddDirectory(kFALSE);
+
     TString xmlfile = "";
     int nthreads = 10;
     float reductionFactor = 1;
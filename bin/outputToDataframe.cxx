@@ -6,6 +6,13 @@
 // and their variables so that we can train a categorizer to make our      //
 // categories for us.                                                      //
 //                                                                         //
+// Each sample is written by its own thread to a ColumnarFrame, see        //
+// lib/ColumnarFrame.hxx, with the weight, the sample label, and the       //
+// is_signal class label as columns next to the features. The old csv and  //
+// TNtuple outputs are still there via --formats.                          //
+//                                                                         //
+// ./outputToDataframe --nthreads=10 --formats=frame,csv --rowGroup=65536  //
+//                                                                         //
 /////////////////////////////////////////////////////////////////////////////
 
 
@@ -23,6 +30,7 @@
 #include "TMVATools.h"
 #include "PUTools.h"
 #include "ThreadPool.hxx"
+#include "ColumnarFrame.hxx"
 
 #include "TLorentzVector.h"
 #include "TSystem.h"
@@ -32,6 +40,22 @@
 #include <map>
 #include <vector>
 #include <utility>
+#include <algorithm>
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct Settings
+{
+// default settings here, may be overwritten by terminal input, see main() below
+
+    int nthreads = 10;                       // number of threads to use in parallelization
+    TString formats = "frame";               // comma separated outputs: frame, csv, ntuple
+    TString framedir = "dataframes/bdt/";    // where the frames go
+    unsigned long long rowGroup = 65536;     // rows per row group in the frames
+    bool compress = true;                    // zlib compress the frame chunks when it saves space
+};
 
 //////////////////////////////////////////////////////////////////
 //---------------------------------------------------------------
@@ -54,14 +78,43 @@ int main(int argc, char* argv[])
     // save the errors for the histogram correctly so they depend upon 
     // the number used to fill originally rather than the scaling
     TH1::SetDefaultSumw2();
-    int nthreads = 10;
+    Settings settings;
 
     for(int i=1; i<argc; i++)
-    {   
-        std::stringstream ss; 
-        ss << argv[i];
-        ss >> nthreads;
-    }   
+    {
+        std::stringstream ss;
+        TString in = argv[i];
+
+        // a bare number is the number of threads, as before
+        if(!in.Contains("="))
+        {
+            ss << in.Data();
+            ss >> settings.nthreads;
+            continue;
+        }
+
+        TString option = in(0, in.First("="));
+        option = option.ReplaceAll("--", "");
+        TString value  = in(in.First("=")+1, in.Length());
+        value = value.ReplaceAll("\"", "");
+        ss << value.Data();
+
+        if(option=="nthreads")             ss >> settings.nthreads;
+        else if(option=="formats")         settings.formats = value;
+        else if(option=="framedir")        settings.framedir = value;
+        else if(option=="rowGroup")        ss >> settings.rowGroup;
+        else if(option=="compress")        ss >> settings.compress;
+        else
+        {
+            std::cout << Form("!!! %s is not a recognized option.", option.Data()) << std::endl;
+        }
+    }
+
+    int nthreads = settings.nthreads;
+    bool writeFrame  = settings.formats.Contains("frame");
+    bool writeCSV    = settings.formats.Contains("csv");
+    bool writeNtuple = settings.formats.Contains("ntuple");
+    if(writeFrame) gSystem->mkdir(settings.framedir, true);
 
     // Not sure that we need a map if we have a vector
     // Should use this as the main database and choose from it to make the vector
@@ -119,37 +172,43 @@ int main(int argc, char* argv[])
     std::cout << "@@@ nCPUs used     : " << nthreads << std::endl;
     std::cout << "@@@ nSamples used  : " << samplevec.size() << std::endl;
 
-    auto outputSampleInfo = [whichDY, luminosity, reductionFactor](Sample* s)
-    {
-      // Output some info about the current file
-      std::cout << Form("  /// Processing %s \n", s->name.Data());
+    // dictionary of the sample label column, the same in every frame so they can be concatenated
+    std::vector<std::string> sampleNames;
+    for(auto& s: samplevec)
+        sampleNames.push_back(s->name.Data());
 
-      TString dir    = "classification/";
-      //TString methodName = "BDTG_default";
-      TString methodName = "BDTG_UF_v1";
+    /////////////////////////////////////////////////////
+    // Load TMVA classifiers, once for all of the samples
 
-      // classification and multiclassification
-      //TString weightfile = dir+"f_Opt1_all_sig_all_bkg_ge0j_BDTG_default.weights.xml";                       // >= 0j, use as inclusive
-      //TString weightfile = dir+"f_Opt3_oneClass_all_sig_all_bkg_eq2j_eq0b_met80_BDTG_default.weights.xml";   // == 2j, 0b, met<80
-      TString weightfile = dir+"f_Opt_v1_all_sig_all_bkg_ge0j_BDTG_UF_v1.weights.xml";           // TMVA binary classification 1/2 sig for training
-      //TString weightfile = dir+"binaryclass_amc.weights.xml";           // TMVA binary classification 1/2 sig for training, dy_amc@nlo
+    TString dir    = "classification/";
+    //TString methodName = "BDTG_default";
+    TString methodName = "BDTG_UF_v1";
 
-      //TString weightfile_multi = dir+"f_Opt2_all_sig_all_bkg_ge0j_eq0b_BDTG_default.weights.xml";              // assumes 0b jets, but use as inclusive
-      //TString weightfile_multi = dir+"f_Opt3_all_sig_all_bkg_eq2j_eq0b_met80_BDTG_default.weights.xml";        // == 2j, 0b, met < 80
-      //TString weightfile_multi = dir+"f_Opt3_half_all_sig_all_bkg_ge0j_eq0b_met80_BDTG_default.weights.xml";   // >= 0 jets, 0b, met < 80
-      //TString weightfile_multi = dir+"f_Opt_v1_multi_all_sig_all_bkg_ge0j_BDTG_UF_v1.weights.xml";   // TMVA multiclass 1/2 sig for training
+    // classification and multiclassification
+    //TString weightfile = dir+"f_Opt1_all_sig_all_bkg_ge0j_BDTG_default.weights.xml";                       // >= 0j, use as inclusive
+    //TString weightfile = dir+"f_Opt3_oneClass_all_sig_all_bkg_eq2j_eq0b_met80_BDTG_default.weights.xml";   // == 2j, 0b, met<80
+    TString weightfile = dir+"f_Opt_v1_all_sig_all_bkg_ge0j_BDTG_UF_v1.weights.xml";           // TMVA binary classification 1/2 sig for training
+    //TString weightfile = dir+"binaryclass_amc.weights.xml";           // TMVA binary classification 1/2 sig for training, dy_amc@nlo
 
+    //TString weightfile_multi = dir+"f_Opt2_all_sig_all_bkg_ge0j_eq0b_BDTG_default.weights.xml";              // assumes 0b jets, but use as inclusive
+    //TString weightfile_multi = dir+"f_Opt3_all_sig_all_bkg_eq2j_eq0b_met80_BDTG_default.weights.xml";        // == 2j, 0b, met < 80
+    //TString weightfile_multi = dir+"f_Opt3_half_all_sig_all_bkg_ge0j_eq0b_met80_BDTG_default.weights.xml";   // >= 0 jets, 0b, met < 80
+    //TString weightfile_multi = dir+"f_Opt_v1_multi_all_sig_all_bkg_ge0j_BDTG_UF_v1.weights.xml";   // TMVA multiclass 1/2 sig for training
 
-      /////////////////////////////////////////////////////
-      // Book training and spectator vars into reader
+    // the forests are read only after loading, so all of the threads share them
+    std::shared_ptr<const BDTForest> classifier = TMVATools::getClassifier(weightfile);
+    //std::shared_ptr<const BDTForest> classifier_multi = TMVATools::getClassifier(weightfile_multi);
+    if(!classifier) return 1;
 
-      std::map<TString, Float_t> tmap;
-      std::map<TString, Float_t> smap;
-      TMVA::Reader* reader = TMVATools::bookVars(methodName, weightfile, tmap, smap);
+    auto outputSampleInfo = [whichDY, luminosity, reductionFactor, classifier, settings, sampleNames,
+                             writeFrame, writeCSV, writeNtuple](Sample* s)
+    {
+      // Output some info about the current file
+      std::cout << Form("  /// Processing %s \n", s->name.Data());
 
-      //std::map<TString, Float_t> tmap_multi;
-      //std::map<TString, Float_t> smap_multi;
-      //TMVA::Reader* reader_multi = TMVATools::bookVars(methodName, weightfile_multi, tmap_multi, smap_multi);
+      // per thread classifier inputs, resolved to VarSet handles on the first event
+      ClassifierInputs bdtInputs;
+      //ClassifierInputs bdtInputs_multi;
 
       bool isData = s->sampleType == "data";
       bool isSignal = s->sampleType == "signal";
@@ -180,14 +239,47 @@ int main(int argc, char* argv[])
           vars[item.first.c_str()] = -999;
 
       // !!!! output first line of csv to file
-      std::ofstream file(Form("csv/bdtcsv/%s_bdt_training_%s.csv", s->name.Data(), whichDY.Data()), std::ofstream::out);
-      file << EventTools::outputMapKeysCSV(vars).Data() << std::endl;
+      std::ofstream file;
+      if(writeCSV)
+      {
+          file.open(Form("csv/bdtcsv/%s_bdt_training_%s.csv", s->name.Data(), whichDY.Data()), std::ofstream::out);
+          file << EventTools::outputMapKeysCSV(vars).Data() << std::endl;
+      }
 
       // ntuple requires list of variables to be separated by ":" rather than ","
-      TString ntuplevars = EventTools::outputMapKeysCSV(vars).ReplaceAll(",", ":");
-      //std::cout << Form("\n   /// Vars to be saved in ntuple \n\n");
-      //std::cout << Form("%s\n", ntuplevars.Data());
-      TNtuple* ntuple = new TNtuple(s->name.Data(), s->name.Data(), ntuplevars.Data());
+      TNtuple* ntuple = 0;
+      if(writeNtuple)
+      {
+          TString ntuplevars = EventTools::outputMapKeysCSV(vars).ReplaceAll(",", ":");
+          ntuple = new TNtuple(s->name.Data(), s->name.Data(), ntuplevars.Data());
+      }
+
+      // the frame has one column per key of vars in the same order, the features are float
+      // like the VarSet members they come from, the labels are int, the weight is double.
+      // The last column is the sample label, only in the frame, as its code in the dictionary.
+      int sampleCode = std::find(sampleNames.begin(), sampleNames.end(), std::string(s->name.Data())) - sampleNames.begin();
+      ColumnarFrameWriter frame;
+      std::vector<double> row(vars.size()+1);
+      row[vars.size()] = sampleCode;
+      if(writeFrame)
+      {
+          frame.rowGroupSize = settings.rowGroup;
+          frame.compress = settings.compress;
+          for(auto& item: vars)
+          {
+              if(item.first == "weight")         frame.addColumn("weight", kFrameFloat64);
+              else if(item.first == "bin" || item.first == "is_signal") frame.addColumn(item.first.Data(), kFrameInt32);
+              else frame.addColumn(item.first.Data(), kFrameFloat32);
+          }
+          frame.addColumn("sample", kFrameCategory, sampleNames);
+          frame.addMetadata("sample", s->name.Data());
+          frame.addMetadata("sampleType", s->sampleType.Data());
+          frame.addMetadata("xsec", Form("%.17g", s->xsec));
+          frame.addMetadata("luminosity", Form("%.17g", luminosity));
+          frame.addMetadata("whichDY", whichDY.Data());
+          if(!frame.open(Form("%s%s_bdt_training_%s.cfr", settings.framedir.Data(), s->name.Data(), whichDY.Data())))
+              return ntuple;
+      }
 
       // Objects to help with the cuts and selections
       JetCollectionCleaner      jetCollectionCleaner;
@@ -325,10 +417,10 @@ int main(int argc, char* argv[])
           if(isSignal) vars["weight"] = vars["weight"]*2;
 
           // set tmva's bdt_score
-          s->vars.bdt_out = TMVATools::getClassifierScore(reader, methodName, tmap, s->vars);
+          s->vars.bdt_out = TMVATools::getClassifierScore(*classifier, bdtInputs, s->vars);
 
           // load multi results into varset
-          //std::vector<float> bdt_multi_scores = TMVATools::getMulticlassScores(reader_multi, methodName, tmap_multi, s->vars);
+          //std::vector<float> bdt_multi_scores = TMVATools::getMulticlassScores(*classifier_multi, bdtInputs_multi, s->vars);
           //s->vars.bdt_ggh_out = bdt_multi_scores[0];
           //s->vars.bdt_vbf_out = bdt_multi_scores[1];
           //s->vars.bdt_vh_out  = bdt_multi_scores[2];
@@ -364,26 +456,32 @@ int main(int argc, char* argv[])
             EventTools::outputEvent(s->vars, (*categorySelection));
 
           // !!!! output event info to file
-          file << EventTools::outputMapValuesCSV(vars).Data() << std::endl;
+          if(writeCSV) file << EventTools::outputMapValuesCSV(vars).Data() << std::endl;
 
-          std::vector<Float_t> varvalues;
-          //std::cout << Form("\n   /// Vars to be saved \n\n");
-          for(auto& item: vars)
+          if(writeFrame)
           {
-              //std::cout << Form("%s: %f\n", item.first.Data(), item.second);
-              varvalues.push_back((Float_t)item.second);
+              unsigned int c = 0;
+              for(auto& item: vars)
+                  row[c++] = item.second;
+              frame.fill(row);
           }
 
-          // fill the ntuple
-          ntuple->Fill(&varvalues[0]);
+          if(writeNtuple)
+          {
+              std::vector<Float_t> varvalues;
+              for(auto& item: vars)
+                  varvalues.push_back((Float_t)item.second);
+
+              // fill the ntuple
+              ntuple->Fill(&varvalues[0]);
+          }
 
           if(found_good_dimuon) break; // only fill one dimuon, break from dimu cand loop
 
         } // end dimucand loop
       } // end event loop
-      delete reader;
-      //delete reader_multi;
-      file.close();
+      if(writeCSV) file.close();
+      if(writeFrame) frame.close();
 
       std::cout << Form("  /// Done processing %s \n", s->name.Data());
       return ntuple;
@@ -404,6 +502,7 @@ int main(int argc, char* argv[])
 
     for(auto& ntuple: ntuples)
     {
+        if(ntuple == 0) continue;
         TString sname = ntuple->GetName();
         ntuple->SetName("theNtuple");
         ntuple->SetTitle("theNtuple");
@@ -0,0 +1,263 @@
+/////////////////////////////////////////////////////////////////////////////
+//                             queryCube.cxx                               //
+//=========================================================================//
+//                                                                         //
+// Project a ResultCube written by ./categorize --cube=... back into       //
+// histograms for any variable, systematic, and calibration in the cube,   //
+// without rerunning over the samples. The output TFile has the same       //
+// signal_histos, bg_histos, data_histos, and net_histos directories as    //
+// the categorize output. The stack plots are not remade. If categorize   //
+// ran with --sig_xlumi=0 the signal histos are unscaled by lumi*xsec      //
+// after the net histos are made, as in categorize.                        //
+//                                                                         //
+// Set MAIN=queryCube in the makefile then run via                         //
+// ./queryCube --cube=rootfiles/cube.rcub --list=1                         //
+// ./queryCube --cube=rootfiles/cube.rcub --var=dimu_mass_Roch --systematic=JES_up --out=rootfiles/query.root
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+#include "DiMuPlottingSystem.h"
+#include "ResultCube.hxx"
+
+#include <sstream>
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include "TFile.h"
+#include "TList.h"
+#include "TH1D.h"
+#include "TROOT.h"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct Settings
+{
+// default settings here, may be overwritten by terminal input, see main() below
+
+    TString cube = "";                   // ResultCube file from categorize
+    TString var = "dimu_mass_Roch";      // variable to project
+    TString systematic = "";             // "" is the nominal
+    TString calibration = "Roch";        // PF, Roch, or KaMu
+    std::vector<TString> categories;     // empty for all of the categories in the cube
+    std::vector<TString> samples;        // empty for all of the samples in the cube
+    TString out = "rootfiles/query_cube.root";
+    bool list = false;                   // print the axes of the cube and exit
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+void listCube(const ResultCube& cube)
+{
+    auto printAxis = [](const char* title, const std::vector<std::string>& axis)
+    {
+        std::cout << Form("  %-14s (%d):", title, (int)axis.size());
+        for(auto& a: axis) std::cout << " " << (a == ""?"\"\"":a);
+        std::cout << std::endl;
+    };
+
+    printAxis("categories", cube.categories);
+    printAxis("samples", cube.samples);
+    printAxis("systematics", cube.systematics);
+    printAxis("calibrations", cube.calibrations);
+    std::cout << Form("  %-14s %g pb-1, sig_xlumi %d", "luminosity", cube.luminosity, (int)cube.sigXlumi) << std::endl;
+
+    std::cout << Form("  %-14s (%d):", "variables", (int)cube.variables.size());
+    for(auto& v: cube.variables)
+    {
+        if(v.edges.empty()) std::cout << Form(" %s[%d,%g,%g]", v.name.c_str(), v.nbins, v.min, v.max);
+        else std::cout << Form(" %s[%d variable bins]", v.name.c_str(), v.nbins);
+    }
+    std::cout << std::endl;
+    std::cout << Form("  %d slices", (int)cube.slices.size()) << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+    Settings settings;
+
+    for(int i=1; i<argc; i++)
+    {
+        std::stringstream ss;
+        TString in = argv[i];
+        TString option = in(0, in.First("="));
+        option = option.ReplaceAll("--", "");
+        TString value  = in(in.First("=")+1, in.Length());
+        value = value.ReplaceAll("\"", "");
+        ss << value.Data();
+
+        if(option=="cube")                 settings.cube = value;
+        else if(option=="var")             settings.var = value;
+        else if(option=="systematic")      settings.systematic = value;
+        else if(option=="calibration")     settings.calibration = value;
+        else if(option=="out")             settings.out = value;
+        else if(option=="list")            ss >> settings.list;
+        else if(option=="categories" || option=="samples")
+        {
+            TString tok;
+            Ssiz_t from = 0;
+            while (value.Tokenize(tok, from, " "))
+            {
+                if(option=="categories") settings.categories.push_back(tok);
+                else settings.samples.push_back(tok);
+            }
+        }
+        else
+        {
+            std::cout << Form("!!! %s is not a recognized option.", option.Data()) << std::endl;
+        }
+    }
+
+    gROOT->SetBatch();
+    TH1::AddDirectory(kFALSE);
+
+    ResultCube cube;
+    if(!cube.read(settings.cube.Data())) return 1;
+
+    if(settings.list)
+    {
+        listCube(cube);
+        return 0;
+    }
+
+    int v = cube.findVariable(settings.var.Data());
+    int syst = ResultCube::find(cube.systematics, settings.systematic.Data());
+    int nominal = ResultCube::find(cube.systematics, "");
+    int calib = ResultCube::find(cube.calibrations, settings.calibration.Data());
+    if(v < 0 || syst < 0 || calib < 0)
+    {
+        std::cout << Form("!!! %s, systematic \"%s\", or calibration %s is not in the cube, see --list=1 \n",
+                          settings.var.Data(), settings.systematic.Data(), settings.calibration.Data());
+        return 1;
+    }
+    const CubeVariable& var = cube.variables[v];
+
+    // axis indices of the selected categories and samples
+    std::vector<int> categories;
+    std::vector<int> samples;
+    for(unsigned int c=0; c<cube.categories.size(); c++)
+        if(settings.categories.empty() || std::find(settings.categories.begin(), settings.categories.end(), cube.categories[c].c_str()) != settings.categories.end())
+            categories.push_back(c);
+    for(unsigned int s=0; s<cube.samples.size(); s++)
+        if(settings.samples.empty() || std::find(settings.samples.begin(), settings.samples.end(), cube.samples[s].c_str()) != settings.samples.end())
+            samples.push_back(s);
+
+    TString suffix = "";
+    if(settings.systematic != "") suffix = "_"+settings.systematic;
+
+    ///////////////////////////////////////////////////////////////////
+    // Project the slices ---------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    TList* signallist = new TList();     // list to save all of the signal histos
+    TList* bglist = new TList();         // list to save all of the background histos
+    TList* datalist = new TList();       // list to save all of the data histos
+    TList* netlist = new TList();        // list to save all of the net histos
+
+    for(int c: categories)
+    {
+        TString cname = cube.categories[c].c_str();
+
+        TList* histoList = new TList();
+        TList* signalList = new TList();
+        TList* signalList120 = new TList();
+        TList* signalList125 = new TList();
+        TList* signalList130 = new TList();
+        TList* bkgList = new TList();
+        TList* dataList = new TList();
+        std::vector< std::pair<TH1D*, double> > unscale;   // signal histos and their lumi*xsec if sig_xlumi is false
+
+        for(int s: samples)
+        {
+            TString sname = cube.samples[s].c_str();
+            bool isData = cube.sampleTypes[s] == "data";
+
+            // data is the same for every systematic, categorize doesn't add the suffix to it either
+            const CubeSlice* slice = cube.getSlice(c, s, syst, calib, v);
+            if(slice == 0 && isData && nominal >= 0) slice = cube.getSlice(c, s, nominal, calib, v);
+            if(slice == 0) continue;
+
+            TString hname = cname+"_"+sname;
+            if(!isData) hname += suffix;
+
+            HistAccumulator acc = var.makeAccumulator();
+            ResultCube::addSlice(*slice, acc);
+            TH1D* hist = acc.makeTH1D(hname, hname);
+            hist->GetXaxis()->SetTitle(var.name.c_str());
+
+            histoList->Add(hist);
+            if(cube.sampleTypes[s] == "signal")
+            {
+                signalList->Add(hist);
+                if(cube.signalUnscale(s) != 1) unscale.push_back(std::make_pair(hist, cube.signalUnscale(s)));
+                if(sname.Contains("_120")) signalList120->Add(hist);
+                else if(sname.Contains("_130")) signalList130->Add(hist);
+                else signalList125->Add(hist);
+            }
+            else if(cube.sampleTypes[s] == "background") bkgList->Add(hist);
+            else dataList->Add(hist);
+        }
+
+        if(histoList->GetSize() == 0) continue;
+
+        if(signalList120->GetSize() > 0) netlist->Add(DiMuPlottingSystem::addHists(signalList120, cname+"_Net_Signal_120"+suffix, "Net Signal M120"));
+        if(signalList125->GetSize() > 0) netlist->Add(DiMuPlottingSystem::addHists(signalList125, cname+"_Net_Signal"+suffix, "Net Signal"));
+        if(signalList130->GetSize() > 0) netlist->Add(DiMuPlottingSystem::addHists(signalList130, cname+"_Net_Signal_130"+suffix, "Net Signal M130"));
+        if(bkgList->GetSize() > 0)       netlist->Add(DiMuPlottingSystem::addHists(bkgList, cname+"_Net_Bkg"+suffix, "Net Background"));
+
+        TList* groupedlist = DiMuPlottingSystem::groupMC(histoList, cname, suffix);
+        if(dataList->GetSize() > 0)
+        {
+            TH1D* hNetData = DiMuPlottingSystem::addHists(dataList, cname+"_Net_Data"+suffix, "Data");
+            netlist->Add(hNetData);
+            groupedlist->Add(hNetData);
+        }
+        netlist->Add(groupedlist);
+
+        // unscale the lumi*xsec part of the normalization for limit setting, same as categorize
+        for(auto& u: unscale)
+            u.first->Scale(1/u.second);
+
+        signallist->Add(signalList);
+        bglist->Add(bkgList);
+        datalist->Add(dataList);
+
+        std::cout << Form("  /// %s: %d histos \n", cname.Data(), histoList->GetSize());
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // Save the Histos ------------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    std::cout << "  /// Saving histos to " << settings.out << " ..." << std::endl;
+
+    TFile* savefile = new TFile(settings.out, "RECREATE");
+
+    TDirectory* signal_histos = savefile->mkdir("signal_histos");
+    TDirectory* bg_histos     = savefile->mkdir("bg_histos");
+    TDirectory* data_histos   = savefile->mkdir("data_histos");
+    TDirectory* net_histos    = savefile->mkdir("net_histos");
+
+    signal_histos->cd();
+    signallist->Write();
+
+    bg_histos->cd();
+    bglist->Write();
+
+    data_histos->cd();
+    datalist->Write();
+
+    net_histos->cd();
+    netlist->Write();
+
+    savefile->Close();
+    return 0;
+}
@@ -0,0 +1,274 @@
+/////////////////////////////////////////////////////////////////////////////
+//                            rebinMasses.cxx                              //
+//=========================================================================//
+//                                                                         //
+// Make the categorize dimu_mass histograms with any binning, range, and   //
+// blinding window from the unbinned MassRecord that                       //
+// ./categorize --massRecord=... writes, without rerunning over the        //
+// samples. The output TFile has the same signal_histos, bg_histos,        //
+// data_histos, and net_histos directories as the categorize output, one   //
+// set of histograms for each systematic in the record. The stack plots    //
+// are not remade. The masses are stored as float, so an event right on a  //
+// bin edge can land in the other bin than in categorize in rare cases.    //
+//                                                                         //
+// Set MAIN=rebinMasses in the makefile then run via                       //
+// ./rebinMasses --in=rootfiles/masses.mrec --bins=100 --min=110 --max=160 --blind=1
+// ./rebinMasses --in=rootfiles/masses.mrec --edges="110 115 120 122 124 126 128 130 135 140 150 160"
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+#include "DiMuPlottingSystem.h"
+#include "HistAccumulator.hxx"
+#include "MassRecord.hxx"
+
+#include <sstream>
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include "TFile.h"
+#include "TList.h"
+#include "TH1D.h"
+#include "TROOT.h"
+#include "TStopwatch.h"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct Settings
+{
+// default settings here, may be overwritten by terminal input, see main() below
+
+    TString in = "";                     // MassRecord file from categorize
+    TString out = "rootfiles/rebinned_masses.root";
+    TString calibration = "";            // mass column to use PF, Roch, or KaMu, "" for the one the run selected with
+    int bins = 50;
+    double min = 110;
+    double max = 160;
+    std::vector<double> edges;           // variable binning, overrides bins, min, max
+    bool blind = false;                  // drop data in the blinding window
+    double blindMin = 120;
+    double blindMax = 130;
+    std::vector<TString> categories;     // empty for all of the categories in the record
+    std::vector<TString> systematics;    // empty for all of the systematics in the record, "nominal" for ""
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+    Settings settings;
+
+    for(int i=1; i<argc; i++)
+    {
+        std::stringstream ss;
+        TString in = argv[i];
+        TString option = in(0, in.First("="));
+        option = option.ReplaceAll("--", "");
+        TString value  = in(in.First("=")+1, in.Length());
+        value = value.ReplaceAll("\"", "");
+        ss << value.Data();
+
+        if(option=="in")                   settings.in = value;
+        else if(option=="out")             settings.out = value;
+        else if(option=="calibration")     settings.calibration = value;
+        else if(option=="bins")            ss >> settings.bins;
+        else if(option=="min")             ss >> settings.min;
+        else if(option=="max")             ss >> settings.max;
+        else if(option=="blind")           ss >> settings.blind;
+        else if(option=="blindMin")        ss >> settings.blindMin;
+        else if(option=="blindMax")        ss >> settings.blindMax;
+        else if(option=="edges" || option=="categories" || option=="systematics")
+        {
+            TString tok;
+            Ssiz_t from = 0;
+            while (value.Tokenize(tok, from, " "))
+            {
+                if(option=="edges") settings.edges.push_back(tok.Atof());
+                else if(option=="categories") settings.categories.push_back(tok);
+                else settings.systematics.push_back(tok=="nominal"?"":tok);
+            }
+        }
+        else
+        {
+            std::cout << Form("!!! %s is not a recognized option.", option.Data()) << std::endl;
+        }
+    }
+
+    gROOT->SetBatch();
+    TH1::AddDirectory(kFALSE);
+
+    TStopwatch timerWatch;
+    timerWatch.Start();
+
+    MassRecord record;
+    if(!record.read(settings.in.Data())) return 1;
+
+    if(settings.calibration == "") settings.calibration = record.calibration.c_str();
+    const std::vector<float>* mass = record.massColumn(settings.calibration.Data());
+    if(mass == 0)
+    {
+        std::cout << Form("!!! %s is not a calibration, use PF, Roch, or KaMu \n", settings.calibration.Data());
+        return 1;
+    }
+    if(settings.calibration != record.calibration.c_str())
+        std::cout << Form("  !!! the events were selected and categorized with %s, filling the %s mass \n",
+                          record.calibration.c_str(), settings.calibration.Data());
+
+    // a repeated edge would make a zero width bin
+    std::sort(settings.edges.begin(), settings.edges.end());
+    unsigned int nedges = settings.edges.size();
+    settings.edges.erase(std::unique(settings.edges.begin(), settings.edges.end()), settings.edges.end());
+    if(settings.edges.size() < nedges)
+        std::cout << Form("  !!! removed %d repeated --edges \n", (int)(nedges-settings.edges.size()));
+    if(settings.edges.size() == 1)
+    {
+        std::cout << "!!! --edges needs at least two edges" << std::endl;
+        return 1;
+    }
+    HistAccumulator binning = settings.edges.empty() ? HistAccumulator(settings.bins, settings.min, settings.max)
+                                                     : HistAccumulator(settings.edges);
+
+    int ncategories = record.categories.size();
+    int nsamples = record.samples.size();
+    int nsystematics = record.systematics.size();
+
+    ///////////////////////////////////////////////////////////////////
+    // Fill -----------------------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    // acc[(systematic*ncategories + category)*nsamples + sample], the weights get the sample
+    // normalization after the loop like the categorize histograms
+    std::vector<HistAccumulator> acc(nsystematics*ncategories*nsamples, binning);
+    std::vector<bool> isData(nsamples);
+    for(int s=0; s<nsamples; s++)
+        isData[s] = record.sampleTypes[s] == "data";
+
+    for(unsigned long long i=0; i<record.size(); i++)
+    {
+        float m = (*mass)[i];
+        if(settings.blind && isData[record.sample[i]] && m > settings.blindMin && m < settings.blindMax) continue;
+        acc[(record.systematic[i]*ncategories + record.category[i])*nsamples + record.sample[i]].fill(m, record.weight[i]);
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // Make the histos ------------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    TList* signallist = new TList();     // list to save all of the signal histos
+    TList* bglist = new TList();         // list to save all of the background histos
+    TList* datalist = new TList();       // list to save all of the data histos
+    TList* netlist = new TList();        // list to save all of the net histos
+
+    int nominal = -1;
+    for(int syst=0; syst<nsystematics; syst++)
+        if(record.systematics[syst] == "") nominal = syst;
+
+    for(int syst=0; syst<nsystematics; syst++)
+    {
+        TString systematic = record.systematics[syst].c_str();
+        if(!settings.systematics.empty() && std::find(settings.systematics.begin(), settings.systematics.end(), systematic) == settings.systematics.end())
+            continue;
+
+        TString suffix = "";
+        if(systematic != "") suffix = "_"+systematic;
+
+        for(int c=0; c<ncategories; c++)
+        {
+            TString cname = record.categories[c].c_str();
+            if(!settings.categories.empty() && std::find(settings.categories.begin(), settings.categories.end(), cname) == settings.categories.end())
+                continue;
+
+            TList* histoList = new TList();
+            TList* signalList = new TList();
+            TList* signalList120 = new TList();
+            TList* signalList125 = new TList();
+            TList* signalList130 = new TList();
+            TList* bkgList = new TList();
+            TList* dataList = new TList();
+
+            for(int s=0; s<nsamples; s++)
+            {
+                TString sname = record.samples[s].c_str();
+                HistAccumulator* a = &acc[(syst*ncategories + c)*nsamples + s];
+
+                // data is the same for every systematic, categorize doesn't add the suffix to it either
+                if(isData[s] && a->entries == 0 && nominal >= 0) a = &acc[(nominal*ncategories + c)*nsamples + s];
+                if(a->entries == 0) continue;
+
+                TString hname = cname+"_"+sname;
+                if(!isData[s]) hname += suffix;
+
+                HistAccumulator scaled = binning;
+                scaled.add(*a, record.sampleScales[s]);
+                TH1D* hist = scaled.makeTH1D(hname, hname);
+                hist->GetXaxis()->SetTitle("dimu_mass_"+settings.calibration);
+
+                histoList->Add(hist);
+                if(record.sampleTypes[s] == "signal")
+                {
+                    signalList->Add(hist);
+                    if(sname.Contains("_120")) signalList120->Add(hist);
+                    else if(sname.Contains("_130")) signalList130->Add(hist);
+                    else signalList125->Add(hist);
+                }
+                else if(record.sampleTypes[s] == "background") bkgList->Add(hist);
+                else dataList->Add(hist);
+            }
+
+            if(histoList->GetSize() == 0) continue;
+
+            if(signalList120->GetSize() > 0) netlist->Add(DiMuPlottingSystem::addHists(signalList120, cname+"_Net_Signal_120"+suffix, "Net Signal M120"));
+            if(signalList125->GetSize() > 0) netlist->Add(DiMuPlottingSystem::addHists(signalList125, cname+"_Net_Signal"+suffix, "Net Signal"));
+            if(signalList130->GetSize() > 0) netlist->Add(DiMuPlottingSystem::addHists(signalList130, cname+"_Net_Signal_130"+suffix, "Net Signal M130"));
+            if(bkgList->GetSize() > 0)       netlist->Add(DiMuPlottingSystem::addHists(bkgList, cname+"_Net_Bkg"+suffix, "Net Background"));
+
+            TList* groupedlist = DiMuPlottingSystem::groupMC(histoList, cname, suffix);
+            if(dataList->GetSize() > 0)
+            {
+                TH1D* hNetData = DiMuPlottingSystem::addHists(dataList, cname+"_Net_Data"+suffix, "Data");
+                netlist->Add(hNetData);
+                groupedlist->Add(hNetData);
+            }
+            netlist->Add(groupedlist);
+
+            signallist->Add(signalList);
+            bglist->Add(bkgList);
+            datalist->Add(dataList);
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // Save the Histos ------------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    std::cout << "  /// Saving histos to " << settings.out << " ..." << std::endl;
+
+    TFile* savefile = new TFile(settings.out, "RECREATE");
+
+    TDirectory* signal_histos = savefile->mkdir("signal_histos");
+    TDirectory* bg_histos     = savefile->mkdir("bg_histos");
+    TDirectory* data_histos   = savefile->mkdir("data_histos");
+    TDirectory* net_histos    = savefile->mkdir("net_histos");
+
+    signal_histos->cd();
+    signallist->Write();
+
+    bg_histos->cd();
+    bglist->Write();
+
+    data_histos->cd();
+    datalist->Write();
+
+    net_histos->cd();
+    netlist->Write();
+
+    savefile->Close();
+
+    timerWatch.Stop();
+    std::cout << "### DONE " << record.size() << " rows, " << timerWatch.RealTime() << " seconds" << std::endl;
+    return 0;
+}
@@ -0,0 +1,257 @@
+/////////////////////////////////////////////////////////////////////////////
+//                           reselect.cxx                                  //
+//=========================================================================//
+//                                                                         //
+// Redo the Run2EventSelectionCuts and Run2MuonSelectionCuts for new       //
+// thresholds or cut on/off combinations using the SelectionRecord side    //
+// files from ./writeSelectionRecords. No ROOT files are read. Outputs     //
+// the yields for each sample and the net yields for each sample type,     //
+// in an optional dimuon mass window.                                      //
+//                                                                         //
+// Cut bits, see SelectionRecord.hxx,                                      //
+//   0: charge, 1: hlt matched muon pt, 2: dimu mass                       //
+//   3-5: mu1 pt, |eta|, iso, 6-8: mu2 pt, |eta|, iso                      //
+//                                                                         //
+// Set MAIN=reselect in the makefile then run via                          //
+// ./reselect --minPt=25 --maxRelIso=0.15 --cutsOff=2 --massMin=110 --massMax=160
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+#include "SelectionRecord.hxx"
+#include "ThreadPool.hxx"
+
+#include <sstream>
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include "TString.h"
+#include "TObjArray.h"
+#include "TObjString.h"
+#include "TMath.h"
+#include "TSystem.h"
+#include "TStopwatch.h"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct Settings
+{
+// default settings here, may be overwritten by terminal input, see main() below
+
+    int nthreads = 20;                       // number of threads to use in parallelization
+    float luminosity = 36814;                // pb-1
+    TString calibration = "Roch";            // PF, Roch, or KaMu, picks the record files
+    TString indir = "rootfiles/selection_records/";
+    float massMin = -1;                      // optional dimuon mass window on the selected candidate
+    float massMax = -1;
+    bool check = false;                      // recompute the stored bitmasks with the stored thresholds
+
+    // negative means use the thresholds stored in the record
+    float minPt = -1;
+    float maxEta = -1;
+    float maxRelIso = -1;
+    float trigMuPtMin = -1;
+    float dimuMassMin = -1;
+    TString cutsOff = "";                    // comma separated list of cut bits to turn off
+    TString cutsOn = "";                     // comma separated list of cut bits to turn on
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct Yield
+{
+    TString name;
+    TString sampleType;
+    long long nevents = 0;        // events in the record
+    long long nselected = 0;      // events with a selected candidate in the mass window
+    long long nchanged = 0;       // events where the selected candidate changed w.r.t. the stored one
+    long long nmismatch = 0;      // candidates where the recomputed bitmask differs from the stored one
+    double yield = 0;             // weighted and scaled to the luminosity
+    double yield2 = 0;            // sum of the squared weights, scaled
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+unsigned int parseBits(TString list)
+{
+    unsigned int mask = 0;
+    TObjArray* tokens = list.Tokenize(",");
+    for(int i=0; i<tokens->GetEntries(); i++)
+    {
+        int bit = ((TObjString*)tokens->At(i))->GetString().Atoi();
+        if(bit >= 0 && bit < (int)SelectionRecord::kNBits) mask |= 1 << bit;
+        else std::cout << Form("!!! %d is not a valid cut bit.", bit) << std::endl;
+    }
+    delete tokens;
+    return mask;
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+    Settings settings;
+
+    for(int i=1; i<argc; i++)
+    {
+        std::stringstream ss;
+        TString in = argv[i];
+        TString option = in(0, in.First("="));
+        option = option.ReplaceAll("--", "");
+        TString value  = in(in.First("=")+1, in.Length());
+        value = value.ReplaceAll("\"", "");
+        ss << value.Data();
+
+        if(option=="nthreads")             ss >> settings.nthreads;
+        else if(option=="luminosity")      ss >> settings.luminosity;
+        else if(option=="calibration")     settings.calibration = value;
+        else if(option=="indir")           settings.indir = value;
+        else if(option=="massMin")         ss >> settings.massMin;
+        else if(option=="massMax")         ss >> settings.massMax;
+        else if(option=="check")           ss >> settings.check;
+        else if(option=="minPt")           ss >> settings.minPt;
+        else if(option=="subleadPt")       ss >> settings.minPt;
+        else if(option=="maxEta")          ss >> settings.maxEta;
+        else if(option=="maxRelIso")       ss >> settings.maxRelIso;
+        else if(option=="trigMuPtMin")     ss >> settings.trigMuPtMin;
+        else if(option=="dimuMassMin")     ss >> settings.dimuMassMin;
+        else if(option=="cutsOff")         settings.cutsOff = value;
+        else if(option=="cutsOn")          settings.cutsOn = value;
+        else
+        {
+            std::cout << Form("!!! %s is not a recognized option.", option.Data()) << std::endl;
+        }
+    }
+
+    if(!settings.indir.EndsWith("/")) settings.indir += "/";
+    unsigned int bitsOff = parseBits(settings.cutsOff);
+    unsigned int bitsOn  = parseBits(settings.cutsOn);
+
+    ///////////////////////////////////////////////////////////////////
+    // RECORD FILES ---------------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    std::vector<TString> files;
+    TString ending = "_"+settings.calibration+".sel";
+    void* dir = gSystem->OpenDirectory(settings.indir);
+    if(dir == 0)
+    {
+        std::cout << "!!! could not open " << settings.indir << ", run ./writeSelectionRecords first" << std::endl;
+        return 1;
+    }
+    while(const char* entry = gSystem->GetDirEntry(dir))
+    {
+        TString f = entry;
+        if(f.EndsWith(ending)) files.push_back(settings.indir+f);
+    }
+    gSystem->FreeDirectory(dir);
+    std::sort(files.begin(), files.end());
+
+    TStopwatch timerWatch;
+    timerWatch.Start();
+
+    ///////////////////////////////////////////////////////////////////
+    // Define Task for Parallelization -------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    auto reselectSample = [settings, bitsOff, bitsOn](TString filename)
+    {
+      Yield y;
+      SelectionRecord record;
+      if(!record.read(filename.Data())) return y;
+
+      y.name = record.name.c_str();
+      y.sampleType = record.sampleType.c_str();
+      y.nevents = record.events.size();
+
+      // new thresholds, anything not given on the command line stays as it was when the record was written
+      SelectionThresholds t = record.thresholds;
+      if(settings.minPt >= 0)       t.minPt = settings.minPt;
+      if(settings.maxEta >= 0)      t.maxEta = settings.maxEta;
+      if(settings.maxRelIso >= 0)   t.maxRelIso = settings.maxRelIso;
+      if(settings.trigMuPtMin >= 0) t.trigMuPtMin = settings.trigMuPtMin;
+      if(settings.dimuMassMin >= 0) t.dimuMassMin = settings.dimuMassMin;
+      t.on = (t.on | bitsOn) & ~bitsOff;
+
+      bool window = settings.massMin >= 0 || settings.massMax >= 0;
+      double sf = record.getLumiScaleFactor(settings.luminosity);
+
+      for(auto& e: record.events)
+      {
+          if(settings.check)
+          {
+              for(unsigned int d=0; d<e.ncand; d++)
+              {
+                  const SelectionCandidate& c = record.candidates[e.first+d];
+                  if(SelectionRecord::evaluate(c, record.thresholds) != c.mask) y.nmismatch++;
+              }
+          }
+
+          int selected = record.select(e, t);
+          if(selected != e.selected) y.nchanged++;
+          if(selected < 0) continue;
+
+          const SelectionCandidate& c = record.candidates[e.first+selected];
+          if(window && settings.massMin >= 0 && c.mass < settings.massMin) continue;
+          if(window && settings.massMax >= 0 && c.mass > settings.massMax) continue;
+
+          y.nselected++;
+          y.yield  += sf*e.weight;
+          y.yield2 += sf*sf*e.weight*e.weight;
+      }
+      return y;
+    };
+
+   ///////////////////////////////////////////////////////////////////
+   // PARALLELIZE BY SAMPLE -----------------------------------------
+   ///////////////////////////////////////////////////////////////////
+
+    ThreadPool pool(settings.nthreads);
+    std::vector< std::future<Yield> > results;
+
+    for(auto& f : files)
+        results.push_back(pool.enqueue(reselectSample, f));
+
+    ///////////////////////////////////////////////////////////////////
+    // Output ---------------------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    std::map<TString, Yield> net;
+    std::cout << std::endl;
+    std::cout << Form("  %-30s %12s %12s %12s %16s %12s", "sample", "events", "selected", "changed", "yield", "error") << std::endl;
+    for(auto && result: results)
+    {
+        Yield y = result.get();
+        if(y.name == "") continue;
+
+        std::cout << Form("  %-30s %12lld %12lld %12lld %16.4f %12.4f", y.name.Data(), y.nevents, y.nselected, y.nchanged,
+                          y.yield, TMath::Sqrt(y.yield2)) << std::endl;
+        if(settings.check && y.nmismatch > 0)
+            std::cout << Form("  !!! %s: %lld candidates have a stored bitmask that differs from the recomputed one", y.name.Data(), y.nmismatch) << std::endl;
+
+        Yield& n = net[y.sampleType];
+        n.name = "Net_"+y.sampleType;
+        n.nevents += y.nevents;
+        n.nselected += y.nselected;
+        n.nchanged += y.nchanged;
+        n.yield += y.yield;
+        n.yield2 += y.yield2;
+    }
+
+    std::cout << std::endl;
+    for(auto& n: net)
+        std::cout << Form("  %-30s %12lld %12lld %12lld %16.4f %12.4f", n.second.name.Data(), n.second.nevents, n.second.nselected,
+                          n.second.nchanged, n.second.yield, TMath::Sqrt(n.second.yield2)) << std::endl;
+
+    timerWatch.Stop();
+    std::cout << std::endl << "### DONE " << timerWatch.RealTime() << " seconds" << std::endl;
+    return 0;
+}
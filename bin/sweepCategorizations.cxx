@@ -0,0 +1,451 @@
+/////////////////////////////////////////////////////////////////////////////
+//                       sweepCategorizations.cxx                          //
+//=========================================================================//
+//                                                                         //
+// Compare many categorizations in one go. The FeatureRecords from         //
+// ./writeFeatureRecords are read into memory once, then each candidate    //
+// XML and the fixed run1 and bdt schemes are evaluated over all of the    //
+// events in parallel, one candidate per thread. Outputs the signal and    //
+// background in the signal window and the significance for each category  //
+// of each candidate with the same binning and SignificanceMetric as       //
+// outputCounts, and the candidates ranked by net significance.            //
+//                                                                         //
+// Set MAIN=sweepCategorizations in the makefile then run via              //
+// ./sweepCategorizations --nthreads=20 --xmldir=autocat/ --xmlfiles="tree_categorization_final.xml"
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+#include "CategorySelection.h"
+#include "SignificanceMetrics.hxx"
+#include "FeatureRecord.hxx"
+#include "ThreadPool.hxx"
+
+#include <sstream>
+#include <fstream>
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include "TString.h"
+#include "TSystem.h"
+#include "TStopwatch.h"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct Settings
+{
+// default settings here, may be overwritten by terminal input, see main() below
+
+    int nthreads = 20;                       // number of threads to use in parallelization
+    float luminosity = 36814;                // pb-1
+    TString indir = "rootfiles/feature_records/";
+    TString csvfile = "csv/sigcsv/sweep_categorizations.csv";
+    std::vector<TString> xmlfiles;           // candidate categorizations
+    std::vector<TString> schemes = {"run1", "bdt"};
+
+    // same window, binning, and metric as outputCounts
+    float massmin = 120;
+    float massmax = 130;
+    float interval = 0.5;
+    int unctype = 0;
+    int nbkgmin = 10;
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+void addFiles(TString dir, TString ending, std::vector<TString>& files)
+{
+// all of the files in dir that end with ending
+    if(!dir.EndsWith("/")) dir += "/";
+    void* d = gSystem->OpenDirectory(dir);
+    if(d == 0)
+    {
+        std::cout << Form("!!! could not open %s \n", dir.Data());
+        return;
+    }
+    std::vector<TString> found;
+    const char* entry;
+    while((entry = gSystem->GetDirEntry(d)))
+    {
+        TString file = entry;
+        if(file.EndsWith(ending)) found.push_back(dir+file);
+    }
+    gSystem->FreeDirectory(d);
+    std::sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+// the yields of one category, the histograms in outputCounts as arrays
+struct CategoryYields
+{
+    std::vector<double> signal, background;                // sum of weights in each bin of the signal window
+    std::vector<long long int> nsignal, nbackground;       // number of events in each bin of the signal window
+    double signalOut = 0, backgroundOut = 0, dataOut = 0;  // outside the signal window
+    long long int nbackgroundOut = 0, ndataOut = 0;
+
+    CategoryYields(int nbins) : signal(nbins, 0), background(nbins, 0), nsignal(nbins, 0), nbackground(nbins, 0) {};
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+// A candidate categorization, either an XML tree with its split features resolved
+// to indices into the FeatureRecord values or a fixed scheme stored in the records
+struct Candidate
+{
+    struct Node
+    {
+        int category = -1;
+        int left = -1;
+        int right = -1;
+        int feature = -1;
+        double splitVal = 0;
+    };
+
+    TString name;
+    int scheme = -1;                      // index of the fixed scheme in the records, -1 for an XML
+    std::vector<Node> nodes;
+    std::vector<TString> names;           // category names, keys, and flags in id order
+    std::vector<TString> keys;
+    std::vector<bool> hide;
+    std::vector<bool> isTerminal;
+
+    // the categories the event is in, ids appended to in
+    void evaluate(const FeatureRecord& r, unsigned int i, std::vector<int>& in) const
+    {
+        if(scheme >= 0)
+        {
+            unsigned long long mask = r.eventMask(i, scheme);
+            for(unsigned int id=0; mask != 0; id++, mask >>= 1)
+                if(mask & 1) in.push_back(id);
+            return;
+        }
+
+        // same path as XMLCategorizer::evaluateFlat
+        const double* x = r.eventValues(i);
+        int n = 0;
+        while(true)
+        {
+            const Node& node = nodes[n];
+            in.push_back(node.category);
+            if(node.left < 0 || node.right < 0) break;
+            n = (x[node.feature] <= node.splitVal) ? node.left : node.right;
+        }
+    }
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+bool makeCandidate(TString xmlfile, const FeatureRecord& r, Candidate& c)
+{
+    XMLCategorizer xmlCategorizer(xmlfile);
+    if(xmlCategorizer.flatNodes.size() == 0)
+    {
+        std::cout << Form("  !!! no categories in %s, skipping it \n", xmlfile.Data());
+        return false;
+    }
+
+    c.name = xmlfile;
+    for(unsigned int n=0; n<xmlCategorizer.flatNodes.size(); n++)
+    {
+        const FlatCategoryNode& in = xmlCategorizer.flatNodes[n];
+        Candidate::Node node;
+        node.category = in.category;
+        node.left = in.left;
+        node.right = in.right;
+        node.splitVal = in.splitVal;
+        if(in.left >= 0)
+        {
+            node.feature = r.featureIndex(xmlCategorizer.flatSplitVarNames[n].Data());
+            if(node.feature < 0)
+            {
+                std::cout << Form("  !!! %s splits on %s, which is not in the feature records, skipping it \n",
+                                  xmlfile.Data(), xmlCategorizer.flatSplitVarNames[n].Data());
+                return false;
+            }
+        }
+        c.nodes.push_back(node);
+    }
+    for(auto& category: xmlCategorizer.categories)
+    {
+        c.names.push_back(category->name);
+        c.keys.push_back(category->key);
+        c.hide.push_back(category->hide);
+        c.isTerminal.push_back(category->isTerminal);
+    }
+    return true;
+}
+
+bool makeSchemeCandidate(TString scheme, const FeatureRecord& r, Candidate& c)
+{
+    c.scheme = r.schemeIndex(scheme.Data());
+    if(c.scheme < 0)
+    {
+        std::cout << Form("  !!! %s is not in the feature records, skipping it \n", scheme.Data());
+        return false;
+    }
+
+    // names and flags from the categorizer itself, the ids are the same as when the records were written
+    Categorizer* categorizer = 0;
+    if(scheme == "run1") categorizer = new CategorySelectionRun1();
+    else categorizer = new CategorySelectionBDT();
+
+    c.name = scheme;
+    for(auto& category: categorizer->categories)
+    {
+        c.names.push_back(category->name);
+        c.keys.push_back(category->key);
+        c.hide.push_back(category->hide);
+        c.isTerminal.push_back(category->isTerminal);
+    }
+    delete categorizer;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+    Settings settings;
+
+    for(int i=1; i<argc; i++)
+    {
+        std::stringstream ss;
+        TString in = argv[i];
+        TString option = in(0, in.First("="));
+        option = option.ReplaceAll("--", "");
+        TString value  = in(in.First("=")+1, in.Length());
+        value = value.ReplaceAll("\"", "");
+        ss << value.Data();
+
+        if(option=="nthreads")             ss >> settings.nthreads;
+        else if(option=="luminosity")      ss >> settings.luminosity;
+        else if(option=="indir")           settings.indir = value;
+        else if(option=="csvfile")         settings.csvfile = value;
+        else if(option=="unctype")         ss >> settings.unctype;
+        else if(option=="nbkgmin")         ss >> settings.nbkgmin;
+        else if(option=="xmldir")          addFiles(value, ".xml", settings.xmlfiles);
+        else if(option=="xmlfiles" || option=="schemes")
+        {
+            if(option=="schemes") settings.schemes.clear();
+            TString tok;
+            Ssiz_t from = 0;
+            while (value.Tokenize(tok, from, " "))
+            {
+                if(option=="xmlfiles") settings.xmlfiles.push_back(tok);
+                else settings.schemes.push_back(tok);
+            }
+        }
+        else
+        {
+            std::cout << Form("!!! %s is not a recognized option.", option.Data()) << std::endl;
+        }
+    }
+
+    TStopwatch timerWatch;
+    timerWatch.Start();
+
+    ///////////////////////////////////////////////////////////////////
+    // LOAD THE RECORDS -----------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    std::vector<TString> recordfiles;
+    addFiles(settings.indir, ".features", recordfiles);
+
+    std::vector<FeatureRecord> records(recordfiles.size());
+    long long nevents = 0;
+    for(unsigned int r=0; r<recordfiles.size(); r++)
+    {
+        if(!records[r].read(recordfiles[r].Data())) return 1;
+        if(r > 0 && (records[r].features != records[0].features || records[r].schemes != records[0].schemes))
+        {
+            std::cout << Form("!!! %s has different features than %s, rerun writeFeatureRecords \n",
+                              recordfiles[r].Data(), recordfiles[0].Data());
+            return 1;
+        }
+        nevents += records[r].events.size();
+    }
+    if(records.size() == 0)
+    {
+        std::cout << Form("!!! no feature records in %s \n", settings.indir.Data());
+        return 1;
+    }
+    std::cout << Form("  /// %d samples, %lld events, %d features \n", (int)records.size(), nevents, records[0].nfeatures());
+
+    // the signal window bin of each event and the lumi scaled weight, the same for every candidate
+    int nbins = (settings.massmax - settings.massmin)/settings.interval + 0.5;
+    std::vector< std::vector<int> > bins(records.size());
+    std::vector< std::vector<double> > weights(records.size());
+    for(unsigned int r=0; r<records.size(); r++)
+    {
+        double scale = records[r].getLumiScaleFactor(settings.luminosity);
+        for(auto& e: records[r].events)
+        {
+            int bin = -1;
+            if(e.mass >= settings.massmin && e.mass < settings.massmax) bin = (e.mass - settings.massmin)/settings.interval;
+            bins[r].push_back(bin);
+            weights[r].push_back(e.weight*scale);
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // CANDIDATES -----------------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    std::vector<Candidate> candidates;
+    for(auto& scheme: settings.schemes)
+    {
+        Candidate c;
+        if(makeSchemeCandidate(scheme, records[0], c)) candidates.push_back(c);
+    }
+    for(auto& xmlfile: settings.xmlfiles)
+    {
+        Candidate c;
+        if(makeCandidate(xmlfile, records[0], c)) candidates.push_back(c);
+    }
+    std::cout << Form("  /// %d candidate categorizations \n", (int)candidates.size());
+
+    ///////////////////////////////////////////////////////////////////
+    // EVALUATE EACH CANDIDATE OVER ALL OF THE EVENTS -----------------
+    ///////////////////////////////////////////////////////////////////
+
+    auto sweepCandidate = [&records, &bins, &weights, nbins](const Candidate* c)
+    {
+        std::vector<CategoryYields> yields(c->names.size(), CategoryYields(nbins));
+        std::vector<int> in;
+        in.reserve(c->names.size());
+
+        for(unsigned int r=0; r<records.size(); r++)
+        {
+            const FeatureRecord& record = records[r];
+            bool isData = record.sampleType == "data";
+            bool isSignal = record.sampleType == "signal";
+
+            for(unsigned int i=0; i<record.events.size(); i++)
+            {
+                in.clear();
+                c->evaluate(record, i, in);
+
+                int bin = bins[r][i];
+                double w = weights[r][i];
+                for(int id: in)
+                {
+                    CategoryYields& y = yields[id];
+                    if(isSignal)
+                    {
+                        if(bin < 0) y.signalOut += w;
+                        else
+                        {
+                            y.signal[bin] += w;
+                            y.nsignal[bin]++;
+                        }
+                    }
+                    else if(isData)
+                    {
+                        if(bin < 0)
+                        {
+                            y.dataOut += w;
+                            y.ndataOut++;
+                        }
+                    }
+                    else
+                    {
+                        if(bin < 0)
+                        {
+                            y.backgroundOut += w;
+                            y.nbackgroundOut++;
+                        }
+                        else
+                        {
+                            y.background[bin] += w;
+                            y.nbackground[bin]++;
+                        }
+                    }
+                }
+            }
+        }
+        return yields;
+    };
+
+    ThreadPool pool(settings.nthreads);
+    std::vector< std::future< std::vector<CategoryYields> > > results;
+    for(auto& c: candidates)
+        results.push_back(pool.enqueue(sweepCandidate, &c));
+
+    ///////////////////////////////////////////////////////////////////
+    // OUTPUT ---------------------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    std::ofstream file(settings.csvfile.Data(), std::ofstream::out);
+    file << "candidate,category,s0,S_div_sqrtB,S_div_B,signal,background" << std::endl;
+
+    SignificanceMetric* s0 = new PoissonSignificance(settings.unctype, settings.nbkgmin);
+    std::vector< std::pair<double, TString> > ranking;
+
+    for(unsigned int k=0; k<candidates.size(); k++)
+    {
+        const Candidate& c = candidates[k];
+        std::vector<CategoryYields> yields = results[k].get();
+
+        std::cout << std::endl << "  /// " << c.name << std::endl;
+        std::cout << "    category,s0,S_div_sqrtB,S_div_B,signal,background" << std::endl;
+
+        double net_significance = 0;
+        double net_s_sqrt_b = 0;
+        for(unsigned int id=0; id<yields.size(); id++)
+        {
+            if(c.hide[id]) continue;
+
+            CategoryYields& y = yields[id];
+            double signal = 0, background = 0;
+            for(int b=0; b<nbins; b++)
+            {
+                signal += y.signal[b];
+                background += y.background[b];
+            }
+
+            double sig0 = s0->significance2(y.signal, y.background, y.backgroundOut, y.dataOut,
+                                            y.nsignal, y.nbackground, y.nbackgroundOut, y.ndataOut);
+            double s2_over_b = background > 0 ? signal*signal/background : 0;
+            if(c.isTerminal[id]) net_significance += sig0;
+            if(c.isTerminal[id]) net_s_sqrt_b += s2_over_b;
+
+            TString outstring = Form("%s,%f,%f,%f,%f,%f", c.names[id].Data(), TMath::Sqrt(sig0), TMath::Sqrt(s2_over_b),
+                                     background > 0 ? signal/background : 0, signal, background);
+            std::cout << "    " << outstring << std::endl;
+            file << c.name << "," << outstring << std::endl;
+        }
+        net_significance = TMath::Sqrt(net_significance);
+        net_s_sqrt_b = TMath::Sqrt(net_s_sqrt_b);
+        std::cout << Form("    ### NET SIGNIFICANCE: %f, NET S/SQRT(B): %f \n", net_significance, net_s_sqrt_b);
+        ranking.push_back(std::pair<double, TString>(net_significance, c.name));
+    }
+    file.close();
+
+    std::sort(ranking.begin(), ranking.end(), [](const std::pair<double, TString>& a, const std::pair<double, TString>& b){ return a.first > b.first; });
+
+    std::cout << std::endl;
+    std::cout << "  ////////////////////////////////////////// " << std::endl;
+    std::cout << "  ### RANKED BY NET SIGNIFICANCE " << std::endl;
+    for(auto& r: ranking)
+        std::cout << Form("  %10.5f  %s \n", r.first, r.second.Data());
+    std::cout << "  ////////////////////////////////////////// " << std::endl;
+    std::cout << std::endl << "  /// Saved the categories to " << settings.csvfile << std::endl;
+
+    timerWatch.Stop();
+    std::cout << "### DONE " << timerWatch.RealTime() << " seconds" << std::endl;
+    return 0;
+}
@@ -150,10 +150,12 @@ int main(int argc, char* argv[])
       TString methodName = "BDTG_UF_v1";
       TString weightfile = dir+"f_Opt_v1_all_sig_all_bkg_ge0j_BDTG_UF_v1.weights.xml";
 
-      TMVA::Reader* reader = 0; 
-      std::map<TString, Float_t> tmap;
-      std::map<TString, Float_t> smap;
-      reader = TMVATools::bookVars(methodName, weightfile, tmap, smap);
+      std::shared_ptr<const BDTForest> classifier = TMVATools::getClassifier(weightfile);
+      ClassifierInputs bdtInputs;
+
+      // classifier scores from earlier runs
+      ScoreCache scoreCache;
+      bool useScoreCache = scoreCache.open("rootfiles/score_cache/", s->name.Data(), ScoreCache::hashWeights(weightfile.Data()), pf_roch_or_kamu.Data(), "");
 
       std::vector<std::pair<int,long long int>> eventsToCheck;
       //loadEventsFromFile("synchcsv/xCheck.txt", eventsToCheck);
@@ -258,7 +260,9 @@ int main(int argc, char* argv[])
           //CollectionCleaner::cleanByDR(s->vars.validElectrons, s->vars.validMuons, 0.4);
           //CollectionCleaner::cleanByDR(s->vars.validJets, s->vars.validElectrons, 0.4);
           
-          s->vars.bdt_out = TMVATools::getClassifierScore(reader, methodName, tmap, s->vars); // set tmva's bdt score
+          int candidate = &dimu - &s->vars.muPairs->at(0);
+          s->vars.bdt_out = TMVATools::getClassifierScore(*classifier, bdtInputs, s->vars, // set tmva's bdt score
+                                                          useScoreCache?&scoreCache:0, i, candidate);
           
           if(EventTools::eventInVector(e, eventsToCheck) || true) // Adrian gave a list of events to look at for synch purposes
              EventTools::outputEvent(s->vars);
@@ -308,14 +312,15 @@ int main(int argc, char* argv[])
           categorySelection->evaluate(s->vars);
 
           // Look at each category
-          for(auto &c : categorySelection->categoryMap)
+          for(int id : categorySelection->inIds)
           {
+              Category& c = *categorySelection->categories[id];
+
               // skip categories
-              if(c.second.hide) continue;
-              if(!c.second.inCategory) continue;
+              if(c.hide) continue;
 
-              c.second.histoMap[hkey]->Fill(1, 1);
-              c.second.eventsMap[hkey].push_back(e);
+              c.histoMap[hkey]->Fill(1, 1);
+              c.eventsMap[hkey].push_back(e);
           } // end category loop
 
           if(EventTools::eventInVector(e, eventsToCheck) || true)
@@ -326,6 +331,8 @@ int main(int argc, char* argv[])
         } // end dimu cand loop
       } // end event loop
 
+      if(useScoreCache) scoreCache.save();
+
       std::cout << Form("  /// Done processing %s \n", s->name.Data());
       return categorySelection;
 
@@ -0,0 +1,300 @@
+/////////////////////////////////////////////////////////////////////////////
+//                       writeFeatureRecords.cxx                           //
+//=========================================================================//
+//                                                                         //
+// Write a FeatureRecord side file for each sample with the weight, the    //
+// mass, and the features that the categorization XMLs split on for the    //
+// events that outputCounts selects, along with the run1 and bdt           //
+// categories of each event. Use ./sweepCategorizations on the output to   //
+// compare many categorizations at once. Rerun this if the candidate XMLs  //
+// split on a feature that isn't in the records yet.                       //
+//                                                                         //
+// Set MAIN=writeFeatureRecords in the makefile then run via               //
+// ./writeFeatureRecords --nthreads=10 --xmldir=autocat/ --xmlfiles="tree_categorization_final.xml"
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+#include "Sample.h"
+#include "EventSelection.h"
+#include "MuonSelection.h"
+#include "CategorySelection.h"
+#include "JetCollectionCleaner.h"
+#include "MuonCollectionCleaner.h"
+#include "EleCollectionCleaner.h"
+#include "FusedCollectionCleaner.h"
+#include "FeatureRecord.hxx"
+
+#include "TMVATools.h"
+#include "SampleDatabase.cxx"
+#include "ThreadPool.hxx"
+
+#include <sstream>
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include "TSystem.h"
+#include "TStopwatch.h"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct Settings
+{
+// default settings here, may be overwritten by terminal input, see main() below
+
+    int nthreads = 20;                       // number of threads to use in parallelization
+    float reductionFactor = 1;               // reduce the number of events you run over
+    TString whichDY = "dyAMC-J";             // use amc@nlo or madgraph for Drell Yan : {"dyAMC", "dyAMC-J", "dyMG"}
+    std::vector<TString> xmlfiles;           // categorizations whose split features are recorded
+    std::vector<TString> features = {"bdt_score", "dimu_max_abs_eta"};
+    TString outdir = "rootfiles/feature_records/";
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+void addXMLFiles(TString dir, std::vector<TString>& xmlfiles)
+{
+// all of the .xml files in dir
+    if(!dir.EndsWith("/")) dir += "/";
+    void* d = gSystem->OpenDirectory(dir);
+    if(d == 0)
+    {
+        std::cout << Form("!!! could not open %s \n", dir.Data());
+        return;
+    }
+    std::vector<TString> found;
+    const char* entry;
+    while((entry = gSystem->GetDirEntry(d)))
+    {
+        TString file = entry;
+        if(file.EndsWith(".xml")) found.push_back(dir+file);
+    }
+    gSystem->FreeDirectory(d);
+    std::sort(found.begin(), found.end());
+    xmlfiles.insert(xmlfiles.end(), found.begin(), found.end());
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+    Settings settings;
+
+    for(int i=1; i<argc; i++)
+    {
+        std::stringstream ss;
+        TString in = argv[i];
+        TString option = in(0, in.First("="));
+        option = option.ReplaceAll("--", "");
+        TString value  = in(in.First("=")+1, in.Length());
+        value = value.ReplaceAll("\"", "");
+        ss << value.Data();
+
+        if(option=="nthreads")             ss >> settings.nthreads;
+        else if(option=="reductionFactor") ss >> settings.reductionFactor;
+        else if(option=="whichDY")         settings.whichDY = value;
+        else if(option=="outdir")          settings.outdir = value;
+        else if(option=="xmldir")          addXMLFiles(value, settings.xmlfiles);
+        else if(option=="xmlfiles" || option=="features")
+        {
+            TString tok;
+            Ssiz_t from = 0;
+            while (value.Tokenize(tok, from, " "))
+            {
+                if(option=="xmlfiles") settings.xmlfiles.push_back(tok);
+                else settings.features.push_back(tok);
+            }
+        }
+        else
+        {
+            std::cout << Form("!!! %s is not a recognized option.", option.Data()) << std::endl;
+        }
+    }
+
+    if(!settings.outdir.EndsWith("/")) settings.outdir += "/";
+    gSystem->mkdir(settings.outdir, true);
+
+    // the features the XMLs split on
+    for(auto& xmlfile: settings.xmlfiles)
+    {
+        XMLCategorizer xmlCategorizer(xmlfile);
+        for(unsigned int n=0; n<xmlCategorizer.flatNodes.size(); n++)
+            if(xmlCategorizer.flatNodes[n].left >= 0) settings.features.push_back(xmlCategorizer.flatSplitVarNames[n]);
+    }
+    std::vector<TString> features;
+    for(auto& f: settings.features)
+        if(std::find(features.begin(), features.end(), f) == features.end()) features.push_back(f);
+    settings.features = features;
+
+    std::cout << Form("  /// %d features from %d XMLs:", (int)features.size(), (int)settings.xmlfiles.size());
+    for(auto& f: features) std::cout << " " << f;
+    std::cout << std::endl;
+
+    ///////////////////////////////////////////////////////////////////
+    // SAMPLES---------------------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    std::map<TString, Sample*> samples;
+    std::vector<Sample*> samplevec;
+
+    GetSamples(samples, "UF", "ALL_"+settings.whichDY);
+
+    for(auto &i : samples)
+    {
+        i.second->setBranchAddresses("");
+        samplevec.push_back(i.second);
+    }
+    std::sort(samplevec.begin(), samplevec.end(), [](Sample* a, Sample* b){ return a->xsec < b->xsec; });
+
+    TStopwatch timerWatch;
+    timerWatch.Start();
+
+    // the forest is read only after loading, so all of the threads share it
+    TString weightfile = "classification/f_Opt_v1_all_sig_all_bkg_ge0j_BDTG_UF_v1.weights.xml";
+    std::shared_ptr<const BDTForest> classifier = TMVATools::getClassifier(weightfile);
+    if(!classifier) return 1;
+
+    ///////////////////////////////////////////////////////////////////
+    // Define Task for Parallelization -------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    unsigned long long weightsHash = ScoreCache::hashWeights(weightfile.Data());
+
+    auto recordSample = [settings, classifier, weightsHash](Sample* s)
+    {
+      Settings sets = settings;
+      std::cout << Form("  /// Processing %s \n", s->name.Data());
+
+      bool isData = s->sampleType.EqualTo("data");
+      float massmin = 120;   // data is blinded in the signal window, as in outputCounts
+      float massmax = 130;
+
+      ClassifierInputs bdtInputs;
+      ScoreCache scoreCache;
+      bool useScoreCache = scoreCache.open("rootfiles/score_cache/", s->name.Data(), weightsHash, "none", "");
+
+      JetCollectionCleaner      jetCollectionCleaner;
+      MuonCollectionCleaner     muonCollectionCleaner;
+      EleCollectionCleaner      eleCollectionCleaner;
+      FusedCollectionCleaner    fusedCollectionCleaner(jetCollectionCleaner, muonCollectionCleaner, eleCollectionCleaner, 0.4);
+
+      Run2MuonSelectionCuts  run2MuonSelection;
+      Run2EventSelectionCuts run2EventSelection;
+
+      // the fixed schemes are evaluated here and stored as category masks
+      std::vector<Categorizer*> schemes = {new CategorySelectionRun1(), new CategorySelectionBDT()};
+
+      FeatureRecord record;
+      record.name = s->name.Data();
+      record.sampleType = s->sampleType.Data();
+      record.xsec = s->xsec;
+      record.nOriginalWeighted = s->nOriginalWeighted;
+      record.schemes = {"run1", "bdt"};
+      for(auto& scheme: schemes)
+      {
+          std::vector<std::string> keys;
+          for(auto& c: scheme->categories) keys.push_back(c->key.Data());
+          record.schemeCategories.push_back(keys);
+      }
+
+      std::vector<VarSet::VarHandle> handles;
+      for(auto& f: sets.features)
+      {
+          handles.push_back(s->vars.getHandle(f.Data()));
+          if(!handles.back().valid())
+              std::cout << Form("  !!! %s is not a valid variable, it is recorded as -999 \n", f.Data());
+      }
+
+      std::vector<double> x(handles.size());
+      std::vector<unsigned long long> m(schemes.size());
+
+      for(unsigned int i=0; i<s->N/sets.reductionFactor; i++)
+      {
+        // same stitching and selection as outputCounts
+        if(!isData)
+        {
+            s->branches.lhe_ht->GetEntry(i);
+            if(s->name == "ZJets_MG" && s->vars.lhe_ht >= 70) continue;
+        }
+
+        s->branches.muPairs->GetEntry(i);
+        s->branches.muons->GetEntry(i);
+        s->branches.eventInfo->GetEntry(i);
+
+        if(s->vars.muPairs->size() < 1) continue;
+
+        // avoid double counting in RunF
+        if(s->name == "RunF_1" && s->vars.eventInfo->run > 278801) continue;
+        if(s->name == "RunF_2" && s->vars.eventInfo->run < 278802) continue;
+
+        for(auto& dimu: (*s->vars.muPairs))
+        {
+            s->vars.dimuCand = &dimu;
+            MuonInfo& mu1 = s->vars.muons->at(dimu.iMu1);
+            MuonInfo& mu2 = s->vars.muons->at(dimu.iMu2);
+
+            if(!(dimu.mass_PF > 110 && dimu.mass_PF < 160)) continue;
+            if(isData && dimu.mass > massmin && dimu.mass < massmax) continue;
+            if(!mu1.isMediumID || !mu2.isMediumID) continue;
+            if(!run2EventSelection.evaluate(s->vars)) continue;
+            if(!run2MuonSelection.evaluate(s->vars)) continue;
+
+            s->branches.getEntry(i);
+            fusedCollectionCleaner.getValidCollections(s->vars);
+            s->vars.setVBFjets();
+            int candidate = &dimu - &s->vars.muPairs->at(0);
+            s->vars.bdt_out = TMVATools::getClassifierScore(*classifier, bdtInputs, s->vars,
+                                                            useScoreCache?&scoreCache:0, i, candidate);
+
+            for(unsigned int f=0; f<handles.size(); f++)
+                x[f] = s->vars.getValue(handles[f]);
+
+            for(unsigned int k=0; k<schemes.size(); k++)
+            {
+                schemes[k]->reset();
+                schemes[k]->evaluate(s->vars);
+                m[k] = 0;
+                for(int id: schemes[k]->inIds)
+                    if(id < 64) m[k] |= 1ULL << id;
+            }
+
+            record.addEvent(i, s->getWeight(), dimu.mass_PF, x, m);
+            break;
+        }
+      }
+
+      if(useScoreCache) scoreCache.save();
+
+      TString filename = sets.outdir+s->name+".features";
+      record.write(filename.Data());
+
+      std::cout << Form("  /// Done processing %s, %d events -> %s \n", s->name.Data(), (int)record.events.size(), filename.Data());
+      for(auto& scheme: schemes) delete scheme;
+      delete s;
+      return (int)record.events.size();
+    };
+
+   ///////////////////////////////////////////////////////////////////
+   // PARALLELIZE BY SAMPLE -----------------------------------------
+   ///////////////////////////////////////////////////////////////////
+
+    ThreadPool pool(settings.nthreads);
+    std::vector< std::future<int> > results;
+
+    for(auto &s : samplevec)
+        results.push_back(pool.enqueue(recordSample, s));
+
+    long long nevents = 0;
+    for(auto && result: results)
+        nevents += result.get();
+
+    timerWatch.Stop();
+    std::cout << "### DONE " << nevents << " events, " << timerWatch.RealTime() << " seconds" << std::endl;
+    return 0;
+}
@@ -0,0 +1,222 @@
+/////////////////////////////////////////////////////////////////////////////
+//                       writeSelectionRecords.cxx                         //
+//=========================================================================//
+//                                                                         //
+// Write a SelectionRecord side file for each sample with the raw          //
+// quantities used by the Run2EventSelectionCuts and the                   //
+// Run2MuonSelectionCuts for every dimuon candidate, the pass bitmask for  //
+// the default thresholds, the selected candidate, and the event weight.   //
+// Use ./reselect on the output to get the yields for other thresholds.    //
+//                                                                         //
+// Set MAIN=writeSelectionRecords in the makefile then run via             //
+// ./writeSelectionRecords --nthreads=10 --calibration=Roch                //
+//                                                                         //
+/////////////////////////////////////////////////////////////////////////////
+
+#include "Sample.h"
+#include "EventSelection.h"
+#include "MuonSelection.h"
+#include "CutFlow.h"
+#include "SelectionRecord.hxx"
+
+#include "SampleDatabase.cxx"
+#include "ThreadPool.hxx"
+
+#include <sstream>
+#include <map>
+#include <vector>
+
+#include "TSystem.h"
+#include "TStopwatch.h"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct Settings
+{
+// default settings here, may be overwritten by terminal input, see main() below
+
+    int nthreads = 20;                       // number of threads to use in parallelization
+    float reductionFactor = 1;               // reduce the number of events you run over
+    TString whichDY = "dyAMC-J";             // use amc@nlo or madgraph for Drell Yan : {"dyAMC", "dyAMC-J", "dyMG"}
+    TString calibration = "Roch";            // PF, Roch, or KaMu
+    float subleadPt = 20;                    // subleading muon pt cut used for the stored bitmask
+    TString outdir = "rootfiles/selection_records/";
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+    Settings settings;
+
+    for(int i=1; i<argc; i++)
+    {
+        std::stringstream ss;
+        TString in = argv[i];
+        TString option = in(0, in.First("="));
+        option = option.ReplaceAll("--", "");
+        TString value  = in(in.First("=")+1, in.Length());
+        value = value.ReplaceAll("\"", "");
+        ss << value.Data();
+
+        if(option=="nthreads")             ss >> settings.nthreads;
+        else if(option=="reductionFactor") ss >> settings.reductionFactor;
+        else if(option=="subleadPt")       ss >> settings.subleadPt;
+        else if(option=="whichDY")         settings.whichDY = value;
+        else if(option=="calibration")     settings.calibration = value;
+        else if(option=="outdir")          settings.outdir = value;
+        else
+        {
+            std::cout << Form("!!! %s is not a recognized option.", option.Data()) << std::endl;
+        }
+    }
+
+    if(!settings.outdir.EndsWith("/")) settings.outdir += "/";
+    gSystem->mkdir(settings.outdir, true);
+
+    ///////////////////////////////////////////////////////////////////
+    // SAMPLES---------------------------------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    std::map<TString, Sample*> samples;
+    std::vector<Sample*> samplevec;
+
+    GetSamples(samples, "UF", "ALL_"+settings.whichDY);
+
+    for(auto &i : samples)
+    {
+        i.second->setBranchAddresses("");
+        samplevec.push_back(i.second);
+    }
+    std::sort(samplevec.begin(), samplevec.end(), [](Sample* a, Sample* b){ return a->xsec < b->xsec; });
+
+    TStopwatch timerWatch;
+    timerWatch.Start();
+
+    ///////////////////////////////////////////////////////////////////
+    // Define Task for Parallelization -------------------------------
+    ///////////////////////////////////////////////////////////////////
+
+    auto recordSample = [settings](Sample* s)
+    {
+      Settings sets = settings;
+      std::cout << Form("  /// Processing %s \n", s->name.Data());
+
+      Run2MuonSelectionCuts  run2MuonSelection;
+      Run2EventSelectionCuts run2EventSelection;
+      run2MuonSelection.cMinPt = sets.subleadPt;
+      run2MuonSelection.makeCutSet();
+
+      // same bit layout as SelectionRecord::evaluate
+      CutFlow cutflow;
+      cutflow.addCut(&run2EventSelection);
+      cutflow.addCut(&run2MuonSelection);
+
+      SelectionRecord record;
+      record.name = s->name.Data();
+      record.sampleType = s->sampleType.Data();
+      record.calibration = sets.calibration.Data();
+      record.xsec = s->xsec;
+      record.nOriginalWeighted = s->nOriginalWeighted;
+      record.thresholds.trigMuPtMin = run2EventSelection.cTrigMuPtMin;
+      record.thresholds.dimuMassMin = run2EventSelection.cDimuMassMin;
+      record.thresholds.minPt = run2MuonSelection.cMinPt;
+      record.thresholds.maxEta = run2MuonSelection.cMaxEta;
+      record.thresholds.maxRelIso = run2MuonSelection.cMaxRelIso;
+      record.thresholds.on = cutflow.onMask();
+
+      bool isData = s->sampleType.EqualTo("data");
+      std::vector<SelectionCandidate> cands;
+
+      for(unsigned int i=0; i<s->N/sets.reductionFactor; i++)
+      {
+        // same stitching as categorize
+        if(!isData)
+        {
+            s->branches.lhe_ht->GetEntry(i);
+            if(s->name == "ZJets_MG" && s->vars.lhe_ht >= 70) continue;
+        }
+
+        s->branches.muPairs->GetEntry(i);
+        s->branches.muons->GetEntry(i);
+        s->branches.eventInfo->GetEntry(i);
+
+        if(s->vars.muPairs->size() < 1) continue;
+
+        // avoid double counting in RunF
+        if(s->name == "RunF_1" && s->vars.eventInfo->run > 278801) continue;
+        if(s->name == "RunF_2" && s->vars.eventInfo->run < 278802) continue;
+
+        cands.clear();
+        int selected = -1;
+        for(unsigned int d=0; d<s->vars.muPairs->size(); d++)
+        {
+            MuPairInfo& dimu = s->vars.muPairs->at(d);
+            s->vars.dimuCand = &dimu;
+            s->vars.setCalibrationType(sets.calibration);
+
+            MuonInfo& mu1 = s->vars.muons->at(dimu.iMu1);
+            MuonInfo& mu2 = s->vars.muons->at(dimu.iMu2);
+
+            SelectionCandidate c;
+            c.mass = dimu.mass;
+            c.pt1 = mu1.pt;
+            c.pt2 = mu2.pt;
+            c.absEta1 = TMath::Abs(mu1.eta);
+            c.absEta2 = TMath::Abs(mu2.eta);
+            c.iso1 = mu1.iso();
+            c.iso2 = mu2.iso();
+            c.charge1 = mu1.charge;
+            c.charge2 = mu2.charge;
+            if(mu1.isMediumID) c.flags |= SelectionCandidate::kMedium1;
+            if(mu2.isMediumID) c.flags |= SelectionCandidate::kMedium2;
+            if(mu1.isHltMatched[2] || mu1.isHltMatched[3]) c.flags |= SelectionCandidate::kHlt1;
+            if(mu2.isHltMatched[2] || mu2.isHltMatched[3]) c.flags |= SelectionCandidate::kHlt2;
+            c.mask = cutflow.evaluate(s->vars);
+
+            if(selected < 0 && c.mediumID() && cutflow.passes(c.mask)) selected = d;
+            cands.push_back(c);
+        }
+
+        // only the weight branches are needed on top of the muon info
+        float weight = 1;
+        if(!isData)
+        {
+            s->branches.getEntryWeightsMC(i);
+            if(s->branches.nPU != 0) s->branches.nPU->GetEntry(i);
+            weight = s->getWeight();
+        }
+
+        record.addEvent(i, weight, selected, cands);
+      }
+
+      TString filename = sets.outdir+s->name+"_"+sets.calibration+".sel";
+      record.write(filename.Data());
+
+      std::cout << Form("  /// Done processing %s, %d events, %d candidates -> %s \n", s->name.Data(),
+                        (int)record.events.size(), (int)record.candidates.size(), filename.Data());
+      return (int)record.events.size();
+    };
+
+   ///////////////////////////////////////////////////////////////////
+   // PARALLELIZE BY SAMPLE -----------------------------------------
+   ///////////////////////////////////////////////////////////////////
+
+    ThreadPool pool(settings.nthreads);
+    std::vector< std::future<int> > results;
+
+    for(auto &s : samplevec)
+        results.push_back(pool.enqueue(recordSample, s));
+
+    long long nevents = 0;
+    for(auto && result: results)
+        nevents += result.get();
+
+    timerWatch.Stop();
+    std::cout << "### DONE " << nevents << " events, " << timerWatch.RealTime() << " seconds" << std::endl;
+    return 0;
+}
@@ -0,0 +1,496 @@
+///////////////////////////////////////////////////////////////////////////
+// ======================================================================//
+// AutoBinning.hxx                                                       //
+// ======================================================================//
+// Range and binning of a histogram worked out from the values in the    //
+// same pass that fills it, for variables initPlotSettings doesn't know. //
+//                                                                       //
+// Each sample x category fills an AutoGrid: a fine histogram on a grid  //
+// of power of two wide bins aligned at zero. The first values are       //
+// buffered to pick the bin width, after that the grid extends to take   //
+// any value and halves its resolution, merging pairs of bins, when it   //
+// would need more than kMaxBins. Any two grids share their coarser      //
+// grid's edges, so they merge exactly, and the merged grid of all the   //
+// samples is the quantile sketch of the variable, good to one fine bin. //
+//                                                                       //
+// At the end the range is set from the quantiles of the expected yield, //
+// trimming the tails, and the bins are equal width or equal statistics. //
+// Every final edge is a fine grid edge, so each sample's histogram is   //
+// rebinned from its grid with exactly the contents, errors, and         //
+// moments it would have had if it were filled with the final binning.   //
+// The -999 the VarSet returns for a variable that isn't defined for the //
+// event is kept aside, so it doesn't stretch the range of the sketch.   //
+//                                                                       //
+// The grids of the later systematics are a different sketch, their      //
+// edges needn't line up with the binning, so once it is decided they    //
+// fill the final binning directly instead, see AutoBinning::makeGrid.   //
+// ======================================================================//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_AUTOBINNING
+#define ADD_AUTOBINNING
+
+#include <vector>
+#include <string>
+#include <map>
+#include <mutex>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+#include "HistAccumulator.hxx"
+#include "TH1D.h"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+class AutoGrid
+{
+    public:
+        AutoGrid(){};
+
+        // a grid that fills the decided binning as is
+        AutoGrid(const HistAccumulator& binning) { fixed = binning; }
+
+        static const int kMaxBins = 2048;     // at most this many fine bins, the resolution halves beyond
+        static const int kBuffer = 256;       // values kept as is before the bin width is picked
+        static constexpr double kUndefined = -999;   // VarSet value of an undefined variable
+
+        HistAccumulator fixed;                // the decided binning, nbins == 0 for a sketch
+
+        bool started = false;
+        int exponent = 0;                     // fine bin i is [i, i+1)*2^exponent
+        long long first = 0;                  // index of the first stored bin
+        std::vector<double> sumw, sumw2, sumwx, sumwx2, entries;
+
+        // values before the grid is started, (x, w)
+        std::vector< std::pair<double, double> > buffer;
+
+        // NaN, inf, and absurdly large values, they go to the overflow like TAxis::FindBin(NaN)
+        double otherw = 0, otherw2 = 0, otherEntries = 0;
+
+        // the -999 fills, kept out of the sketch and put in whichever bin -999 falls in at the end
+        double undefinedw = 0, undefinedw2 = 0, undefinedEntries = 0;
+
+        double width() const { return std::ldexp(1.0, exponent); }
+        int size() const { return sumw.size(); }
+
+        void fill(double x, double w)
+        {
+            if(fixed.nbins > 0)
+            {
+                fixed.fill(x, w);
+                return;
+            }
+            if(x == kUndefined)
+            {
+                undefinedw += w;
+                undefinedw2 += w*w;
+                undefinedEntries++;
+                return;
+            }
+            if(!(std::fabs(x) < 1e15))
+            {
+                otherw += w;
+                otherw2 += w*w;
+                otherEntries++;
+                return;
+            }
+            if(!started)
+            {
+                buffer.push_back(std::make_pair(x, w));
+                if((int)buffer.size() >= kBuffer) start();
+                return;
+            }
+            add(index(x), w, w*w, w*x, w*x*x, 1);
+        }
+
+        // add c times another grid, c is the lumi x xsec scale of its sample.
+        // Grids with a decided binning only merge with grids with the same binning.
+        void merge(const AutoGrid& other, double c = 1)
+        {
+            if(fixed.nbins > 0 || other.fixed.nbins > 0)
+            {
+                if(fixed.sameBinning(other.fixed)) fixed.add(other.fixed, c);
+                else std::cout << "  !!! AutoGrid: can't merge grids with different binnings" << std::endl;
+                return;
+            }
+
+            otherw += c*other.otherw;
+            otherw2 += c*c*other.otherw2;
+            otherEntries += other.otherEntries;
+            undefinedw += c*other.undefinedw;
+            undefinedw2 += c*c*other.undefinedw2;
+            undefinedEntries += other.undefinedEntries;
+
+            if(!other.started)
+            {
+                for(auto& v: other.buffer) fillScaled(v.first, v.second, c);
+                return;
+            }
+            if(!started)
+            {
+                // take the other's grid and put this one's buffered values on top of it
+                std::vector< std::pair<double, double> > mine;
+                mine.swap(buffer);
+                double ow = otherw, ow2 = otherw2, oe = otherEntries;
+                double uw = undefinedw, uw2 = undefinedw2, ue = undefinedEntries;
+                *this = other;
+                for(auto& v: sumw) v *= c;
+                for(auto& v: sumw2) v *= c*c;
+                for(auto& v: sumwx) v *= c;
+                for(auto& v: sumwx2) v *= c;
+                otherw = ow;
+                otherw2 = ow2;
+                otherEntries = oe;
+                undefinedw = uw;
+                undefinedw2 = uw2;
+                undefinedEntries = ue;
+                for(auto& v: mine) fill(v.first, v.second);
+                return;
+            }
+
+            // same resolution, coarse enough for both ranges together
+            AutoGrid o = other;
+            while(o.exponent < exponent) o.coarsen();
+            while(exponent < o.exponent) coarsen();
+            while(size() > 0 && o.size() > 0 &&
+                  std::max(first+size(), o.first+o.size())-std::min(first, o.first) > kMaxBins)
+            {
+                coarsen();
+                o.coarsen();
+            }
+
+            for(int i=0; i<o.size(); i++)
+                if(o.entries[i] != 0) add(o.first+i, c*o.sumw[i], c*c*o.sumw2[i], c*o.sumwx[i], c*o.sumwx2[i], o.entries[i]);
+        }
+
+        // pick the bin width if the values are still buffered, before the quantiles are read
+        void finish()
+        {
+            if(!started && buffer.size() > 0) start();
+        }
+
+        // every value filled is a whole number, e.g. the number of jets
+        bool integral() const
+        {
+            if(width() > 0.5) return false;
+            for(int i=0; i<size(); i++)
+            {
+                double x = (first+i)*width();
+                if(entries[i] != 0 && x != std::floor(x)) return false;
+            }
+            return true;
+        }
+
+        // x below which a fraction q of the sum of the positive bin contents is, interpolated in the fine bin
+        double quantile(double q) const
+        {
+            double total = 0;
+            for(auto& v: sumw) total += std::max(v, 0.0);
+            if(total <= 0) return 0;
+
+            double target = q*total;
+            double cumulative = 0;
+            for(int i=0; i<size(); i++)
+            {
+                double v = std::max(sumw[i], 0.0);
+                if(cumulative+v >= target && v > 0)
+                    return (first+i+(target-cumulative)/v)*width();
+                cumulative += v;
+            }
+            return (first+size())*width();
+        }
+
+        // every edge of acc is an edge of this grid, so rebin is exact
+        bool aligned(const HistAccumulator& acc) const
+        {
+            if(fixed.nbins > 0) return fixed.sameBinning(acc);
+            if(!started) return true;
+            std::vector<double> edges = acc.edges;
+            if(edges.empty())
+                for(int b=0; b<=acc.nbins; b++) edges.push_back(acc.min+b*(acc.max-acc.min)/acc.nbins);
+            for(auto& e: edges)
+            {
+                double i = std::ldexp(e, -exponent);
+                if(i != std::floor(i)) return false;
+            }
+            return true;
+        }
+
+        // the fills rebinned to the binning of acc, whose edges must be edges of this grid
+        void rebin(HistAccumulator& acc) const
+        {
+            if(fixed.nbins > 0)
+            {
+                acc = fixed;
+                return;
+            }
+
+            acc.reset();
+            for(auto& v: buffer)
+                acc.fill(v.first, v.second);
+
+            double w = width();
+            for(int i=0; i<size(); i++)
+            {
+                if(entries[i] == 0) continue;
+                int b = acc.findBin((first+i+0.5)*w);
+                acc.sumw[b] += sumw[i];
+                acc.sumw2[b] += sumw2[i];
+                acc.entries += entries[i];
+                if((b == 0 || b > acc.nbins) && !acc.statOverflows) continue;
+                acc.tsumw += sumw[i];
+                acc.tsumw2 += sumw2[i];
+                acc.tsumwx += sumwx[i];
+                acc.tsumwx2 += sumwx2[i];
+            }
+
+            acc.sumw[acc.nbins+1] += otherw;
+            acc.sumw2[acc.nbins+1] += otherw2;
+            acc.entries += otherEntries;
+
+            int u = acc.findBin(kUndefined);
+            acc.sumw[u] += undefinedw;
+            acc.sumw2[u] += undefinedw2;
+            acc.entries += undefinedEntries;
+            if((u == 0 || u > acc.nbins) && !acc.statOverflows) return;
+            acc.tsumw += undefinedw;
+            acc.tsumw2 += undefinedw2;
+            acc.tsumwx += kUndefined*undefinedw;
+            acc.tsumwx2 += kUndefined*kUndefined*undefinedw;
+        }
+
+    private:
+        void fillScaled(double x, double w, double c)
+        {
+            if(!started)
+            {
+                // keep the buffered value exact, the scale goes on the weight
+                buffer.push_back(std::make_pair(x, c*w));
+                if((int)buffer.size() >= kBuffer) start();
+                return;
+            }
+            add(index(x), c*w, c*c*w*w, c*w*x, c*w*x*x, 1);
+        }
+
+        // bin width from the spread of the buffered values, so they take up a quarter of the grid
+        void start()
+        {
+            double lo = buffer[0].first, hi = buffer[0].first;
+            for(auto& v: buffer)
+            {
+                lo = std::min(lo, v.first);
+                hi = std::max(hi, v.first);
+            }
+            double span = hi-lo;
+            if(span <= 0) span = std::max(std::fabs(lo), 1.0);
+            std::frexp(span/(kMaxBins/4), &exponent);
+
+            started = true;
+            sumw.clear(); sumw2.clear(); sumwx.clear(); sumwx2.clear(); entries.clear();
+            std::vector< std::pair<double, double> > values;
+            values.swap(buffer);
+            for(auto& v: values) add(index(v.first), v.second, v.second*v.second, v.second*v.first, v.second*v.first*v.first, 1);
+        }
+
+        long long index(double x) const
+        {
+            return (long long)std::floor(std::ldexp(x, -exponent));
+        }
+
+        static long long half(long long i)
+        {
+            return (i >= 0) ? i/2 : -((-i+1)/2);
+        }
+
+        // the grid can hold bin j without coarsening
+        bool fits(long long j) const
+        {
+            if(size() == 0) return true;
+            long long lo = std::min(first, j);
+            long long hi = std::max(first+size()-1, j);
+            return hi-lo+1 <= kMaxBins;
+        }
+
+        void add(long long j, double w, double w2, double wx, double wx2, double n)
+        {
+            while(!fits(j))
+            {
+                coarsen();
+                j = half(j);
+            }
+
+            if(size() == 0) first = j;
+            if(j < first)
+            {
+                int grow = first-j;
+                for(auto v: {&sumw, &sumw2, &sumwx, &sumwx2, &entries}) v->insert(v->begin(), grow, 0.0);
+                first = j;
+            }
+            if(j >= first+size())
+            {
+                int n = j-first+1;
+                for(auto v: {&sumw, &sumw2, &sumwx, &sumwx2, &entries}) v->resize(n, 0.0);
+            }
+
+            int i = j-first;
+            sumw[i] += w;
+            sumw2[i] += w2;
+            sumwx[i] += wx;
+            sumwx2[i] += wx2;
+            entries[i] += n;
+        }
+
+        // double the bin width, bins 2k and 2k+1 become bin k
+        void coarsen()
+        {
+            exponent++;
+            if(size() == 0) return;
+
+            long long newFirst = half(first);
+            int n = half(first+size()-1)-newFirst+1;
+            std::vector<double> w(n, 0), w2(n, 0), wx(n, 0), wx2(n, 0), e(n, 0);
+            for(int i=0; i<size(); i++)
+            {
+                int k = half(first+i)-newFirst;
+                w[k] += sumw[i];
+                w2[k] += sumw2[i];
+                wx[k] += sumwx[i];
+                wx2[k] += sumwx2[i];
+                e[k] += entries[i];
+            }
+            first = newFirst;
+            sumw.swap(w); sumw2.swap(w2); sumwx.swap(wx); sumwx2.swap(wx2); entries.swap(e);
+        }
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+// Collects the grids of every category x sample from the threads, then decides the binning
+// once for the run and remakes the histograms with it. The binning from the first systematic
+// is kept for the later ones, so all of the systematics have the same bins, and their grids
+// from makeGrid fill it directly.
+class AutoBinning
+{
+    public:
+        AutoBinning(){};
+        ~AutoBinning(){};
+
+        enum Mode { kOff = 0, kEqualWidth = 1, kEqualStatistics = 2 };
+
+        int mode = kOff;
+        int nbins = 50;
+        double tail = 0.001;            // fraction of the expected yield left out of the range on each side
+
+        bool decided = false;
+        HistAccumulator binning;        // the final binning, empty until decided
+
+        // the grid for a category x sample to fill, a sketch until the binning is decided
+        AutoGrid makeGrid()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(decided && binning.nbins > 0) return AutoGrid(binning);
+            return AutoGrid();
+        }
+
+        void add(const std::string& category, const std::string& sample, const AutoGrid& grid, double scale)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Entry& e = grids[std::make_pair(category, sample)];
+            e.grid = grid;
+            e.scale = scale;
+            if(!decided) combined.merge(grid, scale);
+        }
+
+        // the range and the bins from the combined grid of all of the samples and categories
+        const HistAccumulator& decide()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(decided) return binning;
+
+            combined.finish();
+            double w = combined.width();
+            if(combined.size() == 0)
+            {
+                std::cout << "  !!! AutoBinning: no values were filled, keeping the default binning" << std::endl;
+                return binning;
+            }
+
+            // whole numbers get unit bins centered on them, anything else edges on the fine grid
+            double unit = w, offset = 0;
+            if(combined.integral())
+            {
+                unit = 1;
+                offset = 0.5;
+            }
+            double lo = std::floor((combined.quantile(tail)-offset)/unit)*unit+offset;
+            double hi = std::ceil((combined.quantile(1-tail)-offset)/unit)*unit+offset;
+            if(hi <= lo) hi = lo+unit;
+
+            if(mode == kEqualStatistics)
+            {
+                std::vector<double> edges = {lo};
+                for(int j=1; j<nbins; j++)
+                {
+                    double q = combined.quantile(tail+j*(1-2*tail)/nbins);
+                    double edge = std::floor((q-offset)/unit+0.5)*unit+offset;
+                    if(edge > edges.back() && edge < hi) edges.push_back(edge);
+                }
+                edges.push_back(hi);
+                binning = HistAccumulator(edges);
+            }
+            else
+            {
+                // a whole number of units per bin
+                double units = std::floor((hi-lo)/unit+0.5);
+                double perbin = std::max(1.0, std::ceil(units/nbins));
+                int n = std::ceil(units/perbin);
+                binning = HistAccumulator(n, lo, lo+n*perbin*unit);
+            }
+            decided = true;
+            return binning;
+        }
+
+        // the histogram of a category x sample with the final binning, scaled like the sample's other histograms,
+        // 0 if the sample didn't fill that category
+        TH1D* makeTH1D(const std::string& category, const std::string& sample, const char* name, const char* title)
+        {
+            auto e = grids.find(std::make_pair(category, sample));
+            if(e == grids.end() || binning.nbins == 0) return 0;
+
+            if(!e->second.grid.aligned(binning))
+                std::cout << "  !!! AutoBinning: the binning isn't on the grid of " << category << " " << sample
+                          << ", the contents are only good to a grid bin" << std::endl;
+
+            HistAccumulator acc = binning;
+            e->second.grid.rebin(acc);
+            TH1D* h = acc.makeTH1D(name, title);
+            h->Scale(e->second.scale);
+            return h;
+        }
+
+        // drop the grids of a systematic once its histograms are remade, the binning stays
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            grids.clear();
+            combined = AutoGrid();
+        }
+
+    private:
+        struct Entry
+        {
+            AutoGrid grid;
+            double scale = 1;
+        };
+
+        std::map< std::pair<std::string, std::string>, Entry > grids;
+        AutoGrid combined;              // every grid times its scale, the quantile sketch
+        std::mutex mutex;
+};
+
+#endif
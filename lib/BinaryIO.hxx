@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////
+// ======================================================================//
+// BinaryIO.hxx                                                          //
+// ======================================================================//
+// The little endian helpers shared by the binary side files, e.g.       //
+// SelectionRecord, ScoreCache, ResultCube, HistBundle. Values are       //
+// written as their raw bytes, strings and vectors with a length prefix, //
+// and each file starts with a magic number and a version. Writers go    //
+// through name.tmp.<pid> and rename it when complete, so a job that     //
+// dies halfway leaves the previous file in place, not a truncated one,  //
+// and two jobs writing the same file don't share a temporary file.      //
+// ======================================================================//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_BINARYIO
+#define ADD_BINARYIO
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <unistd.h>
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+class BinaryIO
+{
+    public:
+        BinaryIO(){};
+        ~BinaryIO(){};
+
+        template<typename T> static void writePOD(std::ofstream& out, const T& t) { out.write((const char*)&t, sizeof(T)); }
+        template<typename T> static void readPOD(std::ifstream& in, T& t) { in.read((char*)&t, sizeof(T)); }
+
+        // N is the type of the length prefix, unsigned int unless the vectors can be longer
+        template<typename N = unsigned int, typename T> static void writeVector(std::ofstream& out, const std::vector<T>& v)
+        {
+            N n = v.size();
+            writePOD(out, n);
+            if(n > 0) out.write((const char*)v.data(), n*sizeof(T));
+        }
+
+        template<typename N = unsigned int, typename T> static void readVector(std::ifstream& in, std::vector<T>& v)
+        {
+            N n = 0;
+            readPOD(in, n);
+            if(!in) n = 0;
+            v.resize(n);
+            if(n > 0) in.read((char*)v.data(), n*sizeof(T));
+        }
+
+        static void writeString(std::ofstream& out, const std::string& s)
+        {
+            unsigned int n = s.size();
+            writePOD(out, n);
+            out.write(s.data(), n);
+        }
+
+        static void readString(std::ifstream& in, std::string& s)
+        {
+            unsigned int n = 0;
+            readPOD(in, n);
+            if(!in) n = 0;
+            s.assign(n, ' ');
+            if(n > 0) in.read(&s[0], n);
+        }
+
+        static void writeStrings(std::ofstream& out, const std::vector<std::string>& v)
+        {
+            unsigned int n = v.size();
+            writePOD(out, n);
+            for(auto& s: v) writeString(out, s);
+        }
+
+        static void readStrings(std::ifstream& in, std::vector<std::string>& v)
+        {
+            unsigned int n = 0;
+            readPOD(in, n);
+            if(!in) n = 0;
+            v.assign(n, "");
+            for(auto& s: v) readString(in, s);
+        }
+
+        static void writeHeader(std::ofstream& out, unsigned int magic, unsigned int version)
+        {
+            writePOD(out, magic);
+            writePOD(out, version);
+        }
+
+        // false if the file doesn't start with the magic number and version
+        static bool readHeader(std::ifstream& in, unsigned int magic, unsigned int version)
+        {
+            unsigned int m = 0, v = 0;
+            readPOD(in, m);
+            readPOD(in, v);
+            return in && m == magic && v == version;
+        }
+
+        static std::string temporary(const std::string& filename) { return filename+".tmp."+std::to_string(getpid()); }
+
+        static bool openTemporary(std::ofstream& out, const std::string& filename)
+        {
+            out.open(temporary(filename).c_str(), std::ios::binary);
+            return out.good();
+        }
+
+        // close the temporary file and move it over filename
+        static bool commitTemporary(std::ofstream& out, const std::string& filename)
+        {
+            out.close();
+            std::string tmp = temporary(filename);
+            return out.good() && std::rename(tmp.c_str(), filename.c_str()) == 0;
+        }
+};
+
+#endif
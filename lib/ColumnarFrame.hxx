@@ -0,0 +1,484 @@
+///////////////////////////////////////////////////////////////////////////
+// ======================================================================//
+// ColumnarFrame.hxx                                                     //
+// ======================================================================//
+// Columnar binary dataframe for the training exports, in place of the   //
+// csv files and the TNtuple. The file has an explicit schema of typed   //
+// columns, and the rows are written in row groups as they are filled,   //
+// each column of a row group in its own chunk, zlib compressed when     //
+// that makes it smaller. The schema, metadata, and the chunk index are  //
+// in a footer at the end, so a writer never holds more than one row     //
+// group and a reader finds everything from the last 12 bytes.           //
+//                                                                       //
+// Chunks start on 8 byte boundaries, so an uncompressed chunk can be    //
+// used in place from a memory map, e.g. numpy.frombuffer in             //
+// python/plotting_tools/columnar_frame.py. Categorical columns, like    //
+// the sample label, store int32 codes into a dictionary of strings      //
+// kept in the schema.                                                   //
+//                                                                       //
+// layout: "CFRM" version | chunks ... | footer | footer offset "CFRM"   //
+// ======================================================================//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_COLUMNARFRAME
+#define ADD_COLUMNARFRAME
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+
+#include <zlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "BinaryIO.hxx"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+enum FrameType : unsigned char
+{
+    kFrameFloat32  = 0,
+    kFrameFloat64  = 1,
+    kFrameInt32    = 2,
+    kFrameInt64    = 3,
+    kFrameCategory = 4    // int32 codes into FrameColumn::dictionary
+};
+
+struct FrameColumn
+{
+    std::string name;
+    unsigned char type = kFrameFloat32;
+    std::vector<std::string> dictionary;    // labels of the codes of a category column
+
+    unsigned int width() const
+    {
+        if(type == kFrameFloat64 || type == kFrameInt64) return 8;
+        return 4;
+    }
+};
+
+// where one column of one row group is in the file
+struct FrameChunk
+{
+    unsigned long long offset = 0;     // from the start of the file
+    unsigned long long nbytes = 0;     // stored size
+    unsigned long long rawbytes = 0;   // nrows*width
+    unsigned char codec = 0;           // 0 raw, 1 zlib
+};
+
+struct FrameRowGroup
+{
+    unsigned long long nrows = 0;
+    std::vector<FrameChunk> chunks;    // one per column, in schema order
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+class ColumnarFrame
+{
+    public:
+        static const unsigned int kMagic = 0x4D524643;   // "CFRM"
+        static const unsigned int kVersion = 1;
+        static const unsigned char kRaw = 0;
+        static const unsigned char kZlib = 1;
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+// One writer per output file, not thread safe, use one per sample/thread.
+// Define the columns, open, fill rows, close. Only close writes the frame,
+// a writer destroyed while still open removes its temporary file.
+class ColumnarFrameWriter
+{
+    public:
+        ColumnarFrameWriter(){};
+        ~ColumnarFrameWriter()
+        {
+            if(!out.is_open()) return;
+            out.close();
+            std::remove(BinaryIO::temporary(filename).c_str());
+        };
+
+        std::vector<FrameColumn> columns;
+        std::vector< std::pair<std::string, std::string> > metadata;   // e.g. sample name, type, xsec
+        unsigned long long rowGroupSize = 65536;
+        bool compress = true;
+
+        // returns the index of the column in the row passed to fill
+        int addColumn(const std::string& name, unsigned char type, const std::vector<std::string>& dictionary = std::vector<std::string>())
+        {
+            FrameColumn c;
+            c.name = name;
+            c.type = type;
+            c.dictionary = dictionary;
+            columns.push_back(c);
+            return columns.size()-1;
+        }
+
+        void addMetadata(const std::string& key, const std::string& value)
+        {
+            metadata.push_back(std::make_pair(key, value));
+        }
+
+        // written to a temporary file and renamed on close, so a crashed job doesn't leave a valid looking frame
+        bool open(const std::string& name)
+        {
+            filename = name;
+            if(!BinaryIO::openTemporary(out, filename))
+            {
+                std::cout << "  !!! ColumnarFrameWriter: could not open " << BinaryIO::temporary(filename) << " for writing" << std::endl;
+                return false;
+            }
+            BinaryIO::writeHeader(out, ColumnarFrame::kMagic, ColumnarFrame::kVersion);
+            buffers.assign(columns.size(), std::vector<char>());
+            for(unsigned int c=0; c<columns.size(); c++)
+                buffers[c].reserve(rowGroupSize*columns[c].width());
+            nbuffered = 0;
+            nrows = 0;
+            groups.clear();
+            return true;
+        }
+
+        // one value per column in schema order, converted to the type of the column
+        void fill(const double* row)
+        {
+            for(unsigned int c=0; c<columns.size(); c++)
+            {
+                switch(columns[c].type)
+                {
+                    case kFrameFloat32:  append(c, (float)row[c]); break;
+                    case kFrameFloat64:  append(c, (double)row[c]); break;
+                    case kFrameInt64:    append(c, (long long)row[c]); break;
+                    default:             append(c, (int)row[c]); break;
+                }
+            }
+            nbuffered++;
+            nrows++;
+            if(nbuffered >= rowGroupSize) flushRowGroup();
+        }
+
+        void fill(const std::vector<double>& row) { fill(row.data()); }
+
+        bool close()
+        {
+            if(!out.is_open()) return false;
+            flushRowGroup();
+
+            unsigned long long footer = out.tellp();
+            unsigned int nc = columns.size();
+            BinaryIO::writePOD(out, nc);
+            for(auto& c: columns)
+            {
+                BinaryIO::writeString(out, c.name);
+                BinaryIO::writePOD(out, c.type);
+                unsigned int nd = c.dictionary.size();
+                BinaryIO::writePOD(out, nd);
+                for(auto& d: c.dictionary) BinaryIO::writeString(out, d);
+            }
+
+            unsigned int nm = metadata.size();
+            BinaryIO::writePOD(out, nm);
+            for(auto& m: metadata)
+            {
+                BinaryIO::writeString(out, m.first);
+                BinaryIO::writeString(out, m.second);
+            }
+
+            unsigned int ng = groups.size();
+            BinaryIO::writePOD(out, ng);
+            for(auto& g: groups)
+            {
+                BinaryIO::writePOD(out, g.nrows);
+                for(auto& k: g.chunks)
+                {
+                    BinaryIO::writePOD(out, k.offset);
+                    BinaryIO::writePOD(out, k.nbytes);
+                    BinaryIO::writePOD(out, k.rawbytes);
+                    BinaryIO::writePOD(out, k.codec);
+                }
+            }
+            BinaryIO::writePOD(out, footer);
+            unsigned int magic = ColumnarFrame::kMagic;
+            BinaryIO::writePOD(out, magic);
+            if(!BinaryIO::commitTemporary(out, filename))
+            {
+                std::cout << "  !!! ColumnarFrameWriter: could not write " << filename << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        unsigned long long entries() const { return nrows; }
+
+    private:
+        std::string filename;
+        std::ofstream out;
+        std::vector< std::vector<char> > buffers;   // the current row group, one byte buffer per column
+        std::vector<FrameRowGroup> groups;
+        unsigned long long nbuffered = 0;
+        unsigned long long nrows = 0;
+
+        template<typename T> void append(unsigned int c, T t)
+        {
+            const char* p = (const char*)&t;
+            buffers[c].insert(buffers[c].end(), p, p+sizeof(T));
+        }
+
+        void flushRowGroup()
+        {
+            if(nbuffered == 0) return;
+
+            FrameRowGroup g;
+            g.nrows = nbuffered;
+            std::vector<unsigned char> zbuffer;
+            for(unsigned int c=0; c<columns.size(); c++)
+            {
+                pad();
+                FrameChunk k;
+                k.offset = out.tellp();
+                k.rawbytes = buffers[c].size();
+                k.nbytes = k.rawbytes;
+                k.codec = ColumnarFrame::kRaw;
+
+                const char* data = buffers[c].data();
+                if(compress)
+                {
+                    uLongf zsize = compressBound(k.rawbytes);
+                    zbuffer.resize(zsize);
+                    // keep the chunk raw unless zlib actually saves space, raw chunks can be used in place
+                    if(compress2(zbuffer.data(), &zsize, (const Bytef*)data, k.rawbytes, Z_BEST_SPEED) == Z_OK && zsize < k.rawbytes)
+                    {
+                        k.nbytes = zsize;
+                        k.codec = ColumnarFrame::kZlib;
+                        data = (const char*)zbuffer.data();
+                    }
+                }
+                out.write(data, k.nbytes);
+                g.chunks.push_back(k);
+                buffers[c].clear();
+            }
+            groups.push_back(g);
+            nbuffered = 0;
+        }
+
+        // align the next chunk to 8 bytes
+        void pad()
+        {
+            static const char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+            unsigned long long position = out.tellp();
+            if(position%8 != 0) out.write(zeros, 8-position%8);
+        }
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+// Memory maps a frame and reads the footer. Columns are returned as
+// vectors of the requested type over all of the row groups.
+class ColumnarFrameReader
+{
+    public:
+        ColumnarFrameReader(){};
+        ~ColumnarFrameReader() { close(); };
+
+        std::vector<FrameColumn> columns;
+        std::vector< std::pair<std::string, std::string> > metadata;
+        std::vector<FrameRowGroup> groups;
+
+        bool open(const std::string& filename)
+        {
+            close();
+            int fd = ::open(filename.c_str(), O_RDONLY);
+            if(fd < 0)
+            {
+                std::cout << "  !!! ColumnarFrameReader: could not open " << filename << std::endl;
+                return false;
+            }
+            struct stat st;
+            if(fstat(fd, &st) == 0 && st.st_size >= 20)
+            {
+                size = st.st_size;
+                void* p = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if(p != MAP_FAILED) data = (const char*)p;
+            }
+            ::close(fd);
+
+            if(data == 0 || !readFooter())
+            {
+                std::cout << "  !!! ColumnarFrameReader: " << filename << " is not a version " << ColumnarFrame::kVersion << " columnar frame" << std::endl;
+                close();
+                return false;
+            }
+            return true;
+        }
+
+        void close()
+        {
+            if(data != 0) munmap((void*)data, size);
+            data = 0;
+            size = 0;
+            columns.clear();
+            metadata.clear();
+            groups.clear();
+        }
+
+        unsigned long long entries() const
+        {
+            unsigned long long n = 0;
+            for(auto& g: groups) n += g.nrows;
+            return n;
+        }
+
+        // index of a column, -1 if it isn't there
+        int columnIndex(const std::string& name) const
+        {
+            for(unsigned int c=0; c<columns.size(); c++)
+                if(columns[c].name == name) return c;
+            return -1;
+        }
+
+        std::string getMetadata(const std::string& key) const
+        {
+            for(auto& m: metadata)
+                if(m.first == key) return m.second;
+            return "";
+        }
+
+        // all of the values of a column converted to T, empty if the column isn't there
+        template<typename T> std::vector<T> column(const std::string& name) const
+        {
+            std::vector<T> values;
+            int c = columnIndex(name);
+            if(c < 0) return values;
+            values.reserve(entries());
+
+            std::vector<unsigned char> buffer;
+            for(auto& g: groups)
+            {
+                const FrameChunk& k = g.chunks[c];
+                const char* p = data+k.offset;
+                if(k.codec == ColumnarFrame::kZlib)
+                {
+                    buffer.resize(k.rawbytes);
+                    uLongf rawsize = k.rawbytes;
+                    if(uncompress(buffer.data(), &rawsize, (const Bytef*)p, k.nbytes) != Z_OK || rawsize != k.rawbytes)
+                    {
+                        std::cout << "  !!! ColumnarFrameReader: corrupt chunk in column " << name << std::endl;
+                        return std::vector<T>();
+                    }
+                    p = (const char*)buffer.data();
+                }
+                for(unsigned long long i=0; i<g.nrows; i++)
+                    values.push_back(get<T>(columns[c].type, p, i));
+            }
+            return values;
+        }
+
+    private:
+        const char* data = 0;
+        unsigned long long size = 0;
+
+        template<typename T> static T get(unsigned char type, const char* p, unsigned long long i)
+        {
+            switch(type)
+            {
+                case kFrameFloat32:  return (T)load<float>(p, i);
+                case kFrameFloat64:  return (T)load<double>(p, i);
+                case kFrameInt64:    return (T)load<long long>(p, i);
+                default:             return (T)load<int>(p, i);
+            }
+        }
+
+        template<typename T> static T load(const char* p, unsigned long long i)
+        {
+            T t;
+            std::memcpy(&t, p+i*sizeof(T), sizeof(T));
+            return t;
+        }
+
+        // bounds checked reads of the footer
+        template<typename T> bool readPOD(unsigned long long& pos, T& t) const
+        {
+            if(pos+sizeof(T) > size) return false;
+            std::memcpy(&t, data+pos, sizeof(T));
+            pos += sizeof(T);
+            return true;
+        }
+
+        bool readString(unsigned long long& pos, std::string& s) const
+        {
+            unsigned int n = 0;
+            if(!readPOD(pos, n) || pos+n > size) return false;
+            s.assign(data+pos, n);
+            pos += n;
+            return true;
+        }
+
+        bool readFooter()
+        {
+            unsigned long long pos = 0;
+            unsigned int magic = 0, version = 0;
+            if(!readPOD(pos, magic) || !readPOD(pos, version)) return false;
+            if(magic != ColumnarFrame::kMagic || version != ColumnarFrame::kVersion) return false;
+
+            unsigned long long footer = 0;
+            pos = size-12;
+            if(!readPOD(pos, footer) || !readPOD(pos, magic) || magic != ColumnarFrame::kMagic) return false;
+
+            pos = footer;
+            unsigned int nc = 0;
+            if(!readPOD(pos, nc)) return false;
+            columns.assign(nc, FrameColumn());
+            for(auto& c: columns)
+            {
+                unsigned int nd = 0;
+                if(!readString(pos, c.name) || !readPOD(pos, c.type) || !readPOD(pos, nd)) return false;
+                c.dictionary.assign(nd, "");
+                for(auto& d: c.dictionary)
+                    if(!readString(pos, d)) return false;
+            }
+
+            unsigned int nm = 0;
+            if(!readPOD(pos, nm)) return false;
+            metadata.assign(nm, std::make_pair(std::string(), std::string()));
+            for(auto& m: metadata)
+                if(!readString(pos, m.first) || !readString(pos, m.second)) return false;
+
+            unsigned int ng = 0;
+            if(!readPOD(pos, ng)) return false;
+            groups.assign(ng, FrameRowGroup());
+            for(auto& g: groups)
+            {
+                if(!readPOD(pos, g.nrows)) return false;
+                g.chunks.assign(nc, FrameChunk());
+                for(auto& k: g.chunks)
+                {
+                    if(!readPOD(pos, k.offset) || !readPOD(pos, k.nbytes) || !readPOD(pos, k.rawbytes) || !readPOD(pos, k.codec)) return false;
+                    if(k.offset+k.nbytes > footer) return false;
+                }
+                // column() reads nrows values from each chunk, a raw chunk has to hold them in place
+                for(unsigned int c=0; c<nc; c++)
+                {
+                    const FrameChunk& k = g.chunks[c];
+                    if(k.rawbytes != g.nrows*columns[c].width()) return false;
+                    if(k.codec == ColumnarFrame::kRaw && k.nbytes != k.rawbytes) return false;
+                    if(k.codec != ColumnarFrame::kRaw && k.codec != ColumnarFrame::kZlib) return false;
+                }
+            }
+            return true;
+        }
+};
+
+#endif
@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////
+// ======================================================================//
+// CompletionQueue.hxx                                                   //
+// ======================================================================//
+// Results of ThreadPool tasks in the order the tasks finish, instead of //
+// the order they were enqueued in as with a vector of futures. The      //
+// caller can merge and free each result as soon as it is done, so only  //
+// the results in flight are alive at once and the merging overlaps the  //
+// tasks that are still running. An exception thrown by a task is        //
+// rethrown by the pop() that would have returned its result.            //
+// ======================================================================//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_COMPLETIONQUEUE
+#define ADD_COMPLETIONQUEUE
+
+#include <queue>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+#include "ThreadPool.hxx"
+
+template<typename T>
+class CompletionQueue
+{
+    public:
+        CompletionQueue(){};
+        ~CompletionQueue(){};
+
+        // run f(arg) in the pool, its result goes into this queue when it is done
+        template<class F, class A>
+        void enqueue(ThreadPool& pool, F f, A arg)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                npending++;
+            }
+            pool.enqueue([this, f, arg]()
+            {
+                try
+                {
+                    push(f(arg));
+                }
+                catch(...)
+                {
+                    fail(std::current_exception());
+                }
+            });
+        }
+
+        // the next finished result, waits until a task finishes
+        T pop()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]{ return !done.empty() || !errors.empty(); });
+            npending--;
+            if(!errors.empty())
+            {
+                std::exception_ptr e = errors.front();
+                errors.pop();
+                std::rethrow_exception(e);
+            }
+            T t = done.front();
+            done.pop();
+            return t;
+        }
+
+        // number of enqueued tasks whose result hasn't been popped yet
+        int pending()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            return npending;
+        }
+
+    private:
+        std::queue<T> done;
+        std::queue<std::exception_ptr> errors;
+        int npending = 0;
+
+        std::mutex mutex;
+        std::condition_variable condition;
+
+        void push(T t)
+        {
+            // notify under the lock, the queue may be gone as soon as the consumer has the result
+            std::unique_lock<std::mutex> lock(mutex);
+            done.push(t);
+            condition.notify_one();
+        }
+
+        void fail(std::exception_ptr e)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            errors.push(e);
+            condition.notify_one();
+        }
+};
+
+#endif
@@ -30,6 +30,13 @@ class Cut
                                                     // if possible 
         virtual void makeCutSet() = 0;              // book keeping for all of the cuts, useful for the N-1 plots, significance optimization
                                                     // and debugging
+
+        virtual unsigned int evaluateCuts(VarSet& vars)  // evaluate every cut whether it is on or not, record the values and results in the cutset
+        {                                                // and return a bitmask with bit i set if cuts[i] passed. Used for the N-1 plots and
+                                                         // cutflows. This default only knows the combined result of the cuts that are on.
+            unsigned int all = (cutset.cuts.size() >= 32)?0xFFFFFFFF:((1u << cutset.cuts.size()) - 1);
+            return evaluate(vars)?all:0;
+        }
 };
 
 #endif
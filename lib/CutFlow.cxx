@@ -0,0 +1,215 @@
+///////////////////////////////////////////////////////////////////////////
+// ======================================================================//
+// CutFlow.cxx                                                           //
+// ======================================================================//
+// Fill the N-1 distributions, the sequential cutflow, and the per cut   //
+// efficiencies for a set of Cut objects in a single pass over the data. //
+// ======================================================================//
+///////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////
+// _______________________Includes_______________________________________//
+///////////////////////////////////////////////////////////////////////////
+
+#include "CutFlow.h"
+#include <iostream>
+
+///////////////////////////////////////////////////////////////////////////
+// _______________________Setup__________________________________________//
+///////////////////////////////////////////////////////////////////////////
+
+void CutFlow::addCut(Cut* cut)
+{
+    cutObjects.push_back(cut);
+    for(auto& c: cut->cutset.cuts)
+    {
+        CutFlowCut cfc;
+        cfc.name = c.name;
+        cfc.on = c.on;
+        cfc.bins = c.bins;
+        cfc.min = c.min;
+        cfc.max = c.max;
+        cuts.push_back(cfc);
+    }
+
+    if(cuts.size() > 64)
+        std::cout << Form("  !!! CutFlow: %d cuts registered, only the first 64 fit in the bitmask \n", (int)cuts.size());
+
+    values.resize(cuts.size(), -9999);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+CutFlowHistos& CutFlow::book(TString key)
+{
+    auto it = histos.find(key);
+    if(it != histos.end()) return it->second;
+
+    CutFlowHistos& h = histos[key];
+    TString base = key;
+    if(suffix != "") base += "_"+suffix;
+
+    int n = cuts.size();
+    h.cutflow = new TH1D(base+"_cutflow", base+"_cutflow", n+1, 0, n+1);
+    h.passed  = new TH1D(base+"_passed",  base+"_passed",  n+1, 0, n+1);
+    h.cutflow->GetXaxis()->SetBinLabel(1, "all");
+    h.passed->GetXaxis()->SetBinLabel(1, "all");
+
+    for(int i=0; i<n; i++)
+    {
+        TString label = cuts[i].name;
+        if(!cuts[i].on) label += " (off)";
+        h.cutflow->GetXaxis()->SetBinLabel(i+2, label);
+        h.passed->GetXaxis()->SetBinLabel(i+2, label);
+
+        TString hname = base+Form("_nm1_%d", i);
+        TH1D* nm1 = new TH1D(hname, cuts[i].name, cuts[i].bins, cuts[i].min, cuts[i].max);
+        nm1->GetXaxis()->SetTitle(cuts[i].name);
+        h.nm1.push_back(nm1);
+    }
+    return h;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// _______________________Evaluate_______________________________________//
+///////////////////////////////////////////////////////////////////////////
+
+ULong64_t CutFlow::evaluate(VarSet& vars)
+{
+// each Cut fills its own cutset values, we copy them out in bit order
+    ULong64_t mask = 0;
+    unsigned int offset = 0;
+    for(auto& c: cutObjects)
+    {
+        ULong64_t cmask = c->evaluateCuts(vars);
+        if(offset < 64) mask |= (cmask << offset);
+        for(unsigned int i=0; i<c->cutset.cuts.size(); i++)
+            values[offset+i] = c->cutset.cuts[i].value;
+        offset += c->cutset.cuts.size();
+    }
+    return mask;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+ULong64_t CutFlow::onMask()
+{
+    ULong64_t mask = 0;
+    for(unsigned int i=0; i<cuts.size() && i<64; i++)
+        if(cuts[i].on) mask |= (1ULL << i);
+    return mask;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+bool CutFlow::passes(ULong64_t mask)
+{
+    ULong64_t on = onMask();
+    return (mask & on) == on;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+int CutFlow::nFailed(ULong64_t mask)
+{
+    ULong64_t failed = onMask() & ~mask;
+    int n = 0;
+    for(; failed; failed &= failed-1) n++;
+    return n;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// _______________________Fill___________________________________________//
+///////////////////////////////////////////////////////////////////////////
+
+void CutFlow::fill(TString key, ULong64_t mask, double weight)
+{
+    CutFlowHistos& h = book(key);
+    ULong64_t on = onMask();
+
+    h.cutflow->Fill(0.5, weight);
+    h.passed->Fill(0.5, weight);
+
+    bool passedSoFar = true;
+    for(unsigned int i=0; i<cuts.size() && i<64; i++)
+    {
+        ULong64_t bit = 1ULL << i;
+
+        // individual efficiency
+        if(mask & bit) h.passed->Fill(i+1.5, weight);
+
+        // sequential cutflow, the cuts that are off don't remove anything
+        if(cuts[i].on && !(mask & bit)) passedSoFar = false;
+        if(passedSoFar) h.cutflow->Fill(i+1.5, weight);
+
+        // N-1, passes every cut that is on except for this one
+        if(((mask | bit) & on) == on) h.nm1[i]->Fill(values[i], weight);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+void CutFlow::scale(double sf)
+{
+    for(auto& h: histos)
+    {
+        h.second.cutflow->Scale(sf);
+        h.second.passed->Scale(sf);
+        for(auto& nm1: h.second.nm1)
+            nm1->Scale(sf);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+TList* CutFlow::getList()
+{
+    TList* list = new TList();
+    for(auto& h: histos)
+    {
+        list->Add(h.second.cutflow);
+        list->Add(h.second.passed);
+        for(auto& nm1: h.second.nm1)
+            list->Add(nm1);
+    }
+    return list;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// _______________________Output_________________________________________//
+///////////////////////////////////////////////////////////////////////////
+
+void CutFlow::outputEfficiencies(TString key)
+{
+// individual, sequential, and N-1 efficiency for each cut
+    if(histos.find(key) == histos.end()) return;
+    CutFlowHistos& h = histos[key];
+
+    double all = h.cutflow->GetBinContent(1);
+    double allPassed = h.cutflow->GetBinContent(cuts.size()+1);
+
+    std::cout << Form("  /// CutFlow %s %s, all: %f, passed: %f \n", key.Data(), suffix.Data(), all, allPassed);
+    for(unsigned int i=0; i<cuts.size(); i++)
+    {
+        double passed = h.passed->GetBinContent(i+2);
+        double before = h.cutflow->GetBinContent(i+1);
+        double after  = h.cutflow->GetBinContent(i+2);
+        double nm1    = h.nm1[i]->Integral(0, h.nm1[i]->GetNbinsX()+1);
+
+        std::cout << Form("    %-40s  eff: %6.4f,  seq eff: %6.4f,  N-1 eff: %6.4f %s\n", cuts[i].name.Data(),
+                          (all>0)?passed/all:0, (before>0)?after/before:0, (nm1>0)?allPassed/nm1:0, cuts[i].on?"":"(off)");
+    }
+    std::cout << std::endl;
+}
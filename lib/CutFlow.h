@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////
+// ======================================================================//
+// CutFlow.h                                                             //
+// ======================================================================//
+// Fill the N-1 distributions, the sequential cutflow, and the per cut   //
+// efficiencies for a set of Cut objects in a single pass over the data. //
+// Each registered Cut gets a range of bits in the event bitmask made    //
+// from Cut::evaluateCuts. Histograms are booked per key, e.g. one key   //
+// per category, and named key_suffix_... so that the CutFlows for the   //
+// different samples can be merged.                                     //
+// ======================================================================//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_CUTFLOW
+#define ADD_CUTFLOW
+
+#include "Cut.h"
+#include "VarSet.h"
+#include "TH1D.h"
+#include "TList.h"
+#include "TString.h"
+#include <vector>
+#include <map>
+
+struct CutFlowHistos
+{
+    TH1D* cutflow = 0;         // bin 1 is all events, bin i+2 is the events passing cuts 0..i that are on
+    TH1D* passed = 0;          // bin 1 is all events, bin i+2 is the events passing cut i by itself
+    std::vector<TH1D*> nm1;    // the value of cut i for events passing all of the other cuts that are on
+};
+
+// what the histograms and the efficiencies need from a CutInfo, copied so the CutFlow
+// stays valid after the Cut objects it was set up from are gone
+struct CutFlowCut
+{
+    TString name = "";
+    bool on = true;
+    int bins = 50;
+    float min = 0;
+    float max = 200;
+};
+
+class CutFlow
+{
+    public:
+        CutFlow(){};
+        CutFlow(TString suffix){ this->suffix = suffix; };
+        ~CutFlow(){};
+
+        TString suffix = "";                        // appended to the histogram names, usually the sample name
+
+        std::vector<Cut*> cutObjects;               // the registered Cut objects, only used by evaluate
+        std::vector<CutFlowCut> cuts;               // all of the cuts in the order of their bits
+        std::vector<float> values;                  // the cut values from the last call to evaluate
+
+        std::map<TString, CutFlowHistos> histos;    // histograms for each key
+
+        void addCut(Cut* cut);                      // register a configured Cut, its cuts get the next bits in the bitmask
+        ULong64_t evaluate(VarSet& vars);           // run evaluateCuts for each Cut and return the combined bitmask
+        ULong64_t onMask();                         // bits of the cuts that are turned on
+        bool passes(ULong64_t mask);                // passes all of the cuts that are on
+        int nFailed(ULong64_t mask);                // number of cuts that are on and failed
+
+        void fill(TString key, ULong64_t mask, double weight);  // fill using the values from the last evaluate
+        void scale(double sf);                                   // scale all of the histograms, e.g. by the lumi scale factor
+
+        CutFlowHistos& book(TString key);
+        TList* getList();                           // all of the histograms in a list, for saving
+        void outputEfficiencies(TString key);
+};
+
+#endif
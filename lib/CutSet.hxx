@@ -117,6 +117,30 @@ class CutSet
         {
             cuts[i].on = true;
         }
+
+        // record the value and result for cut i, returns the bit for the bitmask from Cut::evaluateCuts
+        unsigned int setResult(int i, float value, bool passed)
+        {
+            cuts[i].value = value;
+            cuts[i].passed = passed;
+            return passed?(1u << i):0;
+        }
+
+        // bitmask of the cuts that are turned on
+        unsigned int onMask()
+        {
+            unsigned int mask = 0;
+            for(unsigned int i=0; i<cuts.size(); i++)
+                if(cuts[i].on) mask |= (1u << i);
+            return mask;
+        }
+
+        // whether the results from Cut::evaluateCuts pass all of the cuts that are on
+        bool passes(unsigned int mask)
+        {
+            unsigned int on = onMask();
+            return (mask & on) == on;
+        }
 };
 
 #endif
@@ -248,6 +248,40 @@ TCanvas* DiMuPlottingSystem::overlay(TList* ilist, float ymin, float ymax, TStri
 // ----------------------------------------------------------------------
 //////////////////////////////////////////////////////////////////////////
 
+void DiMuPlottingSystem::styleStack(TList* ilist)
+{
+// The fill and line colors of the stack and the data marker that stackComparison draws with.
+// Call this before handing the histos to a forked worker if the saved histos should have the
+// same style as when the stack is drawn in this process.
+
+  std::vector<int> colors = {58, 2, 8, 36, 91, 46, 50, 30, 9, 29, 3, 42, 98, 62, 74, 20, 29, 32, 49, 12, 3, 91};
+
+  TIter next(ilist);
+  TObject* object = 0;
+  int i=0;
+
+  while ((object = next()))
+  {
+      TH1D* hist = (TH1D*) object;
+      hist->SetStats(0);
+      hist->SetFillColor(colors[i]);
+      hist->SetLineColor(colors[i]);
+
+      // Assuming data is in the last location
+      if(object == ilist->Last())
+      {
+          hist->SetMarkerStyle(20);
+          hist->SetLineColor(1);
+          hist->SetFillColor(0);
+      }
+      i++;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// ----------------------------------------------------------------------
+//////////////////////////////////////////////////////////////////////////
+
 THStack* DiMuPlottingSystem::stackComparison(TList* ilist, TString title, TString xaxistitle, TString yaxistitle, bool log, bool stats, int legend)
 {
 // Creates a THStack of the histograms in the list. Overlays the data ontop of this without adding it to the stack.
@@ -278,15 +312,12 @@ THStack* DiMuPlottingSystem::stackComparison(TList* ilist, TString title, TStrin
   float minimum = 999999999;
   float minMax = 999999999;
 
-  std::vector<int> colors = {58, 2, 8, 36, 91, 46, 50, 30, 9, 29, 3, 42, 98, 62, 74, 20, 29, 32, 49, 12, 3, 91};
+  styleStack(ilist);
 
   while ((object = next()))
   {
       TH1D* hist = (TH1D*) object;
       //std::cout << Form("%d: Adding %s to the stack \n", i, hist->GetName());
-      hist->SetStats(0);
-      hist->SetFillColor(colors[i]);
-      hist->SetLineColor(colors[i]);
 
       // Print name + num events in legend
       TString legend_entry = TString(hist->GetTitle());
@@ -308,10 +339,6 @@ THStack* DiMuPlottingSystem::stackComparison(TList* ilist, TString title, TStrin
       // Assuming data is in the last location
       if(object == ilist->Last())
       {
-          hist->SetMarkerStyle(20);
-          hist->SetLineColor(1);
-          hist->SetFillColor(0);
-
           stack->Draw("hist");
           stack->GetXaxis()->SetTitle(xaxistitle);
           stack->GetYaxis()->SetTitle(yaxistitle);
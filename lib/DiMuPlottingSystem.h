@@ -49,6 +49,7 @@ class DiMuPlottingSystem
         // ====================================================
 
         static TList* groupMC(TList* list, TString categoryName, TString suffix="");
+        static void styleStack(TList* list);
         static THStack* stackComparison(TList* list, TString title, TString xaxistitle, TString yaxistitle, bool log = true, bool stats = false, int legend = 0);
         static TCanvas* overlay(TList* list, float ymin, float ymax, TString name, TString title, TString xaxistitle, TString yaxistitle, bool log = true);
 
@@ -0,0 +1,168 @@
+///////////////////////////////////////////////////////////////////////////
+// ======================================================================//
+// DijetPairing.hxx                                                      //
+// ======================================================================//
+// Find the dijet pair used for the vbf and standard jet variables.      //
+// The cartesian components of each valid jet are computed once, then   //
+// the pair masses and dEtas are computed in a tight loop over the       //
+// pairs. If the analyzer's jetPairs collection has every pair of the    //
+// valid jets in it we use its mass and dEta instead.                    //
+// ======================================================================//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_DIJETPAIRING
+#define ADD_DIJETPAIRING
+
+#include "JetPairInfo.h"
+#include "TLorentzVector.h"
+#include <vector>
+#include <cmath>
+#include <utility>
+
+class DijetPairing
+{
+    public:
+        DijetPairing(){};
+        ~DijetPairing(){};
+
+        // load the valid jets for this event
+        void load(std::vector<TLorentzVector>& jets)
+        {
+            n = jets.size();
+            usePairs = false;
+            pt.resize(n);
+            eta.resize(n);
+            px.resize(n);
+            py.resize(n);
+            pz.resize(n);
+            e.resize(n);
+            for(unsigned int i=0; i<n; i++)
+            {
+                pt[i]  = jets[i].Pt();
+                eta[i] = jets[i].Eta();
+                px[i]  = jets[i].Px();
+                py[i]  = jets[i].Py();
+                pz[i]  = jets[i].Pz();
+                e[i]   = jets[i].E();
+            }
+        }
+
+        // use the mass and dEta from the analyzer's jetPairs if every pair of valid jets
+        // is in the collection. validJetsIdx maps each valid jet to its index in the raw jets
+        // and is empty if the cleaning didn't keep track of it. Returns whether the pairs are used.
+        bool loadPairs(std::vector<JetPairInfo>* jetPairs, std::vector<int>& validJetsIdx, unsigned int nRawJets)
+        {
+            usePairs = false;
+            if(jetPairs == 0 || n < 2 || validJetsIdx.size() != n) return false;
+
+            // raw jet index -> valid jet index, -1 for the jets that didn't pass the cleaning
+            validIndex.assign(nRawJets, -1);
+            for(unsigned int i=0; i<n; i++)
+            {
+                if(validJetsIdx[i] < 0 || (unsigned int)validJetsIdx[i] >= nRawJets) return false;
+                validIndex[validJetsIdx[i]] = i;
+            }
+
+            // only the pairs of two valid jets are kept, indexed by i*n + j with i < j
+            pairMass.resize(n*n);
+            pairAbsDEta.resize(n*n);
+            pairFound.assign(n*n, 0);
+            unsigned int nfound = 0;
+            for(auto& pair: *jetPairs)
+            {
+                unsigned int a = pair.iJet1;
+                unsigned int b = pair.iJet2;
+                if(a >= nRawJets || b >= nRawJets) continue;
+                int i = validIndex[a];
+                int j = validIndex[b];
+                if(i < 0 || j < 0 || i == j) continue;
+                if(i > j) std::swap(i, j);
+                if(!pairFound[i*n + j]) nfound++;
+                pairFound[i*n + j] = 1;
+                pairMass[i*n + j] = pair.mass;
+                pairAbsDEta[i*n + j] = std::fabs(pair.dEta);
+            }
+            if(nfound != n*(n-1)/2) return false;
+            usePairs = true;
+            return true;
+        }
+
+        // vbf pair: the first pair, with a lead jet above leadPtMin, passing the vbf tight mjj and dEta cuts.
+        // If no pair passes, the max mjj pair among those with a lead jet above leadPtMin.
+        // j0, j1 are left alone if there are no such pairs.
+        void findVBFPair(double leadPtMin, double mjjMin, double dEtaMin, int& j0, int& j1)
+        {
+            double mjj_max = -999;
+            for(unsigned int i=0; i<n; i++)
+            {
+                if(!(pt[i] > leadPtMin)) break;
+                for(unsigned int j=i+1; j<n; j++)
+                {
+                    double mjj = mass(i, j);
+                    if(mjj > mjj_max)
+                    {
+                        mjj_max = mjj;
+                        j0 = i;
+                        j1 = j;
+                    }
+                    if(mjj > mjjMin && absDEta(i, j) > dEtaMin)
+                    {
+                        j0 = i;
+                        j1 = j;
+                        return;
+                    }
+                }
+            }
+        }
+
+        // the pair with the largest mjj, j0, j1 are left alone if there are fewer than two jets
+        void findMaxMassPair(int& j0, int& j1)
+        {
+            double mjj_max = -999;
+            for(unsigned int i=0; i<n; i++)
+            {
+                for(unsigned int j=i+1; j<n; j++)
+                {
+                    double mjj = mass(i, j);
+                    if(mjj > mjj_max)
+                    {
+                        mjj_max = mjj;
+                        j0 = i;
+                        j1 = j;
+                    }
+                }
+            }
+        }
+
+        double mass(unsigned int i, unsigned int j)
+        {
+            if(usePairs) return pairMass[i*n + j];
+
+            // same as TLorentzVector::M()
+            double sx = px[i] + px[j];
+            double sy = py[i] + py[j];
+            double sz = pz[i] + pz[j];
+            double se = e[i] + e[j];
+            double mm = se*se - sx*sx - sy*sy - sz*sz;
+            return mm < 0 ? -std::sqrt(-mm) : std::sqrt(mm);
+        }
+
+        double absDEta(unsigned int i, unsigned int j)
+        {
+            if(usePairs) return pairAbsDEta[i*n + j];
+            return std::fabs(eta[i] - eta[j]);
+        }
+
+    private:
+        unsigned int n = 0;
+        bool usePairs = false;
+
+        std::vector<double> pt, eta, px, py, pz, e;
+
+        // filled from the analyzer's jetPairs, indexed by i*n + j for valid jets i < j
+        std::vector<int> validIndex;
+        std::vector<char> pairFound;
+        std::vector<double> pairMass, pairAbsDEta;
+};
+
+#endif
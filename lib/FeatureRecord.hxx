@@ -0,0 +1,208 @@
+///////////////////////////////////////////////////////////////////////////
+// ======================================================================//
+// FeatureRecord.hxx                                                     //
+// ======================================================================//
+// Per sample side file with what the categorizations need for each      //
+// selected event: the weight, the dimuon mass, the values of the        //
+// features the categorization XMLs split on, and the categories of the  //
+// fixed schemes (run1, bdt) the event is in. Candidate categorizations  //
+// can then be compared without reading the ROOT files, see              //
+// bin/writeFeatureRecords.cxx and bin/sweepCategorizations.cxx.         //
+//                                                                       //
+// The features are stored as the double VarSet::getValue returns, the   //
+// value the XMLCategorizer compares to the split values, so an event    //
+// goes to the same daughter in the sweep as in the XMLCategorizer.      //
+// ======================================================================//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_FEATURERECORD
+#define ADD_FEATURERECORD
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+
+#include "BinaryIO.hxx"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct FeatureEvent
+{
+    long long entry = 0;        // entry in the sample's TChain
+    float weight = 1;           // Sample::getWeight() for the event
+    float mass = 0;             // dimu mass_PF of the selected candidate
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+class FeatureRecord
+{
+    public:
+        FeatureRecord(){};
+        ~FeatureRecord(){};
+
+        static const unsigned int kMagic = 0x52544546;   // "FETR"
+        static const unsigned int kVersion = 2;
+
+        // header
+        std::string name;
+        std::string sampleType;
+        double xsec = 0;
+        double nOriginalWeighted = 0;
+        std::vector<std::string> features;                       // VarSet names, the order of the values for each event
+        std::vector<std::string> schemes;                        // fixed categorizations stored as a category mask per event
+        std::vector< std::vector<std::string> > schemeCategories; // category keys of each scheme in id order, at most 64
+
+        // body, nfeatures values and nschemes masks for each event in flat vectors
+        std::vector<FeatureEvent> events;
+        std::vector<double> values;
+        std::vector<unsigned long long> masks;
+
+        unsigned int nfeatures() const { return features.size(); }
+        unsigned int nschemes() const { return schemes.size(); }
+
+        const double* eventValues(unsigned int i) const { return &values[i*features.size()]; }
+        unsigned long long eventMask(unsigned int i, unsigned int scheme) const { return masks[i*schemes.size()+scheme]; }
+
+        // index of a feature, -1 if it wasn't recorded
+        int featureIndex(const std::string& feature) const
+        {
+            for(unsigned int f=0; f<features.size(); f++)
+                if(features[f] == feature) return f;
+            return -1;
+        }
+
+        int schemeIndex(const std::string& scheme) const
+        {
+            for(unsigned int s=0; s<schemes.size(); s++)
+                if(schemes[s] == scheme) return s;
+            return -1;
+        }
+
+        void addEvent(long long entry, float weight, float mass, const std::vector<double>& x, const std::vector<unsigned long long>& m)
+        {
+            FeatureEvent e;
+            e.entry = entry;
+            e.weight = weight;
+            e.mass = mass;
+            events.push_back(e);
+            values.insert(values.end(), x.begin(), x.end());
+            masks.insert(masks.end(), m.begin(), m.end());
+        }
+
+        //////////////////////////////////////////////////////////////
+        // I/O ------------------------------------------------------
+        //////////////////////////////////////////////////////////////
+
+        bool write(const std::string& filename) const
+        {
+            std::ofstream out;
+            if(!BinaryIO::openTemporary(out, filename))
+            {
+                std::cout << "  !!! FeatureRecord: could not open " << BinaryIO::temporary(filename) << " for writing" << std::endl;
+                return false;
+            }
+
+            BinaryIO::writeHeader(out, kMagic, kVersion);
+            BinaryIO::writeString(out, name);
+            BinaryIO::writeString(out, sampleType);
+            BinaryIO::writePOD(out, xsec);
+            BinaryIO::writePOD(out, nOriginalWeighted);
+
+            unsigned int nf = features.size();
+            BinaryIO::writePOD(out, nf);
+            for(auto& f: features) BinaryIO::writeString(out, f);
+
+            unsigned int ns = schemes.size();
+            BinaryIO::writePOD(out, ns);
+            for(unsigned int s=0; s<ns; s++)
+            {
+                BinaryIO::writeString(out, schemes[s]);
+                unsigned int nc = schemeCategories[s].size();
+                BinaryIO::writePOD(out, nc);
+                for(auto& c: schemeCategories[s]) BinaryIO::writeString(out, c);
+            }
+
+            unsigned long long nevents = events.size();
+            BinaryIO::writePOD(out, nevents);
+            if(nevents > 0) out.write((const char*)events.data(), nevents*sizeof(FeatureEvent));
+            if(values.size() > 0) out.write((const char*)values.data(), values.size()*sizeof(double));
+            if(masks.size() > 0)  out.write((const char*)masks.data(), masks.size()*sizeof(unsigned long long));
+
+            if(!BinaryIO::commitTemporary(out, filename))
+            {
+                std::cout << "  !!! FeatureRecord: could not write " << filename << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        bool read(const std::string& filename)
+        {
+            std::ifstream in(filename.c_str(), std::ios::binary);
+            if(!in)
+            {
+                std::cout << "  !!! FeatureRecord: could not open " << filename << std::endl;
+                return false;
+            }
+
+            if(!BinaryIO::readHeader(in, kMagic, kVersion))
+            {
+                std::cout << "  !!! FeatureRecord: " << filename << " is not a version " << kVersion << " feature record" << std::endl;
+                return false;
+            }
+
+            BinaryIO::readString(in, name);
+            BinaryIO::readString(in, sampleType);
+            BinaryIO::readPOD(in, xsec);
+            BinaryIO::readPOD(in, nOriginalWeighted);
+
+            unsigned int nf = 0;
+            BinaryIO::readPOD(in, nf);
+            features.assign(nf, "");
+            for(auto& f: features) BinaryIO::readString(in, f);
+
+            unsigned int ns = 0;
+            BinaryIO::readPOD(in, ns);
+            schemes.assign(ns, "");
+            schemeCategories.assign(ns, std::vector<std::string>());
+            for(unsigned int s=0; s<ns; s++)
+            {
+                BinaryIO::readString(in, schemes[s]);
+                unsigned int nc = 0;
+                BinaryIO::readPOD(in, nc);
+                schemeCategories[s].assign(nc, "");
+                for(auto& c: schemeCategories[s]) BinaryIO::readString(in, c);
+            }
+
+            unsigned long long nevents = 0;
+            BinaryIO::readPOD(in, nevents);
+            events.resize(nevents);
+            values.resize(nevents*nf);
+            masks.resize(nevents*ns);
+            if(nevents > 0) in.read((char*)events.data(), nevents*sizeof(FeatureEvent));
+            if(values.size() > 0) in.read((char*)values.data(), values.size()*sizeof(double));
+            if(masks.size() > 0)  in.read((char*)masks.data(), masks.size()*sizeof(unsigned long long));
+
+            if(!in)
+            {
+                std::cout << "  !!! FeatureRecord: " << filename << " is truncated" << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        // same as Sample::getLumiScaleFactor
+        double getLumiScaleFactor(double luminosity) const
+        {
+            if(sampleType == "data") return 1.0;
+            return luminosity*xsec/nOriginalWeighted;
+        }
+};
+
+#endif
@@ -0,0 +1,156 @@
+///////////////////////////////////////////////////////////////////////////
+// ======================================================================//
+// FillPlan.hxx                                                          //
+// ======================================================================//
+// Table of the histograms to fill for each category x variable, built   //
+// once after the histograms are booked. The variables are resolved to   //
+// VarSet handles and the histograms are looked up from the category     //
+// histoMaps at setup, so the per event fill is a gather of the values   //
+// followed by a walk over the categories the event is in. The fills go  //
+// to HistAccumulators, call flush() after the event loop to put them    //
+// into the booked histograms and addToCube() to store them in a         //
+// ResultCube. Variables for the cube only don't need booked histograms. //
+// With auto binning the first variable also goes to an AutoGrid per     //
+// category, see AutoBinning.hxx.                                        //
+// ======================================================================//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_FILLPLAN
+#define ADD_FILLPLAN
+
+#include "VarSet.h"
+#include "CategorySelection.h"
+#include "HistAccumulator.hxx"
+#include "ResultCube.hxx"
+#include "AutoBinning.hxx"
+#include "TH1D.h"
+#include "TString.h"
+#include <vector>
+
+class FillPlan
+{
+    public:
+        FillPlan(){};
+        ~FillPlan(){};
+
+        int nvars = 0;
+        int ncategories = 0;
+
+        std::vector<TString> varnames;
+        std::vector<VarSet::VarHandle> handles;
+        std::vector<bool> blindable;      // variable is the dimuon mass, skip it for blinded events
+        std::vector<double> values;       // values for the current event
+
+        // table[id*nvars + v] is the histogram for category id and variable v, 0 to skip,
+        // accumulators[id*nvars + v] collects its fills until the flush
+        std::vector<TH1D*> table;
+        std::vector<HistAccumulator> accumulators;
+
+        // grids[id] collects the first variable's fills for the auto binning, empty without it.
+        // Each starts as autoGrid, see AutoBinning::makeGrid.
+        bool autoBinning = false;
+        AutoGrid autoGrid;
+        std::vector<AutoGrid> grids;
+
+        // add a variable and the histoMap key its histograms are booked under
+        void addVariable(TString varname, TString hkey)
+        {
+            varnames.push_back(varname);
+            hkeys.push_back(hkey);
+            binnings.push_back(HistAccumulator());
+            blindable.push_back(varname.Contains("dimu_mass"));
+            nvars = varnames.size();
+        }
+
+        // add a variable that is only accumulated for the cube, with its own binning
+        void addVariable(TString varname, int nbins, double min, double max)
+        {
+            varnames.push_back(varname);
+            hkeys.push_back("");
+            binnings.push_back(HistAccumulator(nbins, min, max));
+            blindable.push_back(varname.Contains("dimu_mass"));
+            nvars = varnames.size();
+        }
+
+        // resolve the histograms and the variables, call after the histograms are booked
+        // and after the categorizer has indexed its categories. Hidden categories are skipped.
+        void build(Categorizer& categorizer, VarSet& vars)
+        {
+            ncategories = categorizer.categories.size();
+            table.assign(ncategories*nvars, (TH1D*)0);
+            accumulators.assign(ncategories*nvars, HistAccumulator());
+            grids.assign(autoBinning?ncategories:0, autoGrid);
+            for(int id=0; id<ncategories; id++)
+            {
+                Category& c = *categorizer.categories[id];
+                if(c.hide) continue;
+                for(int v=0; v<nvars; v++)
+                {
+                    if(binnings[v].nbins > 0)
+                    {
+                        accumulators[id*nvars+v] = binnings[v];
+                        continue;
+                    }
+                    auto h = c.histoMap.find(hkeys[v]);
+                    if(h == c.histoMap.end()) continue;
+                    table[id*nvars+v] = h->second;
+                    accumulators[id*nvars+v] = HistAccumulator(h->second);
+                }
+            }
+
+            handles.resize(nvars);
+            values.resize(nvars);
+            for(int v=0; v<nvars; v++)
+                handles[v] = vars.getHandle(varnames[v].Data());
+        }
+
+        // fill the histograms for the categories the event is in with a weight computed once for the event
+        void fill(Categorizer& categorizer, VarSet& vars, double weight, bool blindEvent)
+        {
+            for(int v=0; v<nvars; v++)
+                values[v] = vars.getValue(handles[v]);
+
+            for(int id : categorizer.inIds)
+            {
+                HistAccumulator* acc = &accumulators[id*nvars];
+                for(int v=0; v<nvars; v++)
+                {
+                    if(acc[v].nbins == 0) continue;
+                    if(blindEvent && blindable[v]) continue;
+                    acc[v].fill(values[v], weight);
+                }
+                if(autoBinning && acc[0].nbins > 0 && !(blindEvent && blindable[0]))
+                    grids[id].fill(values[0], weight);
+            }
+        }
+
+        // put the accumulated fills into the histograms, before they are scaled or read
+        void flush()
+        {
+            for(unsigned int i=0; i<table.size(); i++)
+                if(table[i] != 0) accumulators[i].fillTH1D(table[i]);
+        }
+
+        // store every category x variable in the cube scaled by c, the same scale the histograms get
+        void addToCube(ResultCube& cube, Categorizer& categorizer, TString sample, TString sampleType,
+                       TString systematic, TString calibration, double c)
+        {
+            for(int id=0; id<ncategories; id++)
+            {
+                Category& category = *categorizer.categories[id];
+                for(int v=0; v<nvars; v++)
+                {
+                    HistAccumulator& acc = accumulators[id*nvars+v];
+                    if(acc.nbins == 0) continue;
+                    cube.setSlice(category.name.Data(), sample.Data(), sampleType.Data(), systematic.Data(),
+                                  calibration.Data(), varnames[v].Data(), acc, c);
+                }
+            }
+        }
+
+    private:
+        std::vector<TString> hkeys;
+        std::vector<HistAccumulator> binnings;   // binning of the cube only variables, empty for the others
+};
+
+#endif
@@ -0,0 +1,163 @@
+///////////////////////////////////////////////////////////////////////////
+// ======================================================================//
+// HistAccumulator.hxx                                                   //
+// ======================================================================//
+// Sum of weights and sum of weights squared per bin in plain arrays,    //
+// for filling in the event loop instead of TH1D::Fill. The bin lookup   //
+// and the statistics are the same as TH1::Fill and TAxis::FindBin, so   //
+// the TH1D made from the accumulator at the end has the same contents,  //
+// errors, entries, and moments as one filled directly. Each thread      //
+// keeps its own accumulators, nothing here is shared.                   //
+// ======================================================================//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_HISTACCUMULATOR
+#define ADD_HISTACCUMULATOR
+
+#include <vector>
+#include <algorithm>
+
+#include "TH1D.h"
+#include "TAxis.h"
+#include "TArrayD.h"
+
+class HistAccumulator
+{
+    public:
+        HistAccumulator(){};
+
+        // uniform binning
+        HistAccumulator(int nbins, double min, double max)
+        {
+            this->nbins = nbins;
+            this->min = min;
+            this->max = max;
+            init();
+        }
+
+        // variable binning, nbins+1 edges
+        HistAccumulator(const std::vector<double>& edges)
+        {
+            this->edges = edges;
+            nbins = edges.size()-1;
+            min = edges.front();
+            max = edges.back();
+            init();
+        }
+
+        // same binning as h
+        HistAccumulator(const TH1D* h)
+        {
+            const TAxis* axis = h->GetXaxis();
+            nbins = axis->GetNbins();
+            min = axis->GetXmin();
+            max = axis->GetXmax();
+            const TArrayD* xbins = axis->GetXbins();
+            if(xbins->fN > 0) edges.assign(xbins->fArray, xbins->fArray+xbins->fN);
+            init();
+        }
+
+        int nbins = 0;
+        double min = 0;
+        double max = 0;
+        std::vector<double> edges;        // empty for uniform binning
+
+        // bin 0 is the underflow and bin nbins+1 the overflow, as in TH1
+        std::vector<double> sumw;
+        std::vector<double> sumw2;
+
+        // TH1 statistics: entries, sum w, sum w^2, sum w*x, sum w*x^2
+        double entries = 0;
+        double tsumw = 0;
+        double tsumw2 = 0;
+        double tsumwx = 0;
+        double tsumwx2 = 0;
+
+        // under and overflows count in the statistics, the TH1::StatOverflows setting. Off by
+        // default as in TH1, turn it on here too if TH1::StatOverflows(kTRUE) is used
+        bool statOverflows = false;
+
+        // same as TAxis::FindBin for an axis that can't extend, NaN goes to the overflow
+        int findBin(double x) const
+        {
+            if(x < min) return 0;
+            if(!(x < max)) return nbins+1;
+            if(edges.empty()) return 1 + int(nbins*(x-min)/(max-min));
+            return std::upper_bound(edges.begin(), edges.end(), x) - edges.begin();
+        }
+
+        // same as TH1::Fill(x, w)
+        void fill(double x, double w)
+        {
+            int bin = findBin(x);
+            entries++;
+            sumw[bin] += w;
+            sumw2[bin] += w*w;
+            if((bin == 0 || bin > nbins) && !statOverflows) return;
+            tsumw += w;
+            tsumw2 += w*w;
+            tsumwx += w*x;
+            tsumwx2 += w*x*x;
+        }
+
+        // add the fills of another accumulator with the same binning times c
+        void add(const HistAccumulator& other, double c = 1)
+        {
+            for(int i=0; i<nbins+2; i++)
+            {
+                sumw[i] += c*other.sumw[i];
+                sumw2[i] += c*c*other.sumw2[i];
+            }
+            entries += other.entries;
+            tsumw += c*other.tsumw;
+            tsumw2 += c*c*other.tsumw2;
+            tsumwx += c*other.tsumwx;
+            tsumwx2 += c*other.tsumwx2;
+        }
+
+        bool sameBinning(const HistAccumulator& other) const
+        {
+            return nbins == other.nbins && min == other.min && max == other.max && edges == other.edges;
+        }
+
+        void reset()
+        {
+            std::fill(sumw.begin(), sumw.end(), 0);
+            std::fill(sumw2.begin(), sumw2.end(), 0);
+            entries = tsumw = tsumw2 = tsumwx = tsumwx2 = 0;
+        }
+
+        // Put the contents into h, which must have the same binning and nothing filled yet.
+        // The errors are only copied if h stores the sum of weights squared, as with TH1::Fill.
+        void fillTH1D(TH1D* h) const
+        {
+            TArrayD* hsumw2 = h->GetSumw2();
+            for(int i=0; i<nbins+2; i++)
+            {
+                h->SetBinContent(i, sumw[i]);
+                if(hsumw2->fN > 0) hsumw2->fArray[i] = sumw2[i];
+            }
+            double stats[4] = {tsumw, tsumw2, tsumwx, tsumwx2};
+            h->PutStats(stats);
+            h->SetEntries(entries);
+        }
+
+        // new histogram with the same binning and contents, detached from gDirectory
+        TH1D* makeTH1D(const char* name, const char* title) const
+        {
+            TH1D* h = edges.empty() ? new TH1D(name, title, nbins, min, max) : new TH1D(name, title, nbins, edges.data());
+            h->SetDirectory(0);
+            if(h->GetSumw2N() == 0) h->Sumw2();
+            fillTH1D(h);
+            return h;
+        }
+
+    private:
+        void init()
+        {
+            sumw.assign(nbins+2, 0);
+            sumw2.assign(nbins+2, 0);
+        }
+};
+
+#endif
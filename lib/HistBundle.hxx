@@ -0,0 +1,377 @@
+///////////////////////////////////////////////////////////////////////////
+// ======================================================================//
+// HistBundle.hxx                                                        //
+// ======================================================================//
+// Compact side file for the TH1D outputs of categorize: an index with   //
+// the directory, name, title, binning, and statistics of each histogram //
+// followed by the bin contents and the sum of weights squared of each   //
+// histogram in one contiguous block, optionally zlib compressed per     //
+// histogram. The index is read once, then any histogram is a seek and   //
+// one read, with no streamers involved. The TH1Ds made from a bundle    //
+// have the same contents, errors, entries, statistics, titles, and line //
+// and fill colors as the ones that went in. Other objects, e.g. the     //
+// stack canvases, aren't stored. bin/convertHistBundle.cxx converts     //
+// between the ROOT file and the bundle, and                             //
+// python/plotting_tools/hist_bundle.py reads bundles in python.         //
+// ======================================================================//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_HISTBUNDLE
+#define ADD_HISTBUNDLE
+
+#include <vector>
+#include <string>
+#include <map>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+
+#include <zlib.h>
+
+#include "BinaryIO.hxx"
+#include "TH1D.h"
+#include "TAxis.h"
+#include "TArrayD.h"
+#include "TList.h"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct BundleEntry
+{
+    std::string dir;                 // TDirectory in the ROOT layout, e.g. net_histos
+    std::string name;
+    std::string title;
+    std::string xtitle;
+
+    int nbins = 0;
+    double min = 0;
+    double max = 0;
+    std::vector<double> edges;       // empty for uniform binning
+
+    double entries = 0;
+    double stats[4] = {0, 0, 0, 0};  // TH1::GetStats, sum w, sum w^2, sum w*x, sum w*x^2
+    short lineColor = 1;
+    short fillColor = 0;
+    unsigned char hasSumw2 = 0;
+
+    // the bins of the histogram in the data block, nbins+2 contents then nbins+2 sums of weights squared
+    unsigned long long offset = 0;   // from the start of the data block
+    unsigned long long nbytes = 0;   // stored size, compressed or not
+    unsigned long long rawbytes = 0; // uncompressed size
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+class HistBundle
+{
+    public:
+        HistBundle(){};
+        ~HistBundle(){};
+
+        static const unsigned int kMagic = 0x444E4248;   // "HBND"
+        static const unsigned int kVersion = 1;
+        static const unsigned int kCompressed = 1;
+
+        bool compress = false;           // zlib compress the bins of each histogram when writing
+        std::vector<BundleEntry> entries;
+
+        //////////////////////////////////////////////////////////////
+        // Filling --------------------------------------------------
+        //////////////////////////////////////////////////////////////
+
+        // Add the histogram under dir. A histogram with the same dir and name replaces the
+        // earlier one, as the last cycle does for TFile::Get.
+        void add(const std::string& dir, const TH1D* h)
+        {
+            BundleEntry e;
+            e.dir = dir;
+            e.name = h->GetName();
+            e.title = h->GetTitle();
+            e.xtitle = h->GetXaxis()->GetTitle();
+
+            const TAxis* axis = h->GetXaxis();
+            e.nbins = axis->GetNbins();
+            e.min = axis->GetXmin();
+            e.max = axis->GetXmax();
+            const TArrayD* xbins = axis->GetXbins();
+            if(xbins->fN > 0) e.edges.assign(xbins->fArray, xbins->fArray+xbins->fN);
+
+            e.entries = h->GetEntries();
+            h->GetStats(e.stats);
+            e.lineColor = h->GetLineColor();
+            e.fillColor = h->GetFillColor();
+            e.hasSumw2 = h->GetSumw2N() > 0;
+
+            std::vector<double> bins((e.hasSumw2?2:1)*(e.nbins+2));
+            for(int i=0; i<e.nbins+2; i++)
+                bins[i] = h->GetBinContent(i);
+            if(e.hasSumw2)
+            {
+                const TArrayD* sumw2 = const_cast<TH1D*>(h)->GetSumw2();
+                for(int i=0; i<e.nbins+2; i++)
+                    bins[e.nbins+2+i] = sumw2->fArray[i];
+            }
+
+            // kept uncompressed until the write
+            e.rawbytes = bins.size()*sizeof(double);
+            e.nbytes = e.rawbytes;
+            std::vector<char> blob((const char*)bins.data(), (const char*)bins.data()+e.rawbytes);
+
+            std::string key = dir+"/"+e.name;
+            auto it = index.find(key);
+            if(it != index.end())
+            {
+                entries[it->second] = e;
+                blobs[it->second] = blob;
+                return;
+            }
+            index[key] = entries.size();
+            entries.push_back(e);
+            blobs.push_back(blob);
+        }
+
+        // add the TH1Ds in the list and in the lists inside it, the way TList::Write writes them
+        void addList(const std::string& dir, TList* list)
+        {
+            TIter next(list);
+            TObject* obj = 0;
+            while((obj = next()))
+            {
+                if(TList* sublist = dynamic_cast<TList*>(obj)) addList(dir, sublist);
+                else if(TH1D* h = dynamic_cast<TH1D*>(obj)) add(dir, h);
+            }
+        }
+
+        //////////////////////////////////////////////////////////////
+        // Queries --------------------------------------------------
+        //////////////////////////////////////////////////////////////
+
+        // index of dir/name, -1 if it isn't in the bundle
+        int find(const std::string& dir, const std::string& name) const
+        {
+            auto it = index.find(dir+"/"+name);
+            if(it == index.end()) return -1;
+            return it->second;
+        }
+
+        // with the categorize naming, category_sample[_systematic]
+        int find(const std::string& dir, const std::string& category, const std::string& sample, const std::string& systematic) const
+        {
+            std::string name = category+"_"+sample;
+            if(systematic != "") name += "_"+systematic;
+            return find(dir, name);
+        }
+
+        // the nbins+2 contents and, if stored, the nbins+2 sums of weights squared of entry i
+        bool getBins(int i, std::vector<double>& bins)
+        {
+            const BundleEntry& e = entries[i];
+            bins.resize(e.rawbytes/sizeof(double));
+
+            // added since the open, not compressed
+            if(!blobs[i].empty())
+            {
+                std::memcpy(bins.data(), blobs[i].data(), e.rawbytes);
+                return true;
+            }
+
+            std::vector<char> blob(e.nbytes);
+            in.clear();
+            in.seekg(dataStart+e.offset);
+            in.read(blob.data(), e.nbytes);
+            if(!in)
+            {
+                std::cout << "  !!! HistBundle: could not read " << e.dir << "/" << e.name << std::endl;
+                return false;
+            }
+
+            if(!compressed) std::memcpy(bins.data(), blob.data(), e.rawbytes);
+            else
+            {
+                uLongf n = e.rawbytes;
+                if(uncompress((Bytef*)bins.data(), &n, (const Bytef*)blob.data(), e.nbytes) != Z_OK || n != e.rawbytes)
+                {
+                    std::cout << "  !!! HistBundle: " << e.dir << "/" << e.name << " is corrupt" << std::endl;
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // new TH1D for entry i, detached from gDirectory, 0 if the bins can't be read
+        TH1D* getTH1D(int i)
+        {
+            std::vector<double> bins;
+            if(!getBins(i, bins)) return 0;
+
+            const BundleEntry& e = entries[i];
+            TH1D* h = e.edges.empty() ? new TH1D(e.name.c_str(), e.title.c_str(), e.nbins, e.min, e.max)
+                                      : new TH1D(e.name.c_str(), e.title.c_str(), e.nbins, e.edges.data());
+            h->SetDirectory(0);
+            h->GetXaxis()->SetTitle(e.xtitle.c_str());
+            h->SetLineColor(e.lineColor);
+            h->SetFillColor(e.fillColor);
+            if(e.hasSumw2 && h->GetSumw2N() == 0) h->Sumw2();
+
+            TArrayD* sumw2 = h->GetSumw2();
+            for(int b=0; b<e.nbins+2; b++)
+            {
+                h->SetBinContent(b, bins[b]);
+                if(e.hasSumw2) sumw2->fArray[b] = bins[e.nbins+2+b];
+            }
+            double stats[4] = {e.stats[0], e.stats[1], e.stats[2], e.stats[3]};
+            h->PutStats(stats);
+            h->SetEntries(e.entries);
+            return h;
+        }
+
+        TH1D* getTH1D(const std::string& dir, const std::string& name)
+        {
+            int i = find(dir, name);
+            if(i < 0) return 0;
+            return getTH1D(i);
+        }
+
+        //////////////////////////////////////////////////////////////
+        // I/O ------------------------------------------------------
+        //////////////////////////////////////////////////////////////
+
+        bool write(const std::string& filename)
+        {
+            std::ofstream out;
+            if(!BinaryIO::openTemporary(out, filename))
+            {
+                std::cout << "  !!! HistBundle: could not open " << BinaryIO::temporary(filename) << " for writing" << std::endl;
+                return false;
+            }
+
+            // lay the bins out in index order, entries that came from an opened file are copied over
+            std::vector<BundleEntry> layout = entries;
+            std::vector< std::vector<char> > data(layout.size());
+            unsigned long long offset = 0;
+            for(unsigned int i=0; i<layout.size(); i++)
+            {
+                BundleEntry& e = layout[i];
+                std::vector<double> bins;
+                if(!getBins(i, bins)) return false;
+                if(compress)
+                {
+                    uLongf n = compressBound(e.rawbytes);
+                    data[i].resize(n);
+                    int status = compress2((Bytef*)data[i].data(), &n, (const Bytef*)bins.data(), e.rawbytes, Z_BEST_SPEED);
+                    if(status != Z_OK)
+                    {
+                        std::cout << "  !!! HistBundle: could not compress " << e.dir << "/" << e.name << ", zlib error " << status << std::endl;
+                        return false;
+                    }
+                    data[i].resize(n);
+                }
+                else data[i].assign((const char*)bins.data(), (const char*)bins.data()+e.rawbytes);
+                e.nbytes = data[i].size();
+                e.offset = offset;
+                offset += e.nbytes;
+            }
+
+            unsigned int flags = compress?kCompressed:0;
+            unsigned int n = layout.size();
+            BinaryIO::writeHeader(out, kMagic, kVersion);
+            BinaryIO::writePOD(out, flags);
+            BinaryIO::writePOD(out, n);
+            for(auto& e: layout)
+            {
+                BinaryIO::writeString(out, e.dir);
+                BinaryIO::writeString(out, e.name);
+                BinaryIO::writeString(out, e.title);
+                BinaryIO::writeString(out, e.xtitle);
+                BinaryIO::writePOD(out, e.nbins);
+                BinaryIO::writePOD(out, e.min);
+                BinaryIO::writePOD(out, e.max);
+                BinaryIO::writeVector(out, e.edges);
+                BinaryIO::writePOD(out, e.entries);
+                out.write((const char*)e.stats, sizeof(e.stats));
+                BinaryIO::writePOD(out, e.lineColor);
+                BinaryIO::writePOD(out, e.fillColor);
+                BinaryIO::writePOD(out, e.hasSumw2);
+                BinaryIO::writePOD(out, e.offset);
+                BinaryIO::writePOD(out, e.nbytes);
+                BinaryIO::writePOD(out, e.rawbytes);
+            }
+            for(auto& d: data)
+                out.write(d.data(), d.size());
+            if(!BinaryIO::commitTemporary(out, filename))
+            {
+                std::cout << "  !!! HistBundle: could not write " << filename << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        // read the index, the bins are read on demand by getBins and getTH1D
+        bool open(const std::string& filename)
+        {
+            in.open(filename.c_str(), std::ios::binary);
+            if(!in)
+            {
+                std::cout << "  !!! HistBundle: could not open " << filename << std::endl;
+                return false;
+            }
+
+            unsigned int flags = 0, n = 0;
+            if(!BinaryIO::readHeader(in, kMagic, kVersion))
+            {
+                std::cout << "  !!! HistBundle: " << filename << " is not a version " << kVersion << " histogram bundle" << std::endl;
+                return false;
+            }
+            BinaryIO::readPOD(in, flags);
+            BinaryIO::readPOD(in, n);
+            compressed = flags & kCompressed;
+
+            entries.assign(n, BundleEntry());
+            blobs.assign(n, std::vector<char>());
+            index.clear();
+            for(unsigned int i=0; i<n && in; i++)
+            {
+                BundleEntry& e = entries[i];
+                BinaryIO::readString(in, e.dir);
+                BinaryIO::readString(in, e.name);
+                BinaryIO::readString(in, e.title);
+                BinaryIO::readString(in, e.xtitle);
+                BinaryIO::readPOD(in, e.nbins);
+                BinaryIO::readPOD(in, e.min);
+                BinaryIO::readPOD(in, e.max);
+                BinaryIO::readVector(in, e.edges);
+                BinaryIO::readPOD(in, e.entries);
+                in.read((char*)e.stats, sizeof(e.stats));
+                BinaryIO::readPOD(in, e.lineColor);
+                BinaryIO::readPOD(in, e.fillColor);
+                BinaryIO::readPOD(in, e.hasSumw2);
+                BinaryIO::readPOD(in, e.offset);
+                BinaryIO::readPOD(in, e.nbytes);
+                BinaryIO::readPOD(in, e.rawbytes);
+                index[e.dir+"/"+e.name] = i;
+            }
+
+            if(!in)
+            {
+                std::cout << "  !!! HistBundle: " << filename << " is truncated" << std::endl;
+                return false;
+            }
+            dataStart = in.tellg();
+            return true;
+        }
+
+    private:
+        std::map<std::string, int> index;           // dir/name -> entry
+        std::vector< std::vector<char> > blobs;     // uncompressed bins of the added histograms, empty for the ones in the file
+
+        std::ifstream in;
+        unsigned long long dataStart = 0;
+        bool compressed = false;                    // the bins in the opened file are compressed
+};
+
+#endif
@@ -0,0 +1,211 @@
+///////////////////////////////////////////////////////////////////////////
+// ======================================================================//
+// MassRecord.hxx                                                        //
+// ======================================================================//
+// Unbinned export of the categorize mass histograms. One row for each   //
+// selected event and each category it is in, stored by column: the      //
+// dimuon mass for each calibration, the event weight, and the category, //
+// sample, and systematic ids. The lumi x xsec normalization is constant //
+// for a sample, so it is kept once per sample instead of in each row.   //
+// bin/rebinMasses.cxx makes histograms with any binning, range, and     //
+// blinding from the rows. The rows only cover the events the categorize //
+// run selected, so use the widest mass window needed in that run.       //
+// ======================================================================//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_MASSRECORD
+#define ADD_MASSRECORD
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <cstdio>
+
+#include "BinaryIO.hxx"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+// rows for one sample and systematic, filled by a single thread then appended to the record
+struct MassColumns
+{
+    std::vector<float> mass_PF;
+    std::vector<float> mass_Roch;
+    std::vector<float> mass_KaMu;
+    std::vector<float> weight;
+    std::vector<unsigned short> category;
+
+    void add(int id, double mPF, double mRoch, double mKaMu, double w)
+    {
+        mass_PF.push_back(mPF);
+        mass_Roch.push_back(mRoch);
+        mass_KaMu.push_back(mKaMu);
+        weight.push_back(w);
+        category.push_back(id);
+    }
+
+    unsigned int size() const { return weight.size(); }
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+class MassRecord
+{
+    public:
+        MassRecord(){};
+        ~MassRecord(){};
+
+        static const unsigned int kMagic = 0x4345524D;   // "MREC"
+        static const unsigned int kVersion = 1;
+
+        // header
+        std::string calibration;                  // calibration the selection and categories used
+        std::vector<std::string> categories;      // category names in id order
+        std::vector<std::string> samples;
+        std::vector<std::string> sampleTypes;     // signal, background, or data
+        std::vector<double> sampleScales;         // lumi x xsec normalization of each sample, 1 for data
+        std::vector<std::string> systematics;     // "" is the nominal
+
+        // columns, one entry per row
+        std::vector<float> mass_PF;
+        std::vector<float> mass_Roch;
+        std::vector<float> mass_KaMu;
+        std::vector<float> weight;
+        std::vector<unsigned short> category;
+        std::vector<unsigned short> sample;
+        std::vector<unsigned char> systematic;
+
+        unsigned long long size() const { return weight.size(); }
+
+        // the mass column for PF, Roch, or KaMu, 0 for anything else
+        const std::vector<float>* massColumn(const std::string& calib) const
+        {
+            if(calib == "PF")   return &mass_PF;
+            if(calib == "Roch") return &mass_Roch;
+            if(calib == "KaMu") return &mass_KaMu;
+            return 0;
+        }
+
+        //////////////////////////////////////////////////////////////
+        // Filling --------------------------------------------------
+        //////////////////////////////////////////////////////////////
+
+        // Append the rows of a sample for a systematic. The category ids of every sample
+        // have to refer to the same categorization. Safe to call from several threads.
+        void append(const std::string& sampleName, const std::string& sampleType, double scale,
+                    const std::string& systematicName, const std::vector<std::string>& categoryNames,
+                    const MassColumns& cols)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if(categories.empty()) categories = categoryNames;
+
+            int s = axisIndex(samples, sampleName);
+            if(s == (int)sampleTypes.size())
+            {
+                sampleTypes.push_back(sampleType);
+                sampleScales.push_back(scale);
+            }
+            int syst = axisIndex(systematics, systematicName);
+
+            mass_PF.insert(mass_PF.end(), cols.mass_PF.begin(), cols.mass_PF.end());
+            mass_Roch.insert(mass_Roch.end(), cols.mass_Roch.begin(), cols.mass_Roch.end());
+            mass_KaMu.insert(mass_KaMu.end(), cols.mass_KaMu.begin(), cols.mass_KaMu.end());
+            weight.insert(weight.end(), cols.weight.begin(), cols.weight.end());
+            category.insert(category.end(), cols.category.begin(), cols.category.end());
+            sample.insert(sample.end(), cols.size(), (unsigned short)s);
+            systematic.insert(systematic.end(), cols.size(), (unsigned char)syst);
+        }
+
+        //////////////////////////////////////////////////////////////
+        // I/O ------------------------------------------------------
+        //////////////////////////////////////////////////////////////
+
+        bool write(const std::string& filename) const
+        {
+            std::ofstream out;
+            if(!BinaryIO::openTemporary(out, filename))
+            {
+                std::cout << "  !!! MassRecord: could not open " << BinaryIO::temporary(filename) << " for writing" << std::endl;
+                return false;
+            }
+
+            BinaryIO::writeHeader(out, kMagic, kVersion);
+            BinaryIO::writeString(out, calibration);
+            BinaryIO::writeStrings(out, categories);
+            BinaryIO::writeStrings(out, samples);
+            BinaryIO::writeStrings(out, sampleTypes);
+            BinaryIO::writeVector<unsigned long long>(out, sampleScales);
+            BinaryIO::writeStrings(out, systematics);
+
+            BinaryIO::writeVector<unsigned long long>(out, mass_PF);
+            BinaryIO::writeVector<unsigned long long>(out, mass_Roch);
+            BinaryIO::writeVector<unsigned long long>(out, mass_KaMu);
+            BinaryIO::writeVector<unsigned long long>(out, weight);
+            BinaryIO::writeVector<unsigned long long>(out, category);
+            BinaryIO::writeVector<unsigned long long>(out, sample);
+            BinaryIO::writeVector<unsigned long long>(out, systematic);
+            if(!BinaryIO::commitTemporary(out, filename))
+            {
+                std::cout << "  !!! MassRecord: could not write " << filename << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        bool read(const std::string& filename)
+        {
+            std::ifstream in(filename.c_str(), std::ios::binary);
+            if(!in)
+            {
+                std::cout << "  !!! MassRecord: could not open " << filename << std::endl;
+                return false;
+            }
+
+            if(!BinaryIO::readHeader(in, kMagic, kVersion))
+            {
+                std::cout << "  !!! MassRecord: " << filename << " is not a version " << kVersion << " mass record" << std::endl;
+                return false;
+            }
+
+            BinaryIO::readString(in, calibration);
+            BinaryIO::readStrings(in, categories);
+            BinaryIO::readStrings(in, samples);
+            BinaryIO::readStrings(in, sampleTypes);
+            BinaryIO::readVector<unsigned long long>(in, sampleScales);
+            BinaryIO::readStrings(in, systematics);
+
+            BinaryIO::readVector<unsigned long long>(in, mass_PF);
+            BinaryIO::readVector<unsigned long long>(in, mass_Roch);
+            BinaryIO::readVector<unsigned long long>(in, mass_KaMu);
+            BinaryIO::readVector<unsigned long long>(in, weight);
+            BinaryIO::readVector<unsigned long long>(in, category);
+            BinaryIO::readVector<unsigned long long>(in, sample);
+            BinaryIO::readVector<unsigned long long>(in, systematic);
+
+            if(!in)
+            {
+                std::cout << "  !!! MassRecord: " << filename << " is truncated" << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        std::mutex mutex;
+
+        static int axisIndex(std::vector<std::string>& axis, const std::string& name)
+        {
+            for(unsigned int i=0; i<axis.size(); i++)
+                if(axis[i] == name) return i;
+            axis.push_back(name);
+            return axis.size()-1;
+        }
+};
+
+#endif
@@ -0,0 +1,259 @@
+///////////////////////////////////////////////////////////////////////////
+// ======================================================================//
+// MomentMorphing.hxx                                                    //
+// ======================================================================//
+// Signal templates at any Higgs mass from the templates at a few        //
+// generated masses, e.g. the 120, 125, and 130 GeV samples, by moment   //
+// morphing: each template is shifted and scaled so its mean and width   //
+// are the ones interpolated to the new mass, then the templates are     //
+// summed with the linear interpolation coefficients of the two nearest  //
+// masses. The yield is interpolated the same way. A morphed bin is the  //
+// difference of the templates' cumulative distributions at the          //
+// transformed bin edges, so the result needs no sampling and takes      //
+// microseconds. A generated mass returns its template as is.            //
+//                                                                       //
+// The yield is the in range contents, the part of the shifted shape     //
+// that moves out of the range is put back by renormalizing the in range //
+// bins to it, and the under and overflow are interpolated as they are.  //
+// The sum of weights squared is morphed like the contents and scaled    //
+// with the yield, which is an estimate of the errors, not a propagation //
+// of them. Outside the generated masses the coefficients extrapolate    //
+// and can go negative, see extrapolates(). If the extrapolated width    //
+// isn't positive there is no template, morph() returns an empty one.    //
+// ======================================================================//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_MOMENTMORPHING
+#define ADD_MOMENTMORPHING
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "HistAccumulator.hxx"
+#include "TH1D.h"
+#include "TString.h"
+#include "TArrayD.h"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct MorphTemplate
+{
+    double mass = 0;
+    HistAccumulator acc;
+
+    double yield = 0;                // sum of the contents in range
+    double sumw2 = 0;                // sum of the weights squared in range
+    double mean = 0;
+    double sigma = 0;
+    double entries = 0;
+
+    // cumulative fractions at the bin edges, cdf[0] = 0 and cdf[nbins] = 1, negative bins count as 0
+    std::vector<double> cdf;
+    std::vector<double> cdfw2;
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+class MomentMorphing
+{
+    public:
+        MomentMorphing(){};
+        ~MomentMorphing(){};
+
+        std::vector<MorphTemplate> templates;    // sorted by mass
+
+        // the contents, errors, and statistics of a TH1D
+        static HistAccumulator fromTH1D(TH1D* h)
+        {
+            HistAccumulator acc(h);
+            TArrayD* hsumw2 = h->GetSumw2();
+            for(int b=0; b<acc.nbins+2; b++)
+            {
+                acc.sumw[b] = h->GetBinContent(b);
+                acc.sumw2[b] = (hsumw2 && hsumw2->fN > 0) ? hsumw2->fArray[b] : std::fabs(acc.sumw[b]);
+            }
+            double stats[4] = {0, 0, 0, 0};
+            h->GetStats(stats);
+            acc.tsumw = stats[0];
+            acc.tsumw2 = stats[1];
+            acc.tsumwx = stats[2];
+            acc.tsumwx2 = stats[3];
+            acc.entries = h->GetEntries();
+            return acc;
+        }
+
+        // all of the templates need the same binning
+        bool addTemplate(double mass, const HistAccumulator& acc)
+        {
+            if(!templates.empty() && !templates[0].acc.sameBinning(acc))
+            {
+                std::cout << Form("  !!! MomentMorphing: the %g GeV template has a different binning \n", mass);
+                return false;
+            }
+
+            MorphTemplate t;
+            t.mass = mass;
+            t.acc = acc;
+            t.entries = acc.entries;
+            t.cdf.assign(acc.nbins+1, 0);
+            t.cdfw2.assign(acc.nbins+1, 0);
+
+            double sumx = 0, sumx2 = 0, positive = 0;
+            for(int b=1; b<=acc.nbins; b++)
+            {
+                double y = std::max(acc.sumw[b], 0.0);
+                double x = 0.5*(edge(acc, b-1)+edge(acc, b));
+                t.yield += acc.sumw[b];
+                t.sumw2 += acc.sumw2[b];
+                positive += y;
+                sumx += y*x;
+                sumx2 += y*x*x;
+                t.cdf[b] = t.cdf[b-1]+y;
+                t.cdfw2[b] = t.cdfw2[b-1]+acc.sumw2[b];
+            }
+            if(positive <= 0)
+            {
+                std::cout << Form("  !!! MomentMorphing: the %g GeV template is empty \n", mass);
+                return false;
+            }
+            for(auto& c: t.cdf) c /= positive;
+            if(t.sumw2 > 0) for(auto& c: t.cdfw2) c /= t.sumw2;
+
+            t.mean = sumx/positive;
+            t.sigma = std::sqrt(std::max(sumx2/positive-t.mean*t.mean, 0.0));
+            if(t.sigma <= 0) t.sigma = edge(acc, 1)-edge(acc, 0);
+
+            templates.push_back(t);
+            std::sort(templates.begin(), templates.end(), [](const MorphTemplate& a, const MorphTemplate& b){ return a.mass < b.mass; });
+            return true;
+        }
+
+        // linear interpolation coefficients of the templates at mass, nonzero for the two nearest generated masses
+        std::vector<double> coefficients(double mass) const
+        {
+            std::vector<double> c(templates.size(), 0);
+            if(templates.size() == 1)
+            {
+                c[0] = 1;
+                return c;
+            }
+
+            unsigned int hi = 1;
+            while(hi < templates.size()-1 && mass > templates[hi].mass) hi++;
+            unsigned int lo = hi-1;
+            double f = (mass-templates[lo].mass)/(templates[hi].mass-templates[lo].mass);
+            c[lo] = 1-f;
+            c[hi] = f;
+            return c;
+        }
+
+        // mass is outside of the generated masses, the coefficients extrapolate
+        bool extrapolates(double mass) const
+        {
+            return !templates.empty() && (mass < templates.front().mass || mass > templates.back().mass);
+        }
+
+        // the template at mass with the binning of the inputs, empty (nbins == 0) if the width isn't positive there
+        HistAccumulator morph(double mass) const
+        {
+            if(templates.empty()) return HistAccumulator();
+            for(auto& t: templates)
+                if(t.mass == mass) return t.acc;
+
+            std::vector<double> c = coefficients(mass);
+            double yield = 0, mean = 0, sigma = 0, entries = 0;
+            for(unsigned int i=0; i<templates.size(); i++)
+            {
+                yield += c[i]*templates[i].yield;
+                mean += c[i]*templates[i].mean;
+                sigma += c[i]*templates[i].sigma;
+                entries += c[i]*templates[i].entries;
+            }
+            if(!(sigma > 0)) return HistAccumulator();
+
+            HistAccumulator out = templates[0].acc;
+            out.reset();
+
+            int n = out.nbins;
+            for(unsigned int i=0; i<templates.size(); i++)
+            {
+                if(c[i] == 0) continue;
+                const MorphTemplate& t = templates[i];
+
+                // an edge x of the morphed template is x_i = mean_i + (x - mean)*sigma_i/sigma of template i
+                double scale = t.sigma/sigma;
+                double yieldScale = (t.yield != 0) ? yield/t.yield : 0;
+                double w2scale = c[i]*t.sumw2*yieldScale*yieldScale;
+                double previous = cdfAt(t.cdf, t.acc, t.mean+(edge(out, 0)-mean)*scale);
+                double previousw2 = cdfAt(t.cdfw2, t.acc, t.mean+(edge(out, 0)-mean)*scale);
+                for(int b=1; b<=n; b++)
+                {
+                    double x = t.mean+(edge(out, b)-mean)*scale;
+                    double f = cdfAt(t.cdf, t.acc, x);
+                    double fw2 = cdfAt(t.cdfw2, t.acc, x);
+                    out.sumw[b] += c[i]*yield*(f-previous);
+                    out.sumw2[b] += w2scale*(fw2-previousw2);
+                    previous = f;
+                    previousw2 = fw2;
+                }
+
+                // the under and overflow have no shape to shift
+                out.sumw[0] += c[i]*t.acc.sumw[0];
+                out.sumw2[0] += c[i]*t.acc.sumw2[0];
+                out.sumw[n+1] += c[i]*t.acc.sumw[n+1];
+                out.sumw2[n+1] += c[i]*t.acc.sumw2[n+1];
+            }
+            out.sumw2[0] = std::max(out.sumw2[0], 0.0);
+            out.sumw2[n+1] = std::max(out.sumw2[n+1], 0.0);
+
+            // what shifted out of the range goes back into it, so the in range contents are the interpolated yield
+            double inRange = 0;
+            for(int b=1; b<=n; b++) inRange += out.sumw[b];
+            if(inRange != 0)
+            {
+                double r = yield/inRange;
+                for(int b=1; b<=n; b++)
+                {
+                    out.sumw[b] *= r;
+                    out.sumw2[b] *= r*r;
+                }
+            }
+
+            // statistics from the bin centers
+            out.entries = entries;
+            for(int b=1; b<=n; b++)
+            {
+                double x = 0.5*(edge(out, b-1)+edge(out, b));
+                out.tsumw += out.sumw[b];
+                out.tsumw2 += out.sumw2[b];
+                out.tsumwx += out.sumw[b]*x;
+                out.tsumwx2 += out.sumw[b]*x*x;
+            }
+            return out;
+        }
+
+        static double edge(const HistAccumulator& acc, int b)
+        {
+            if(!acc.edges.empty()) return acc.edges[b];
+            return acc.min+b*(acc.max-acc.min)/acc.nbins;
+        }
+
+    private:
+        // cumulative fraction at x, linear within a bin
+        static double cdfAt(const std::vector<double>& cdf, const HistAccumulator& acc, double x)
+        {
+            if(x <= acc.min) return 0;
+            if(x >= acc.max) return 1;
+            int b = acc.findBin(x);
+            double lo = edge(acc, b-1), hi = edge(acc, b);
+            return cdf[b-1]+(cdf[b]-cdf[b-1])*(x-lo)/(hi-lo);
+        }
+};
+
+#endif
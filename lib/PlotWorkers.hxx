@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////////
+// ======================================================================//
+// PlotWorkers.hxx                                                       //
+// ======================================================================//
+// Run plotting jobs in forked worker processes. ROOT graphics isn't     //
+// thread safe, so the stacks can't go to the ThreadPool, but a forked   //
+// child gets its own copy of the histograms and of gROOT and can draw   //
+// while the parent goes on with the next systematic. A job returns 0 on //
+// success. The child only sees the memory as it was at the fork, so     //
+// anything it produces has to go through a file, and anything the      //
+// parent changes afterwards doesn't affect it. Fork only while no other //
+// threads are running, e.g. between the ThreadPool stages.              //
+// ======================================================================//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_PLOTWORKERS
+#define ADD_PLOTWORKERS
+
+#include <vector>
+#include <functional>
+#include <iostream>
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+class PlotWorkers
+{
+    public:
+        // at most nworkers children at once, 0 runs the jobs in this process
+        PlotWorkers(int nworkers)
+        {
+            this->nworkers = nworkers;
+        }
+
+        ~PlotWorkers()
+        {
+            waitAll();
+        }
+
+        int nworkers = 0;
+        int nfailed = 0;
+
+        // fork a child for the job, waiting for a free worker first. Runs the job here
+        // if there are no workers or the fork fails.
+        void submit(std::function<int()> job)
+        {
+            if(nworkers <= 0)
+            {
+                if(job() != 0) nfailed++;
+                return;
+            }
+
+            while((int)children.size() >= nworkers) waitOne();
+
+            std::cout.flush();
+            pid_t pid = fork();
+            if(pid == 0)
+            {
+                int status = job();
+                std::cout.flush();
+                // skip the atexit handlers and static destructors, they belong to the parent
+                _exit(status == 0?0:1);
+            }
+            if(pid < 0)
+            {
+                std::cout << "  !!! PlotWorkers: fork failed, running the job in this process" << std::endl;
+                if(job() != 0) nfailed++;
+                return;
+            }
+            children.push_back(pid);
+        }
+
+        // wait for the running children, returns the number of failed jobs so far
+        int waitAll()
+        {
+            while(!children.empty()) waitOne();
+            return nfailed;
+        }
+
+    private:
+        std::vector<pid_t> children;
+
+        void waitOne()
+        {
+            int status = 0;
+            pid_t pid = waitpid(-1, &status, 0);
+            if(pid < 0)
+            {
+                children.clear();
+                return;
+            }
+            for(unsigned int i=0; i<children.size(); i++)
+            {
+                if(children[i] != pid) continue;
+                children.erase(children.begin()+i);
+                if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) nfailed++;
+                break;
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,196 @@
+///////////////////////////////////////////////////////////////////////////
+// ======================================================================//
+// ResultCache.hxx                                                       //
+// ======================================================================//
+// Content addressed store of the per sample fill results, so a rerun    //
+// only redoes the samples whose inputs changed, like a build system.    //
+// The key is a hash of everything the unscaled fills of a sample depend //
+// on: the identity of its input files, the selection, cleaner, and      //
+// categorizer parameters, the weights file, the settings of the run,    //
+// and the executable itself as the code version. The lumi x xsec        //
+// normalization is applied after the fills, so it isn't part of the key //
+// and a new xsec doesn't invalidate anything. An entry is only ever     //
+// written under its key, never updated, so stale entries are harmless;  //
+// delete the directory to reclaim the space.                            //
+// ======================================================================//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_RESULTCACHE
+#define ADD_RESULTCACHE
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+
+#include "BinaryIO.hxx"
+#include "TSystem.h"
+#include "HistAccumulator.hxx"
+#include "ScoreCache.hxx"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+// 64 bit FNV-1a over the parts of the key, each part is terminated so "ab"+"c" != "a"+"bc"
+class ResultKey
+{
+    public:
+        ResultKey(){};
+
+        unsigned long long hash = 14695981039346656037ULL;
+
+        void add(const std::string& s)
+        {
+            for(unsigned int i=0; i<s.size(); i++) addByte(s[i]);
+            addByte(0);
+        }
+
+        void add(double x)
+        {
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "%.17g", x);
+            add(std::string(buffer));
+        }
+
+        void add(unsigned long long x)
+        {
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "%llx", x);
+            add(std::string(buffer));
+        }
+
+        // the identity of a large input file without reading it: path, size, and modification time
+        void addFileIdentity(const std::string& name)
+        {
+            Long_t id = 0, flags = 0, modtime = 0;
+            Long64_t size = 0;
+            add(name);
+            if(gSystem->GetPathInfo(name.c_str(), &id, &size, &flags, &modtime) != 0)
+            {
+                add(std::string("missing"));
+                return;
+            }
+            add((unsigned long long)size);
+            add((unsigned long long)modtime);
+        }
+
+        // the contents of a small file, e.g. the weights file or the categorization XML
+        void addFileContents(const std::string& name)
+        {
+            add(name);
+            add(ScoreCache::hashFile(name));
+        }
+
+        std::string hex() const
+        {
+            char buffer[17];
+            snprintf(buffer, sizeof(buffer), "%016llx", hash);
+            return buffer;
+        }
+
+    private:
+        void addByte(unsigned char c)
+        {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+class ResultCache
+{
+    public:
+        static const unsigned int kMagic = 0x48435352;   // "RSCH"
+        static const unsigned int kVersion = 1;
+
+        // dir/sample_key.result, the sample name is only there to make the directory readable
+        static std::string filename(const std::string& dir, const std::string& sample, const ResultKey& key)
+        {
+            std::string d = dir;
+            if(d.size() > 0 && d[d.size()-1] != '/') d += "/";
+            return d+sample+"_"+key.hex()+".result";
+        }
+
+        // Fill accs from the entry for the key. accs must already have the binning of the
+        // run, an entry with a different layout is a miss. Empty accumulators are skipped.
+        static bool load(const std::string& dir, const std::string& sample, const ResultKey& key, std::vector<HistAccumulator>& accs)
+        {
+            std::ifstream in(filename(dir, sample, key).c_str(), std::ios::binary);
+            if(!in) return false;
+
+            unsigned int n = 0;
+            unsigned long long hash = 0;
+            bool header = BinaryIO::readHeader(in, kMagic, kVersion);
+            BinaryIO::readPOD(in, hash);
+            BinaryIO::readPOD(in, n);
+            if(!header || hash != key.hash || n != accs.size()) return false;
+
+            std::vector<HistAccumulator> loaded(accs.size());
+            for(unsigned int i=0; i<n && in; i++)
+            {
+                int nbins = 0;
+                BinaryIO::readPOD(in, nbins);
+                if(nbins != accs[i].nbins) return false;
+                if(nbins == 0) continue;
+
+                HistAccumulator& acc = loaded[i];
+                acc = accs[i];
+                acc.sumw.resize(nbins+2);
+                acc.sumw2.resize(nbins+2);
+                in.read((char*)acc.sumw.data(), (nbins+2)*sizeof(double));
+                in.read((char*)acc.sumw2.data(), (nbins+2)*sizeof(double));
+                BinaryIO::readPOD(in, acc.entries);
+                BinaryIO::readPOD(in, acc.tsumw);
+                BinaryIO::readPOD(in, acc.tsumw2);
+                BinaryIO::readPOD(in, acc.tsumwx);
+                BinaryIO::readPOD(in, acc.tsumwx2);
+            }
+            if(!in) return false;
+
+            for(unsigned int i=0; i<n; i++)
+                if(accs[i].nbins > 0) accs[i] = loaded[i];
+            return true;
+        }
+
+        static bool save(const std::string& dir, const std::string& sample, const ResultKey& key, const std::vector<HistAccumulator>& accs)
+        {
+            gSystem->mkdir(dir.c_str(), true);
+            std::string name = filename(dir, sample, key);
+            std::ofstream out;
+            if(!BinaryIO::openTemporary(out, name))
+            {
+                std::cout << "  !!! ResultCache: could not open " << BinaryIO::temporary(name) << " for writing" << std::endl;
+                return false;
+            }
+
+            unsigned int n = accs.size();
+            BinaryIO::writeHeader(out, kMagic, kVersion);
+            BinaryIO::writePOD(out, key.hash);
+            BinaryIO::writePOD(out, n);
+            for(auto& acc: accs)
+            {
+                BinaryIO::writePOD(out, acc.nbins);
+                if(acc.nbins == 0) continue;
+                out.write((const char*)acc.sumw.data(), (acc.nbins+2)*sizeof(double));
+                out.write((const char*)acc.sumw2.data(), (acc.nbins+2)*sizeof(double));
+                BinaryIO::writePOD(out, acc.entries);
+                BinaryIO::writePOD(out, acc.tsumw);
+                BinaryIO::writePOD(out, acc.tsumw2);
+                BinaryIO::writePOD(out, acc.tsumwx);
+                BinaryIO::writePOD(out, acc.tsumwx2);
+            }
+            if(!BinaryIO::commitTemporary(out, name))
+            {
+                std::cout << "  !!! ResultCache: could not write " << name << std::endl;
+                return false;
+            }
+            return true;
+        }
+};
+
+#endif
@@ -0,0 +1,372 @@
+///////////////////////////////////////////////////////////////////////////
+// ======================================================================//
+// ResultCube.hxx                                                        //
+// ======================================================================//
+// Sparse store of the categorize output along every axis at once:       //
+// category x sample x systematic x calibration x variable, with the     //
+// bins of each variable. Each (category, sample, systematic,            //
+// calibration, variable) is a slice that keeps only its non-empty bins  //
+// and the TH1 statistics. The contents carry the same normalization as  //
+// the categorize histograms. Runs for other systematics or calibrations //
+// go into the same file, a slice that is filled again replaces the old  //
+// one. bin/queryCube.cxx projects any selection of slices back into     //
+// histograms. The cube also keeps the luminosity, the sample xsecs, and //
+// sig_xlumi of the last run, so queryCube can unscale the signal histos //
+// the way categorize does for the limit setting.                        //
+// ======================================================================//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_RESULTCUBE
+#define ADD_RESULTCUBE
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <mutex>
+#include <cstdio>
+
+#include "BinaryIO.hxx"
+#include "HistAccumulator.hxx"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct CubeVariable
+{
+    std::string name;
+    int nbins = 0;
+    double min = 0;
+    double max = 0;
+    std::vector<double> edges;     // empty for uniform binning
+
+    HistAccumulator makeAccumulator() const
+    {
+        if(edges.empty()) return HistAccumulator(nbins, min, max);
+        return HistAccumulator(edges);
+    }
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct CubeSlice
+{
+    int category = 0;
+    int sample = 0;
+    int systematic = 0;
+    int calibration = 0;
+    int variable = 0;
+
+    // TH1 statistics, see HistAccumulator
+    double entries = 0, tsumw = 0, tsumw2 = 0, tsumwx = 0, tsumwx2 = 0;
+
+    // the non-empty bins, 0 is the underflow and nbins+1 the overflow
+    std::vector<int> bins;
+    std::vector<double> sumw;
+    std::vector<double> sumw2;
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+class ResultCube
+{
+    public:
+        ResultCube(){};
+        ~ResultCube(){};
+
+        static const unsigned int kMagic = 0x42554352;   // "RCUB"
+        static const unsigned int kVersion = 2;
+
+        // axes, the slices refer to them by index
+        std::vector<std::string> categories;     // category names as used in the histogram names
+        std::vector<std::string> samples;
+        std::vector<std::string> sampleTypes;    // signal, background, or data for each sample
+        std::vector<std::string> systematics;    // "" is the nominal
+        std::vector<std::string> calibrations;   // PF, Roch, KaMu
+        std::vector<CubeVariable> variables;
+
+        std::vector<CubeSlice> slices;
+
+        // settings of the last categorize run, the slices keep the xsec*lumi scaling either way
+        double luminosity = 0;                   // pb-1
+        bool sigXlumi = true;                    // false if the signal histos are unscaled by lumi*xsec
+        std::vector<double> xsecs;               // xsec of each sample, 0 if it wasn't set
+
+        // lumi*xsec to divide the signal histos of the sample by, 1 if they keep the scaling
+        double signalUnscale(int sample) const
+        {
+            if(sigXlumi || sampleTypes[sample] != "signal") return 1;
+            if(sample >= (int)xsecs.size() || xsecs[sample] <= 0 || luminosity <= 0) return 1;
+            return luminosity*xsecs[sample];
+        }
+
+        //////////////////////////////////////////////////////////////
+        // Filling --------------------------------------------------
+        //////////////////////////////////////////////////////////////
+
+        // Set the slice to the contents of acc scaled by c, replacing the slice if there is one.
+        // The variable is added with the binning of acc the first time. Safe to call from several threads.
+        bool setSlice(const std::string& category, const std::string& sample, const std::string& sampleType,
+                      const std::string& systematic, const std::string& calibration, const std::string& variable,
+                      const HistAccumulator& acc, double c = 1)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            CubeSlice slice;
+            slice.category = axisIndex(categories, category);
+            slice.systematic = axisIndex(systematics, systematic);
+            slice.calibration = axisIndex(calibrations, calibration);
+            slice.sample = axisIndex(samples, sample);
+            if(slice.sample == (int)sampleTypes.size()) sampleTypes.push_back(sampleType);
+
+            slice.variable = -1;
+            for(unsigned int v=0; v<variables.size(); v++)
+                if(variables[v].name == variable) slice.variable = v;
+            if(slice.variable < 0)
+            {
+                CubeVariable var;
+                var.name = variable;
+                var.nbins = acc.nbins;
+                var.min = acc.min;
+                var.max = acc.max;
+                var.edges = acc.edges;
+                slice.variable = variables.size();
+                variables.push_back(var);
+            }
+            else if(!variables[slice.variable].makeAccumulator().sameBinning(acc))
+            {
+                std::cout << "  !!! ResultCube: " << variable << " has a different binning than in the cube, not stored" << std::endl;
+                return false;
+            }
+
+            // same scaling as TH1::Scale for the contents and errors
+            slice.entries = acc.entries;
+            slice.tsumw = c*acc.tsumw;
+            slice.tsumw2 = c*c*acc.tsumw2;
+            slice.tsumwx = c*acc.tsumwx;
+            slice.tsumwx2 = c*acc.tsumwx2;
+            for(int i=0; i<acc.nbins+2; i++)
+            {
+                if(acc.sumw[i] == 0 && acc.sumw2[i] == 0) continue;
+                slice.bins.push_back(i);
+                slice.sumw.push_back(c*acc.sumw[i]);
+                slice.sumw2.push_back(c*c*acc.sumw2[i]);
+            }
+
+            unsigned long long k = key(slice);
+            auto it = index.find(k);
+            if(it != index.end()) slices[it->second] = slice;
+            else
+            {
+                index[k] = slices.size();
+                slices.push_back(slice);
+            }
+            return true;
+        }
+
+        //////////////////////////////////////////////////////////////
+        // Queries --------------------------------------------------
+        //////////////////////////////////////////////////////////////
+
+        // index of name on the axis, -1 if it isn't there
+        static int find(const std::vector<std::string>& axis, const std::string& name)
+        {
+            for(unsigned int i=0; i<axis.size(); i++)
+                if(axis[i] == name) return i;
+            return -1;
+        }
+
+        int findVariable(const std::string& name) const
+        {
+            for(unsigned int v=0; v<variables.size(); v++)
+                if(variables[v].name == name) return v;
+            return -1;
+        }
+
+        // the slice for the axis indices, 0 if it wasn't filled
+        const CubeSlice* getSlice(int category, int sample, int systematic, int calibration, int variable) const
+        {
+            CubeSlice slice;
+            slice.category = category;
+            slice.sample = sample;
+            slice.systematic = systematic;
+            slice.calibration = calibration;
+            slice.variable = variable;
+            auto it = index.find(key(slice));
+            if(it == index.end()) return 0;
+            return &slices[it->second];
+        }
+
+        // add the slice to acc, which has the binning of the slice's variable
+        static void addSlice(const CubeSlice& slice, HistAccumulator& acc)
+        {
+            for(unsigned int b=0; b<slice.bins.size(); b++)
+            {
+                acc.sumw[slice.bins[b]] += slice.sumw[b];
+                acc.sumw2[slice.bins[b]] += slice.sumw2[b];
+            }
+            acc.entries += slice.entries;
+            acc.tsumw += slice.tsumw;
+            acc.tsumw2 += slice.tsumw2;
+            acc.tsumwx += slice.tsumwx;
+            acc.tsumwx2 += slice.tsumwx2;
+        }
+
+        //////////////////////////////////////////////////////////////
+        // I/O ------------------------------------------------------
+        //////////////////////////////////////////////////////////////
+
+        bool write(const std::string& filename) const
+        {
+            std::ofstream out;
+            if(!BinaryIO::openTemporary(out, filename))
+            {
+                std::cout << "  !!! ResultCube: could not open " << BinaryIO::temporary(filename) << " for writing" << std::endl;
+                return false;
+            }
+
+            BinaryIO::writeHeader(out, kMagic, kVersion);
+            BinaryIO::writeStrings(out, categories);
+            BinaryIO::writeStrings(out, samples);
+            BinaryIO::writeStrings(out, sampleTypes);
+            BinaryIO::writeStrings(out, systematics);
+            BinaryIO::writeStrings(out, calibrations);
+
+            std::vector<double> x = xsecs;
+            x.resize(samples.size(), 0);
+            BinaryIO::writePOD(out, luminosity);
+            BinaryIO::writePOD(out, sigXlumi);
+            BinaryIO::writeVector(out, x);
+
+            unsigned int nvars = variables.size();
+            BinaryIO::writePOD(out, nvars);
+            for(auto& v: variables)
+            {
+                BinaryIO::writeString(out, v.name);
+                BinaryIO::writePOD(out, v.nbins);
+                BinaryIO::writePOD(out, v.min);
+                BinaryIO::writePOD(out, v.max);
+                BinaryIO::writeVector(out, v.edges);
+            }
+
+            unsigned long long nslices = slices.size();
+            BinaryIO::writePOD(out, nslices);
+            for(auto& s: slices)
+            {
+                BinaryIO::writePOD(out, s.category);
+                BinaryIO::writePOD(out, s.sample);
+                BinaryIO::writePOD(out, s.systematic);
+                BinaryIO::writePOD(out, s.calibration);
+                BinaryIO::writePOD(out, s.variable);
+                BinaryIO::writePOD(out, s.entries);
+                BinaryIO::writePOD(out, s.tsumw);
+                BinaryIO::writePOD(out, s.tsumw2);
+                BinaryIO::writePOD(out, s.tsumwx);
+                BinaryIO::writePOD(out, s.tsumwx2);
+                BinaryIO::writeVector(out, s.bins);
+                BinaryIO::writeVector(out, s.sumw);
+                BinaryIO::writeVector(out, s.sumw2);
+            }
+            if(!BinaryIO::commitTemporary(out, filename))
+            {
+                std::cout << "  !!! ResultCube: could not write " << filename << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        bool read(const std::string& filename)
+        {
+            std::ifstream in(filename.c_str(), std::ios::binary);
+            if(!in)
+            {
+                std::cout << "  !!! ResultCube: could not open " << filename << std::endl;
+                return false;
+            }
+
+            if(!BinaryIO::readHeader(in, kMagic, kVersion))
+            {
+                std::cout << "  !!! ResultCube: " << filename << " is not a version " << kVersion << " result cube" << std::endl;
+                return false;
+            }
+
+            BinaryIO::readStrings(in, categories);
+            BinaryIO::readStrings(in, samples);
+            BinaryIO::readStrings(in, sampleTypes);
+            BinaryIO::readStrings(in, systematics);
+            BinaryIO::readStrings(in, calibrations);
+
+            BinaryIO::readPOD(in, luminosity);
+            BinaryIO::readPOD(in, sigXlumi);
+            BinaryIO::readVector(in, xsecs);
+
+            unsigned int nvars = 0;
+            BinaryIO::readPOD(in, nvars);
+            variables.assign(nvars, CubeVariable());
+            for(auto& v: variables)
+            {
+                BinaryIO::readString(in, v.name);
+                BinaryIO::readPOD(in, v.nbins);
+                BinaryIO::readPOD(in, v.min);
+                BinaryIO::readPOD(in, v.max);
+                BinaryIO::readVector(in, v.edges);
+            }
+
+            unsigned long long nslices = 0;
+            BinaryIO::readPOD(in, nslices);
+            slices.assign(nslices, CubeSlice());
+            index.clear();
+            for(unsigned long long i=0; i<nslices && in; i++)
+            {
+                CubeSlice& s = slices[i];
+                BinaryIO::readPOD(in, s.category);
+                BinaryIO::readPOD(in, s.sample);
+                BinaryIO::readPOD(in, s.systematic);
+                BinaryIO::readPOD(in, s.calibration);
+                BinaryIO::readPOD(in, s.variable);
+                BinaryIO::readPOD(in, s.entries);
+                BinaryIO::readPOD(in, s.tsumw);
+                BinaryIO::readPOD(in, s.tsumw2);
+                BinaryIO::readPOD(in, s.tsumwx);
+                BinaryIO::readPOD(in, s.tsumwx2);
+                BinaryIO::readVector(in, s.bins);
+                BinaryIO::readVector(in, s.sumw);
+                BinaryIO::readVector(in, s.sumw2);
+                index[key(s)] = i;
+            }
+
+            if(!in)
+            {
+                std::cout << "  !!! ResultCube: " << filename << " is truncated" << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        std::unordered_map<unsigned long long, unsigned int> index;   // slice key -> position in slices
+        std::mutex mutex;
+
+        static unsigned long long key(const CubeSlice& s)
+        {
+            return ((unsigned long long)(s.category & 0xFFFF) << 48) | ((unsigned long long)(s.sample & 0xFFFF) << 32) |
+                   ((unsigned long long)(s.systematic & 0xFFF) << 20) | ((unsigned long long)(s.calibration & 0xFF) << 12) |
+                   (unsigned long long)(s.variable & 0xFFF);
+        }
+
+        static int axisIndex(std::vector<std::string>& axis, const std::string& name)
+        {
+            int i = find(axis, name);
+            if(i >= 0) return i;
+            axis.push_back(name);
+            return axis.size()-1;
+        }
+};
+
+#endif
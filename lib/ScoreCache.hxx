@@ -0,0 +1,236 @@
+///////////////////////////////////////////////////////////////////////////
+// ======================================================================//
+// ScoreCache.hxx                                                        //
+// ======================================================================//
+// Side file with the classifier score for each (entry, dimuon           //
+// candidate, calibration, systematic) of a sample. One file per sample  //
+// and weights file, the file name carries a hash of the weights file    //
+// contents so a retrained classifier never reads old scores. Scores     //
+// that are not in the file are computed as usual and added to it when   //
+// the sample is done, so repeated runs only read the scores back.       //
+//                                                                       //
+// The scores also depend on the collection cleaning and the jet         //
+// pairing that feed the inputs. Delete the cache directory if those     //
+// change.                                                               //
+// ======================================================================//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_SCORECACHE
+#define ADD_SCORECACHE
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <map>
+#include <mutex>
+#include <cstdio>
+
+#include "BinaryIO.hxx"
+#include "TSystem.h"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct ScoreRecord
+{
+    long long entry = 0;
+    float score = 0;
+    unsigned short tag = 0;          // index into ScoreCache::tags, calibration and systematic
+    unsigned short candidate = 0;    // index of the dimuon candidate in muPairs
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+class ScoreCache
+{
+    public:
+        ScoreCache(){};
+        ~ScoreCache(){};
+
+        static const unsigned int kMagic = 0x53434348;   // "SCCH"
+        static const unsigned int kVersion = 1;
+
+        std::string filename;
+        unsigned long long weightsHash = 0;
+        int tag = -1;                     // tag of the calibration and systematic this cache serves
+        long long nhits = 0;
+        long long nmisses = 0;
+
+        // 64 bit FNV-1a of the file contents, 0 if the file can't be read
+        static unsigned long long hashFile(const std::string& name)
+        {
+            std::ifstream in(name.c_str(), std::ios::binary);
+            if(!in) return 0;
+
+            unsigned long long h = 14695981039346656037ULL;
+            char buffer[65536];
+            while(in)
+            {
+                in.read(buffer, sizeof(buffer));
+                std::streamsize n = in.gcount();
+                for(std::streamsize i=0; i<n; i++)
+                {
+                    h ^= (unsigned char) buffer[i];
+                    h *= 1099511628211ULL;
+                }
+            }
+            return h;
+        }
+
+        // hashFile of a weights file, read the first time it is asked for and
+        // remembered for the rest of the process, like TMVATools::getClassifier
+        static unsigned long long hashWeights(const std::string& weightfile)
+        {
+            static std::mutex lock;
+            static std::map<std::string, unsigned long long> hashes;
+
+            std::lock_guard<std::mutex> guard(lock);
+            auto it = hashes.find(weightfile);
+            if(it != hashes.end()) return it->second;
+
+            unsigned long long h = hashFile(weightfile);
+            if(h == 0) std::cout << "  !!! ScoreCache: could not read " << weightfile << std::endl;
+            hashes[weightfile] = h;
+            return h;
+        }
+
+        // Load the scores for the sample and the weights file with hash hashWeights(weightfile) from dir
+        // if there are any, lookups and insertions then go to the calibration x systematic given here
+        bool open(const std::string& dir, const std::string& sample, unsigned long long weightfileHash,
+                  const std::string& calibration, const std::string& systematic)
+        {
+            weightsHash = weightfileHash;
+            if(weightsHash == 0) return false;
+
+            char hash[17];
+            snprintf(hash, sizeof(hash), "%016llx", weightsHash);
+            std::string d = dir;
+            if(d.size() > 0 && d[d.size()-1] != '/') d += "/";
+            gSystem->mkdir(d.c_str(), true);
+            filename = d+sample+"_"+hash+".scores";
+
+            tags.clear();
+            scores.clear();
+            dirty = false;
+            read();
+
+            std::string t = calibration+"_"+systematic;
+            tag = -1;
+            for(unsigned int i=0; i<tags.size(); i++)
+                if(tags[i] == t) tag = i;
+            if(tag < 0)
+            {
+                tag = tags.size();
+                tags.push_back(t);
+            }
+            return true;
+        }
+
+        bool get(long long entry, int candidate, float& score)
+        {
+            auto it = scores.find(key(entry, tag, candidate));
+            if(it == scores.end())
+            {
+                nmisses++;
+                return false;
+            }
+            nhits++;
+            score = it->second;
+            return true;
+        }
+
+        void put(long long entry, int candidate, float score)
+        {
+            scores[key(entry, tag, candidate)] = score;
+            dirty = true;
+        }
+
+        // write the file back if anything was added, through a temporary file so that
+        // a run that dies halfway leaves the old file in place
+        bool save()
+        {
+            if(!dirty || filename == "") return true;
+
+            std::ofstream out;
+            if(!BinaryIO::openTemporary(out, filename))
+            {
+                std::cout << "  !!! ScoreCache: could not open " << BinaryIO::temporary(filename) << " for writing" << std::endl;
+                return false;
+            }
+
+            unsigned long long nrecords = scores.size();
+            BinaryIO::writeHeader(out, kMagic, kVersion);
+            BinaryIO::writePOD(out, weightsHash);
+            BinaryIO::writeStrings(out, tags);
+            BinaryIO::writePOD(out, nrecords);
+
+            std::vector<ScoreRecord> records;
+            records.reserve(nrecords);
+            for(auto& s: scores)
+            {
+                ScoreRecord r;
+                r.entry = s.first >> 24;
+                r.tag = (s.first >> 8) & 0xFFFF;
+                r.candidate = s.first & 0xFF;
+                r.score = s.second;
+                records.push_back(r);
+            }
+            if(nrecords > 0) out.write((const char*)records.data(), nrecords*sizeof(ScoreRecord));
+            if(!BinaryIO::commitTemporary(out, filename))
+            {
+                std::cout << "  !!! ScoreCache: could not write " << filename << std::endl;
+                return false;
+            }
+            dirty = false;
+            return true;
+        }
+
+    private:
+        std::vector<std::string> tags;
+        std::unordered_map<unsigned long long, float> scores;   // all tags, so saving keeps the other calibrations and systematics
+        bool dirty = false;
+
+        static unsigned long long key(long long entry, int tag, int candidate)
+        {
+            return ((unsigned long long) entry << 24) | ((unsigned long long)(tag & 0xFFFF) << 8) | (candidate & 0xFF);
+        }
+
+        bool read()
+        {
+            std::ifstream in(filename.c_str(), std::ios::binary);
+            if(!in) return false;
+
+            unsigned long long hash = 0, nrecords = 0;
+            bool header = BinaryIO::readHeader(in, kMagic, kVersion);
+            BinaryIO::readPOD(in, hash);
+            if(!header || hash != weightsHash)
+            {
+                std::cout << "  !!! ScoreCache: ignoring " << filename << ", wrong version or weights file" << std::endl;
+                return false;
+            }
+
+            BinaryIO::readStrings(in, tags);
+
+            BinaryIO::readPOD(in, nrecords);
+            std::vector<ScoreRecord> records(nrecords);
+            if(nrecords > 0) in.read((char*)records.data(), nrecords*sizeof(ScoreRecord));
+            if(!in)
+            {
+                std::cout << "  !!! ScoreCache: " << filename << " is truncated, starting over" << std::endl;
+                tags.clear();
+                return false;
+            }
+
+            scores.reserve(nrecords);
+            for(auto& r: records)
+                scores[key(r.entry, r.tag, r.candidate)] = r.score;
+            return true;
+        }
+};
+
+#endif
@@ -0,0 +1,234 @@
+///////////////////////////////////////////////////////////////////////////
+// ======================================================================//
+// SelectionRecord.hxx                                                   //
+// ======================================================================//
+// Compact per event side file with the raw quantities needed by the     //
+// Run2EventSelectionCuts and Run2MuonSelectionCuts for every dimuon     //
+// candidate, the pass bitmask for the thresholds used when the file     //
+// was written, and the index of the selected candidate. The selection   //
+// can then be redone for new thresholds or cut on/off combinations      //
+// without reading the ROOT files, see bin/reselect.cxx.                 //
+//                                                                       //
+// Bits follow the CutFlow layout in cutflow.cxx,                        //
+//   0: charge, 1: hlt matched muon pt, 2: dimu mass                     //
+//   3-5: mu1 pt, |eta|, iso, 6-8: mu2 pt, |eta|, iso                    //
+// ======================================================================//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_SELECTIONRECORD
+#define ADD_SELECTIONRECORD
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+
+#include "BinaryIO.hxx"
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct SelectionThresholds
+{
+    // Run2EventSelectionCuts
+    float trigMuPtMin = 26;     // >
+    float dimuMassMin = 60;     // >
+
+    // Run2MuonSelectionCuts
+    float minPt = 10;           // >
+    float maxEta = 2.4;         // <
+    float maxRelIso = 0.25;     // <=
+
+    unsigned int on = 0x1FF;    // bits of the cuts that are turned on
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct SelectionCandidate
+{
+    float mass = 0;
+    float pt1 = 0, pt2 = 0;
+    float absEta1 = 0, absEta2 = 0;
+    float iso1 = 0, iso2 = 0;
+    signed char charge1 = 0, charge2 = 0;
+    unsigned char flags = 0;    // see the enum below
+    unsigned char pad = 0;
+    unsigned int mask = 0;      // pass bits for the thresholds in the file header
+
+    enum { kMedium1 = 1, kMedium2 = 2, kHlt1 = 4, kHlt2 = 8 };
+
+    bool mediumID() const { return (flags & kMedium1) && (flags & kMedium2); }
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+struct SelectionEvent
+{
+    long long entry = 0;        // entry in the sample's TChain
+    float weight = 1;           // Sample::getWeight() for the event
+    int selected = -1;          // candidate chosen with the header thresholds, -1 if none
+    unsigned int first = 0;     // index of the first candidate in SelectionRecord::candidates
+    unsigned int ncand = 0;
+};
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+class SelectionRecord
+{
+    public:
+        SelectionRecord(){};
+        ~SelectionRecord(){};
+
+        static const unsigned int kMagic = 0x52534C53;   // "SLSR"
+        static const unsigned int kVersion = 1;
+        static const unsigned int kNBits = 9;
+
+        // header
+        std::string name;
+        std::string sampleType;
+        std::string calibration;
+        double xsec = 0;
+        double nOriginalWeighted = 0;
+        SelectionThresholds thresholds;
+
+        // body, the candidates for all events are kept in one flat vector
+        std::vector<SelectionEvent> events;
+        std::vector<SelectionCandidate> candidates;
+
+        //////////////////////////////////////////////////////////////
+        // Selection ------------------------------------------------
+        //////////////////////////////////////////////////////////////
+
+        // same logic as Run2EventSelectionCuts::evaluateCuts and Run2MuonSelectionCuts::evaluateCuts
+        static unsigned int evaluate(const SelectionCandidate& c, const SelectionThresholds& t)
+        {
+            bool hlt1 = c.flags & SelectionCandidate::kHlt1;
+            bool hlt2 = c.flags & SelectionCandidate::kHlt2;
+
+            unsigned int mask = 0;
+            if(c.charge1 != c.charge2) mask |= 1 << 0;
+            if((hlt1 && c.pt1 > t.trigMuPtMin) || (hlt2 && c.pt2 > t.trigMuPtMin)) mask |= 1 << 1;
+            if(c.mass > t.dimuMassMin) mask |= 1 << 2;
+
+            if(c.pt1 > t.minPt)          mask |= 1 << 3;
+            if(c.absEta1 < t.maxEta)     mask |= 1 << 4;
+            if(c.iso1 <= t.maxRelIso)    mask |= 1 << 5;
+            if(c.pt2 > t.minPt)          mask |= 1 << 6;
+            if(c.absEta2 < t.maxEta)     mask |= 1 << 7;
+            if(c.iso2 <= t.maxRelIso)    mask |= 1 << 8;
+            return mask;
+        }
+
+        // first candidate with medium id muons passing all of the cuts that are on, -1 if none
+        int select(const SelectionEvent& e, const SelectionThresholds& t) const
+        {
+            for(unsigned int d=0; d<e.ncand; d++)
+            {
+                const SelectionCandidate& c = candidates[e.first+d];
+                if(!c.mediumID()) continue;
+                if((evaluate(c, t) & t.on) == t.on) return d;
+            }
+            return -1;
+        }
+
+        void addEvent(long long entry, float weight, int selected, const std::vector<SelectionCandidate>& cands)
+        {
+            SelectionEvent e;
+            e.entry = entry;
+            e.weight = weight;
+            e.selected = selected;
+            e.first = candidates.size();
+            e.ncand = cands.size();
+            events.push_back(e);
+            candidates.insert(candidates.end(), cands.begin(), cands.end());
+        }
+
+        //////////////////////////////////////////////////////////////
+        // I/O ------------------------------------------------------
+        //////////////////////////////////////////////////////////////
+
+        bool write(const std::string& filename) const
+        {
+            std::ofstream out;
+            if(!BinaryIO::openTemporary(out, filename))
+            {
+                std::cout << "  !!! SelectionRecord: could not open " << BinaryIO::temporary(filename) << " for writing" << std::endl;
+                return false;
+            }
+
+            BinaryIO::writeHeader(out, kMagic, kVersion);
+            BinaryIO::writeString(out, name);
+            BinaryIO::writeString(out, sampleType);
+            BinaryIO::writeString(out, calibration);
+            BinaryIO::writePOD(out, xsec);
+            BinaryIO::writePOD(out, nOriginalWeighted);
+            BinaryIO::writePOD(out, thresholds);
+
+            unsigned long long nevents = events.size();
+            unsigned long long ncands = candidates.size();
+            BinaryIO::writePOD(out, nevents);
+            BinaryIO::writePOD(out, ncands);
+            if(nevents > 0) out.write((const char*)events.data(), nevents*sizeof(SelectionEvent));
+            if(ncands > 0)  out.write((const char*)candidates.data(), ncands*sizeof(SelectionCandidate));
+            if(!BinaryIO::commitTemporary(out, filename))
+            {
+                std::cout << "  !!! SelectionRecord: could not write " << filename << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        bool read(const std::string& filename)
+        {
+            std::ifstream in(filename.c_str(), std::ios::binary);
+            if(!in)
+            {
+                std::cout << "  !!! SelectionRecord: could not open " << filename << std::endl;
+                return false;
+            }
+
+            if(!BinaryIO::readHeader(in, kMagic, kVersion))
+            {
+                std::cout << "  !!! SelectionRecord: " << filename << " is not a version " << kVersion << " selection record" << std::endl;
+                return false;
+            }
+
+            BinaryIO::readString(in, name);
+            BinaryIO::readString(in, sampleType);
+            BinaryIO::readString(in, calibration);
+            BinaryIO::readPOD(in, xsec);
+            BinaryIO::readPOD(in, nOriginalWeighted);
+            BinaryIO::readPOD(in, thresholds);
+
+            unsigned long long nevents = 0, ncands = 0;
+            BinaryIO::readPOD(in, nevents);
+            BinaryIO::readPOD(in, ncands);
+            events.resize(nevents);
+            candidates.resize(ncands);
+            if(nevents > 0) in.read((char*)events.data(), nevents*sizeof(SelectionEvent));
+            if(ncands > 0)  in.read((char*)candidates.data(), ncands*sizeof(SelectionCandidate));
+
+            if(!in)
+            {
+                std::cout << "  !!! SelectionRecord: " << filename << " is truncated" << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        // same as Sample::getLumiScaleFactor
+        double getLumiScaleFactor(double luminosity) const
+        {
+            if(sampleType == "data") return 1.0;
+            return luminosity*xsec/nOriginalWeighted;
+        }
+};
+
+#endif
@@ -26,12 +26,14 @@
 #include "GenMuonInfo.h"
 #include "GenMuPairInfo.h"
 #include "TLorentzVector.h"
+#include "DijetPairing.hxx"
 
 #include <iostream>
 #include <string>
 #include <sstream>
 #include <unordered_map>
 #include <map>
+#include <cctype>
 
 const int N_JETS      = 4;
 const int N_JET_PAIRS = 4;
@@ -120,6 +122,10 @@ class VarSet
         std::vector<TLorentzVector> validJets;
         std::vector<TLorentzVector> validBJets;
 
+        // index of each valid jet in the raw jets collection, filled by the FusedCollectionCleaner
+        // and empty if the cleaning didn't keep track of it
+        std::vector<int> validJetsIdx;
+
         //////////////////////////////////////////////////////////////////////////////
         // Map String to Feature value (double) -------------------------------------
         //////////////////////////////////////////////////////////////////////////////
@@ -153,6 +159,47 @@ class VarSet
         // see if the var string is in the map
         bool checkForVar(const std::string& name){return (varMap[name] || varMapI[name]); }
 
+        // A feature resolved once from its name so that hot loops can skip the string lookup.
+        // The member function pointers are the same for every VarSet, so a handle from one
+        // VarSet can be used with any other.
+        struct VarHandle
+        {
+            double (VarSet::*f)() = 0;
+            double (VarSet::*fi)(int) = 0;
+            int index = -1;
+            bool valid() const { return f != 0 || fi != 0; }
+        };
+
+        VarHandle getHandle(const std::string& name)
+        {
+            VarHandle h;
+            auto it = varMap.find(name);
+            if(it != varMap.end() && it->second != 0)
+            {
+                h.f = it->second;
+                return h;
+            }
+            auto iti = varMapI.find(name);
+            if(iti != varMapI.end() && iti->second != 0)
+            {
+                // same index convention as getValue, the digit before the first "_", e.g. jet1_pt -> 0
+                h.fi = iti->second;
+                std::string prefix = name.substr(0, name.find("_"));
+                int iObj = 0;
+                if(prefix.size() > 0 && isdigit(prefix[prefix.size()-1])) iObj = prefix[prefix.size()-1] - '0';
+                h.index = iObj - 1;
+            }
+            return h;
+        }
+
+        // same as getValue(name) for the name the handle was made from
+        double getValue(const VarHandle& h)
+        {
+            if(h.f != 0)  return (this->*h.f)();
+            if(h.fi != 0) return (this->*h.fi)(h.index);
+            return -999;
+        }
+
         //////////////////////////////////////////////////////////////////////////////
         // Set systematic to vary ---------------------------------------------------
         //////////////////////////////////////////////////////////////////////////////
@@ -232,33 +279,23 @@ class VarSet
         int vbf_j0 = -999;
         int vbf_j1 = -999;
  
+        // pair masses and dEtas for the jet pairing below
+        DijetPairing dijetPairing;
+
+        void loadDijetPairing()
+        {
+            dijetPairing.load(validJets);
+            dijetPairing.loadPairs(jetPairs, validJetsIdx, (jets != 0)?jets->size():0);
+        }
+
         // get jets that represent vbf jets
+        // the first pair passing the vbf tight criteria, otherwise the max mjj pair
         void setVBFjets()
         {
             vbf_j0 = 0;
             vbf_j1 = 1;
-            double mjj_max = -999;
-
-            for(unsigned int i=0; i<validJets.size(); i++) 
-            {
-                if(!(validJets[i].Pt() > cLeadPtMin)) break;
-                for(unsigned int j=i+1; j<validJets.size(); j++) 
-                {
-                    double dEtajj = TMath::Abs(validJets[i].Eta() - validJets[j].Eta());
-                    double mjj = (validJets[i] + validJets[j]).M();
-                    if(mjj > mjj_max)
-                    {
-                        vbf_j0 = i;
-                        vbf_j1 = j;
-                    }
-                    if(mjj > cDijetMassMinVBFT && dEtajj > cDijetDeltaEtaMinVBFT)
-                    {
-                        vbf_j0 = i;
-                        vbf_j1 = j;
-                        return; 
-                    }
-                }
-            }
+            loadDijetPairing();
+            dijetPairing.findVBFPair(cLeadPtMin, cDijetMassMinVBFT, cDijetDeltaEtaMinVBFT, vbf_j0, vbf_j1);
         }
 
         //////////////////////////////////////////////////////////////////////////////
@@ -272,23 +309,10 @@ class VarSet
         void setJets()
         {
         // standard jets will be the two corresponding to the max mjj value 
-            double mjj_max = -999;
             j0 = 0;
             j1 = 1;
-
-            for(unsigned int i=0; i<validJets.size(); i++) 
-            {
-                for(unsigned int j=i+1; j<validJets.size(); j++) 
-                {
-                    double dEtajj = TMath::Abs(validJets[i].Eta() - validJets[j].Eta());
-                    double mjj = (validJets[i] + validJets[j]).M();
-                    if(mjj > mjj_max)
-                    {
-                        j0 = i;
-                        j1 = j;
-                    }
-                }
-            }
+            loadDijetPairing();
+            dijetPairing.findMaxMassPair(j0, j1);
         }
 
         //////////////////////////////////////////////////////////////////////////////
@@ -19,7 +19,10 @@ import math as math
 import numpy as np
 from ROOT import *
 
+import os
 import sys
+sys.path.append(os.path.join(os.path.dirname(os.path.abspath(__file__)), '../plotting_tools'))
+from hist_bundle import openHistos
 sys.argv.append( '-b-' )
 
 #============================================
@@ -44,7 +47,7 @@ class BGSpectrumFitter:
     def __init__(self, infilename, category):
         self.infilename = infilename
         self.category = category
-        self.tfile = TFile(infilename)
+        self.tfile = openHistos(infilename)     # .root or .hbnd from categorize
         self.setHists()
     
     def setHists(self):
@@ -20,6 +20,11 @@ import re
 import argparse
 from ROOT import *
 
+import os
+import sys
+sys.path.append(os.path.join(os.path.dirname(os.path.abspath(__file__)), '../plotting_tools'))
+from hist_bundle import openHistos
+
 #============================================
 # code
 #============================================
@@ -39,7 +44,7 @@ class WorkspaceAndDatacardMaker:
     def __init__(self, infilename, category):
         self.infilename = infilename
         self.category = category
-        self.tfile = TFile(infilename)
+        self.tfile = openHistos(infilename)     # .root or .hbnd from categorize
         self.setNetBackgroundHist()
         self.setNetSignalHist()
         self.setNetMCHist()
@@ -0,0 +1,125 @@
+##############################################
+# columnar_frame.py                          #
+##############################################
+# read the .cfr columnar frames that         #
+# outputToDataframe writes for the training, #
+# see lib/ColumnarFrame.hxx                  #
+##############################################
+
+#============================================
+# import
+#============================================
+
+import mmap
+import struct
+import zlib
+import numpy as np
+
+#============================================
+# code
+#============================================
+
+MAGIC = 0x4D524643    # "CFRM"
+VERSION = 1
+RAW = 0
+ZLIB = 1
+
+DTYPES = {0: np.float32, 1: np.float64, 2: np.int32, 3: np.int64, 4: np.int32}
+CATEGORY = 4
+
+class ColumnarFrame:
+# Memory maps a frame and reads the footer. column('name') is a numpy array over
+# all of the row groups; the uncompressed chunks are views of the map, not copies,
+# so keep the frame open while they are in use.
+
+    def __init__(self, filename):
+        self.filename = filename
+        self.infile = open(filename, 'rb')
+        self.data = mmap.mmap(self.infile.fileno(), 0, access=mmap.ACCESS_READ)
+
+        magic, version = struct.unpack_from('<II', self.data, 0)
+        footer, end_magic = struct.unpack_from('<QI', self.data, len(self.data)-12)
+        if magic != MAGIC or version != VERSION or end_magic != MAGIC:
+            raise IOError('%s is not a version %d columnar frame' % (filename, VERSION))
+
+        self.pos = footer
+        self.columns = []
+        self.types = {}
+        self.dictionaries = {}
+        for i in range(self.read('I')[0]):
+            name = self.readString()
+            ctype = self.read('B')[0]
+            self.columns.append(name)
+            self.types[name] = ctype
+            self.dictionaries[name] = [self.readString() for d in range(self.read('I')[0])]
+
+        self.metadata = {}
+        for i in range(self.read('I')[0]):
+            key = self.readString()
+            self.metadata[key] = self.readString()
+
+        # each row group is (nrows, [(offset, nbytes, rawbytes, codec) per column])
+        self.groups = []
+        for i in range(self.read('I')[0]):
+            nrows = self.read('Q')[0]
+            chunks = [self.read('QQQB') for c in self.columns]
+            # a raw chunk is used in place, so it has to hold all of the rows
+            for name, (offset, nbytes, rawbytes, codec) in zip(self.columns, chunks):
+                width = np.dtype(DTYPES[self.types[name]]).itemsize
+                if rawbytes != nrows*width or codec not in (RAW, ZLIB) or (codec == RAW and nbytes != rawbytes) or offset+nbytes > footer:
+                    raise IOError('%s has a corrupt chunk in column %s' % (filename, name))
+            self.groups.append((nrows, chunks))
+
+    def read(self, fmt):
+        fmt = '<'+fmt
+        values = struct.unpack_from(fmt, self.data, self.pos)
+        self.pos += struct.calcsize(fmt)
+        return values
+
+    def readString(self):
+        n = self.read('I')[0]
+        s = self.data[self.pos:self.pos+n].decode('utf-8')
+        self.pos += n
+        return s
+
+    def keys(self):
+        return list(self.columns)
+
+    def __len__(self):
+        return sum(g[0] for g in self.groups)
+
+    def column(self, name):
+    # numpy array of the column, codes for the category columns, see labels()
+        c = self.columns.index(name)
+        dtype = DTYPES[self.types[name]]
+        parts = []
+        for nrows, chunks in self.groups:
+            offset, nbytes, rawbytes, codec = chunks[c]
+            if codec == ZLIB:
+                parts.append(np.frombuffer(zlib.decompress(self.data[offset:offset+nbytes]), dtype=dtype))
+            else:
+                parts.append(np.frombuffer(self.data, dtype=dtype, count=nrows, offset=offset))
+        if len(parts) == 1: return parts[0]
+        if len(parts) == 0: return np.zeros(0, dtype=dtype)
+        return np.concatenate(parts)
+
+    def labels(self, name):
+    # the strings of a category column, e.g. the sample name of each row
+        return np.array(self.dictionaries[name])[self.column(name)]
+
+    def arrays(self, names=None):
+    # dict of name -> numpy array, for all of the columns by default
+        if names is None: names = self.columns
+        return dict((name, self.column(name)) for name in names)
+
+    def Close(self):
+        self.data.close()
+        self.infile.close()
+
+def readFrames(filenames, names=None):
+    """ Concatenate the columns of several frames, e.g. all of the samples of one training. """
+    frames = [ColumnarFrame(f) for f in filenames]
+    if names is None: names = frames[0].keys()
+    out = dict((name, np.concatenate([f.column(name) for f in frames])) for name in names)
+    for f in frames: f.Close()
+    return out
@@ -0,0 +1,119 @@
+##############################################
+# hist_bundle.py                             #
+##############################################
+# read the .hbnd histogram bundles that      #
+# categorize --bundle and convertHistBundle  #
+# write, see lib/HistBundle.hxx              #
+##############################################
+
+#============================================
+# import
+#============================================
+
+import struct
+import zlib
+from array import array
+
+#============================================
+# code
+#============================================
+
+MAGIC = 0x444E4248    # "HBND"
+VERSION = 1
+COMPRESSED = 1
+
+class HistBundle:
+# Index of a bundle, the bins of a histogram are only read when it is asked for.
+# Get('net_histos/name') returns a TH1D like TFile.Get, so the fitters can take either file.
+
+    def __init__(self, filename):
+        self.filename = filename
+        self.entries = []
+        self.index = {}
+        self.infile = open(filename, 'rb')
+
+        magic, version, flags, n = self.read('IIII')
+        if magic != MAGIC or version != VERSION:
+            raise IOError('%s is not a version %d histogram bundle' % (filename, VERSION))
+        self.compressed = bool(flags & COMPRESSED)
+
+        for i in range(n):
+            e = {}
+            e['dir'] = self.readString()
+            e['name'] = self.readString()
+            e['title'] = self.readString()
+            e['xtitle'] = self.readString()
+            e['nbins'], e['min'], e['max'] = self.read('idd')
+            nedges = self.read('I')[0]
+            e['edges'] = list(self.read('%dd' % nedges))
+            e['entries'] = self.read('d')[0]
+            e['stats'] = list(self.read('4d'))
+            e['line_color'], e['fill_color'], e['has_sumw2'] = self.read('hhB')
+            e['offset'], e['nbytes'], e['rawbytes'] = self.read('QQQ')
+            self.entries.append(e)
+            self.index[e['dir']+'/'+e['name']] = i
+
+        self.data_start = self.infile.tell()
+
+    def read(self, fmt):
+        fmt = '<'+fmt
+        return struct.unpack(fmt, self.infile.read(struct.calcsize(fmt)))
+
+    def readString(self):
+        n = self.read('I')[0]
+        return self.infile.read(n).decode('utf-8')
+
+    def keys(self):
+        return [e['dir']+'/'+e['name'] for e in self.entries]
+
+    def find(self, path):
+    # index of 'dir/name', -1 if it isn't there
+        if '/' not in path: path = '/'+path
+        return self.index.get(path, -1)
+
+    def bins(self, i):
+    # the nbins+2 contents and the nbins+2 sums of weights squared, empty if they weren't stored
+        e = self.entries[i]
+        self.infile.seek(self.data_start + e['offset'])
+        blob = self.infile.read(e['nbytes'])
+        if self.compressed: blob = zlib.decompress(blob)
+        values = struct.unpack('<%dd' % (e['rawbytes']//8), blob)
+        n = e['nbins']+2
+        return list(values[:n]), list(values[n:])
+
+    def Get(self, path):
+    # a TH1D for 'dir/name' detached from any file, None if it isn't there
+        i = self.find(path)
+        if i < 0: return None
+
+        import ROOT
+        e = self.entries[i]
+        sumw, sumw2 = self.bins(i)
+        if len(e['edges']) > 0: h = ROOT.TH1D(e['name'], e['title'], e['nbins'], array('d', e['edges']))
+        else: h = ROOT.TH1D(e['name'], e['title'], e['nbins'], e['min'], e['max'])
+        h.SetDirectory(0)
+        h.GetXaxis().SetTitle(e['xtitle'])
+        h.SetLineColor(e['line_color'])
+        h.SetFillColor(e['fill_color'])
+        if e['has_sumw2'] and h.GetSumw2N() == 0: h.Sumw2()
+
+        for b in range(e['nbins']+2):
+            h.SetBinContent(b, sumw[b])
+            if e['has_sumw2']: h.GetSumw2().SetAt(sumw2[b], b)
+        h.PutStats(array('d', e['stats']))
+        h.SetEntries(e['entries'])
+        return h
+
+    def cd(self):
+    # the histograms aren't attached to the bundle, go back to memory like a closed TFile would
+        import ROOT
+        ROOT.gROOT.cd()
+
+    def Close(self):
+        self.infile.close()
+
+def openHistos(filename):
+    """ TFile for .root files, HistBundle for .hbnd files. Both have Get('dir/name'). """
+    if filename.endswith('.hbnd'): return HistBundle(filename)
+    import ROOT
+    return ROOT.TFile(filename)
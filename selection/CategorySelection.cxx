@@ -18,6 +18,7 @@
 #include "ParticleTools.h"
 #include "EventTools.h"
 #include <sstream>
+#include <dlfcn.h>
 
 
 void CategoryNode::theMiracleOfChildBirth()
@@ -42,7 +43,91 @@ void XMLCategorizer::initCategoryMap()
 
 void XMLCategorizer::evaluate(VarSet& vars)
 {
-    evaluateRecursive(vars, rootNode); 
+    evaluateFlat(vars);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+ULong64_t XMLCategorizer::evaluateFlat(VarSet& vars)
+{
+// same path as evaluateRecursive but without the recursion, the category map lookups,
+// or the string lookups for the split variables
+    if(flatNodes.size() == 0) return 0;
+
+    if(!flatResolved)
+    {
+        for(unsigned int i=0; i<flatNodes.size(); i++)
+            if(flatNodes[i].left >= 0) flatNodes[i].splitVar = vars.getHandle(flatSplitVarNames[i].Data());
+        flatResolved = true;
+    }
+
+    ULong64_t path = 0;
+    int depth = 0;
+    const FlatCategoryNode* nodes = flatNodes.data();
+    int n = 0;
+    while(true)
+    {
+        const FlatCategoryNode& node = nodes[n];
+
+        // if it was filtered into this node then it's in this category
+        setInCategory(node.category);
+
+        // done if terminal node
+        if(node.left < 0 || node.right < 0) break;
+
+        // if not terminal node, filter to correct daughter node
+        if(vars.getValue(node.splitVar) <= node.splitVal)
+        {
+            n = node.left;
+        }
+        else
+        {
+            if(depth < 64) path |= (1ULL << depth);
+            n = node.right;
+        }
+        depth++;
+    }
+    return path;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+void XMLCategorizer::compile()
+{
+// flatten the CategoryNode tree, the nodes are stored depth first with the root at 0
+    flatNodes.clear();
+    flatSplitVarNames.clear();
+    flatResolved = false;
+    indexCategories();
+    if(rootNode == 0 || categoryMap.find(rootNode->key) == categoryMap.end()) return;
+    compileRecursive(rootNode);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+int XMLCategorizer::compileRecursive(CategoryNode* cnode)
+{
+    int n = flatNodes.size();
+    flatNodes.push_back(FlatCategoryNode());
+    flatSplitVarNames.push_back(cnode->splitVarName);
+
+    flatNodes[n].category = categoryMap[cnode->key].id;
+    flatNodes[n].splitVal = cnode->splitVal;
+
+    if(cnode->left == 0 || cnode->right == 0) return n;
+
+    // don't hold a reference across the recursion, the vector may reallocate
+    int left = compileRecursive(cnode->left);
+    int right = compileRecursive(cnode->right);
+    flatNodes[n].left = left;
+    flatNodes[n].right = right;
+    return n;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -51,8 +136,11 @@ void XMLCategorizer::evaluate(VarSet& vars)
 
 void XMLCategorizer::evaluateRecursive(VarSet& vars, CategoryNode* cnode)
 {
+// the original interpreter of the tree, evaluate uses evaluateFlat,
+// this is kept as the reference to check the flat and generated versions against
+
     // if it was filtered into this node then it's in this category
-    categoryMap[cnode->key].inCategory = true;
+    setInCategory(categoryMap[cnode->key].id);
 
     // return if terminal node
     if(cnode->left == 0 || cnode->right == 0)
@@ -137,7 +225,8 @@ void XMLCategorizer::loadFromXML(TString filename)
             c.second.hide = true;
         }
     }
-      
+
+    compile();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -266,6 +355,12 @@ void CategorySelectionBDT::initCategoryMap()
     categoryMap["c12"] = Category("c12", false, true);
     categoryMap["c13"] = Category("c13", false, true);
     categoryMap["c14"] = Category("c14", false, true);
+
+    // dense ids for evaluate
+    indexCategories();
+    idAll = categoryId("cAll");
+    for(int i=0; i<15; i++)
+        idC[i] = categoryId(Form("c%d", i));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -285,56 +380,64 @@ void CategorySelectionBDT::evaluate(VarSet& vars)
 {
 // Determine which category the event belongs to
 
-    double bdt_score = vars.getValue("bdt_score");
-    double max_eta = vars.getValue("dimu_max_abs_eta");
+    // resolve the variables once, on the first event
+    if(!resolved)
+    {
+        hBdtScore = vars.getHandle("bdt_score");
+        hMaxAbsEta = vars.getHandle("dimu_max_abs_eta");
+        resolved = true;
+    }
+
+    double bdt_score = vars.getValue(hBdtScore);
+    double max_eta = vars.getValue(hMaxAbsEta);
 
     // Inclusive set of events
-    categoryMap["cAll"].inCategory = true;
+    setInCategory(idAll);
 
     if( bdt_score < -0.400 ) 
-        categoryMap["c0"].inCategory = true;
+        setInCategory(idC[0]);
 
     else if( bdt_score >= -0.400 && bdt_score < 0.050 && max_eta >= 1.900 )
-        categoryMap["c1"].inCategory = true;
+        setInCategory(idC[1]);
 
     else if( bdt_score >= -0.400 && bdt_score < 0.050 && max_eta < 1.900  && max_eta >=0.9) 
-        categoryMap["c2"].inCategory = true;
+        setInCategory(idC[2]);
 
     else if( bdt_score >= -0.400 && bdt_score < 0.050 && max_eta < 0.9 ) 
-        categoryMap["c3"].inCategory = true;
+        setInCategory(idC[3]);
 
     else if( bdt_score >= 0.050 && bdt_score < 0.250 && max_eta >= 1.9) 
-        categoryMap["c4"].inCategory = true;
+        setInCategory(idC[4]);
 
     else if( bdt_score >= 0.050 && bdt_score < 0.250 && max_eta >= 0.900 && max_eta < 1.9) 
-        categoryMap["c5"].inCategory = true;
+        setInCategory(idC[5]);
 
     else if( bdt_score >= 0.050 && bdt_score < 0.250 && max_eta < 0.900 ) 
-        categoryMap["c6"].inCategory = true;
+        setInCategory(idC[6]);
 
     else if( bdt_score >= 0.250 && bdt_score < 0.400 && max_eta >= 1.900 )
-        categoryMap["c7"].inCategory = true;
+        setInCategory(idC[7]);
 
     else if( bdt_score >= 0.250 && bdt_score < 0.400 && max_eta < 1.900 && max_eta >= 0.900 ) 
-        categoryMap["c8"].inCategory = true;
+        setInCategory(idC[8]);
 
     else if( bdt_score >= 0.250 && bdt_score < 0.400 && max_eta < 0.900 ) 
-        categoryMap["c9"].inCategory = true;
+        setInCategory(idC[9]);
 
     else if( bdt_score < 0.650 && bdt_score >= 0.400 && max_eta >= 1.900 ) 
-        categoryMap["c10"].inCategory = true;
+        setInCategory(idC[10]);
 
     else if( bdt_score < 0.650 && bdt_score >= 0.400 && max_eta < 1.900 && max_eta >= 0.900 ) 
-        categoryMap["c11"].inCategory = true;
+        setInCategory(idC[11]);
 
     else if( bdt_score < 0.650 && bdt_score >= 0.400 && max_eta < 0.900 ) 
-        categoryMap["c12"].inCategory = true;
+        setInCategory(idC[12]);
 
     else if( bdt_score < 0.730 && bdt_score >= 0.650 ) 
-        categoryMap["c13"].inCategory = true;
+        setInCategory(idC[13]);
 
     else if( bdt_score >= 0.730 )
-        categoryMap["c14"].inCategory = true;
+        setInCategory(idC[14]);
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -383,6 +486,35 @@ void CategorySelectionRun1::initCategoryMap()
     categoryMap["c_01_Jet_Loose_OO"] = Category("c_01_Jet_Loose_OO", false, true);
     categoryMap["c_01_Jet_Loose_OE"] = Category("c_01_Jet_Loose_OE", false, true);
     categoryMap["c_01_Jet_Loose_EE"] = Category("c_01_Jet_Loose_EE", false, true);
+
+    // dense ids for evaluate
+    indexCategories();
+    id_ALL             = categoryId("c_ALL");
+    id_2_Jet           = categoryId("c_2_Jet");
+    id_01_Jet          = categoryId("c_01_Jet");
+    id_2_Jet_VBF_Tight = categoryId("c_2_Jet_VBF_Tight");
+    id_2_Jet_VBF_Loose = categoryId("c_2_Jet_VBF_Loose");
+    id_2_Jet_GGF_Tight = categoryId("c_2_Jet_GGF_Tight");
+    id_01_Jet_Tight    = categoryId("c_01_Jet_Tight");
+    id_01_Jet_Loose    = categoryId("c_01_Jet_Loose");
+    id_BB              = categoryId("c_BB");
+    id_BO              = categoryId("c_BO");
+    id_BE              = categoryId("c_BE");
+    id_OO              = categoryId("c_OO");
+    id_OE              = categoryId("c_OE");
+    id_EE              = categoryId("c_EE");
+    id_01_Jet_Tight_BB = categoryId("c_01_Jet_Tight_BB");
+    id_01_Jet_Tight_BO = categoryId("c_01_Jet_Tight_BO");
+    id_01_Jet_Tight_BE = categoryId("c_01_Jet_Tight_BE");
+    id_01_Jet_Tight_OO = categoryId("c_01_Jet_Tight_OO");
+    id_01_Jet_Tight_OE = categoryId("c_01_Jet_Tight_OE");
+    id_01_Jet_Tight_EE = categoryId("c_01_Jet_Tight_EE");
+    id_01_Jet_Loose_BB = categoryId("c_01_Jet_Loose_BB");
+    id_01_Jet_Loose_BO = categoryId("c_01_Jet_Loose_BO");
+    id_01_Jet_Loose_BE = categoryId("c_01_Jet_Loose_BE");
+    id_01_Jet_Loose_OO = categoryId("c_01_Jet_Loose_OO");
+    id_01_Jet_Loose_OE = categoryId("c_01_Jet_Loose_OE");
+    id_01_Jet_Loose_EE = categoryId("c_01_Jet_Loose_EE");
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -459,56 +591,56 @@ void CategorySelectionRun1::evaluate(VarSet& vars)
 // Determine which category the event belongs to
 
     // Inclusive category, all events that passed the selection cuts
-    categoryMap["c_ALL"].inCategory = true;
+    setInCategory(id_ALL);
 
     // Geometric Categories
     // Barrel Barrel
     if(TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) < 0.8 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) < 0.8) 
-        categoryMap["c_BB"].inCategory = true;
+        setInCategory(id_BB);
 
     // Overlap Overlap
     if(TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta)>=0.8 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta)<1.6 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta)>=0.8 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta)<1.6) 
-        categoryMap["c_OO"].inCategory = true;
+        setInCategory(id_OO);
 
     // Endcap Endcap
     if(TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) >= 1.6 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) >= 1.6) 
-        categoryMap["c_EE"].inCategory = true;
+        setInCategory(id_EE);
 
     // Barrel Overlap
     if(TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) < 0.8 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) >= 0.8 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) < 1.6) 
-        categoryMap["c_BO"].inCategory = true;
+        setInCategory(id_BO);
 
     if(TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) < 0.8 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) >= 0.8 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) < 1.6) 
-        categoryMap["c_BO"].inCategory = true;
+        setInCategory(id_BO);
 
     // Barrel Endcap
     if(TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) < 0.8 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) >= 1.6) 
-        categoryMap["c_BE"].inCategory = true;
+        setInCategory(id_BE);
 
     if(TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) < 0.8 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) >= 1.6) 
-        categoryMap["c_BE"].inCategory = true;
+        setInCategory(id_BE);
 
     // Overlap Endcap
     if(TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) >= 0.8 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) < 1.6 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) >= 1.6) 
-        categoryMap["c_OE"].inCategory = true;
+        setInCategory(id_OE);
 
     if(TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) >= 0.8 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) < 1.6 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) >= 1.6) 
-        categoryMap["c_OE"].inCategory = true;
+        setInCategory(id_OE);
 
     // jet category selection
     if(vars.validJets.size() >= 2)
@@ -516,7 +648,7 @@ void CategorySelectionRun1::evaluate(VarSet& vars)
         //if(vars.validJets[0].Pt() > cLeadPtMin && vars.validJets[1].Pt() > cSubleadPtMin) // No MET for now
         if(vars.validJets[0].Pt() > cLeadPtMin && vars.validJets[1].Pt() > cSubleadPtMin && vars.met->pt < cMETMax)
         {
-            categoryMap["c_2_Jet"].inCategory = true;
+            setInCategory(id_2_Jet);
             double mjj_max = -1;
 
             for(unsigned int i=0; i<vars.validJets.size(); i++)
@@ -529,7 +661,7 @@ void CategorySelectionRun1::evaluate(VarSet& vars)
                     if(mjj > mjj_max) mjj_max = mjj;
                     if(mjj > cDijetMassMinVBFT && TMath::Abs(dEtajj) > cDijetDeltaEtaMinVBFT)
                     { 
-                        categoryMap["c_2_Jet_VBF_Tight"].inCategory = true; 
+                        setInCategory(id_2_Jet_VBF_Tight); 
                         return; 
                     }
                 }
@@ -537,38 +669,38 @@ void CategorySelectionRun1::evaluate(VarSet& vars)
 
             if(mjj_max > cDijetMassMinGGFT && vars.dimuCand->pt > cDimuPtMinGGFT)
             { 
-                categoryMap["c_2_Jet_GGF_Tight"].inCategory = true; 
+                setInCategory(id_2_Jet_GGF_Tight); 
                 return; 
             }
             else
             { 
-                categoryMap["c_2_Jet_VBF_Loose"].inCategory = true; 
+                setInCategory(id_2_Jet_VBF_Loose); 
                 return; 
             }
         }
     }
-    if(!categoryMap["c_2_Jet"].inCategory) // fails 2jet preselection enters 01 categories
+    if(!isInCategory(id_2_Jet)) // fails 2jet preselection enters 01 categories
     {
-        categoryMap["c_01_Jet"].inCategory = true;
-        if(vars.dimuCand->pt > cDimuPtMin01T){ categoryMap["c_01_Jet_Tight"].inCategory = true;}
-        else{ categoryMap["c_01_Jet_Loose"].inCategory = true; }
+        setInCategory(id_01_Jet);
+        if(vars.dimuCand->pt > cDimuPtMin01T){ setInCategory(id_01_Jet_Tight);}
+        else{ setInCategory(id_01_Jet_Loose); }
 
         // Geometric categories for 01_Jet categories
         // tight
-        if(categoryMap["c_01_Jet_Tight"].inCategory && categoryMap["c_BB"].inCategory) categoryMap["c_01_Jet_Tight_BB"].inCategory = true;
-        if(categoryMap["c_01_Jet_Tight"].inCategory && categoryMap["c_BO"].inCategory) categoryMap["c_01_Jet_Tight_BO"].inCategory = true;
-        if(categoryMap["c_01_Jet_Tight"].inCategory && categoryMap["c_BE"].inCategory) categoryMap["c_01_Jet_Tight_BE"].inCategory = true;
-        if(categoryMap["c_01_Jet_Tight"].inCategory && categoryMap["c_OO"].inCategory) categoryMap["c_01_Jet_Tight_OO"].inCategory = true;
-        if(categoryMap["c_01_Jet_Tight"].inCategory && categoryMap["c_OE"].inCategory) categoryMap["c_01_Jet_Tight_OE"].inCategory = true;
-        if(categoryMap["c_01_Jet_Tight"].inCategory && categoryMap["c_EE"].inCategory) categoryMap["c_01_Jet_Tight_EE"].inCategory = true;
+        if(isInCategory(id_01_Jet_Tight) && isInCategory(id_BB)) setInCategory(id_01_Jet_Tight_BB);
+        if(isInCategory(id_01_Jet_Tight) && isInCategory(id_BO)) setInCategory(id_01_Jet_Tight_BO);
+        if(isInCategory(id_01_Jet_Tight) && isInCategory(id_BE)) setInCategory(id_01_Jet_Tight_BE);
+        if(isInCategory(id_01_Jet_Tight) && isInCategory(id_OO)) setInCategory(id_01_Jet_Tight_OO);
+        if(isInCategory(id_01_Jet_Tight) && isInCategory(id_OE)) setInCategory(id_01_Jet_Tight_OE);
+        if(isInCategory(id_01_Jet_Tight) && isInCategory(id_EE)) setInCategory(id_01_Jet_Tight_EE);
 
         // loose
-        if(categoryMap["c_01_Jet_Loose"].inCategory && categoryMap["c_BB"].inCategory) categoryMap["c_01_Jet_Loose_BB"].inCategory = true;
-        if(categoryMap["c_01_Jet_Loose"].inCategory && categoryMap["c_BO"].inCategory) categoryMap["c_01_Jet_Loose_BO"].inCategory = true;
-        if(categoryMap["c_01_Jet_Loose"].inCategory && categoryMap["c_BE"].inCategory) categoryMap["c_01_Jet_Loose_BE"].inCategory = true;
-        if(categoryMap["c_01_Jet_Loose"].inCategory && categoryMap["c_OO"].inCategory) categoryMap["c_01_Jet_Loose_OO"].inCategory = true;
-        if(categoryMap["c_01_Jet_Loose"].inCategory && categoryMap["c_OE"].inCategory) categoryMap["c_01_Jet_Loose_OE"].inCategory = true;
-        if(categoryMap["c_01_Jet_Loose"].inCategory && categoryMap["c_EE"].inCategory) categoryMap["c_01_Jet_Loose_EE"].inCategory = true;
+        if(isInCategory(id_01_Jet_Loose) && isInCategory(id_BB)) setInCategory(id_01_Jet_Loose_BB);
+        if(isInCategory(id_01_Jet_Loose) && isInCategory(id_BO)) setInCategory(id_01_Jet_Loose_BO);
+        if(isInCategory(id_01_Jet_Loose) && isInCategory(id_BE)) setInCategory(id_01_Jet_Loose_BE);
+        if(isInCategory(id_01_Jet_Loose) && isInCategory(id_OO)) setInCategory(id_01_Jet_Loose_OO);
+        if(isInCategory(id_01_Jet_Loose) && isInCategory(id_OE)) setInCategory(id_01_Jet_Loose_OE);
+        if(isInCategory(id_01_Jet_Loose) && isInCategory(id_EE)) setInCategory(id_01_Jet_Loose_EE);
     }
 
 }
@@ -593,6 +725,17 @@ void CategorySelectionSynch::initCategoryMap()
     categoryMap["c_2_Jet_GGF_Tight"] = Category("c_2_Jet_GGF_Tight");
     categoryMap["c_01_Jet_Tight"] = Category("c_01_Jet_Tight");
     categoryMap["c_01_Jet_Loose"] = Category("c_01_Jet_Loose");
+
+    // dense ids for evaluate
+    indexCategories();
+    id_ALL             = categoryId("c_ALL");
+    id_2_Jet           = categoryId("c_2_Jet");
+    id_01_Jet          = categoryId("c_01_Jet");
+    id_2_Jet_VBF_Tight = categoryId("c_2_Jet_VBF_Tight");
+    id_2_Jet_VBF_Loose = categoryId("c_2_Jet_VBF_Loose");
+    id_2_Jet_GGF_Tight = categoryId("c_2_Jet_GGF_Tight");
+    id_01_Jet_Tight    = categoryId("c_01_Jet_Tight");
+    id_01_Jet_Loose    = categoryId("c_01_Jet_Loose");
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -669,7 +812,7 @@ void CategorySelectionSynch::evaluate(VarSet& vars)
 // Determine which category the event belongs to
 
     // Inclusive category, all events that passed the selection cuts
-    categoryMap["c_ALL"].inCategory = true;
+    setInCategory(id_ALL);
 
     // jet category selection
     if(vars.validJets.size() >= 2)
@@ -677,7 +820,7 @@ void CategorySelectionSynch::evaluate(VarSet& vars)
         //if(leadJet.Pt() > cLeadPtMin && subleadJet.Pt() > cSubleadPtMin && vars.met->pt < cMETMax && vars.validBJets.size() == 0)
         if(vars.validJets[0].Pt() > cLeadPtMin && vars.validJets[1].Pt() > cSubleadPtMin && vars.validBJets.size() == 0) // No MET for now
         {
-            categoryMap["c_2_Jet"].inCategory = true;
+            setInCategory(id_2_Jet);
             double mjj_max = -1;
 
             for(unsigned int i=0; i<vars.validJets.size(); i++)
@@ -690,7 +833,7 @@ void CategorySelectionSynch::evaluate(VarSet& vars)
                     if(mjj > mjj_max) mjj_max = mjj;
                     if(mjj > cDijetMassMinVBFT && TMath::Abs(dEtajj) > cDijetDeltaEtaMinVBFT)
                     { 
-                        categoryMap["c_2_Jet_VBF_Tight"].inCategory = true; 
+                        setInCategory(id_2_Jet_VBF_Tight); 
                         return; 
                     }
                 }
@@ -698,21 +841,21 @@ void CategorySelectionSynch::evaluate(VarSet& vars)
 
             if(mjj_max > cDijetMassMinGGFT && vars.dimuCand->pt > cDimuPtMinGGFT)
             { 
-                categoryMap["c_2_Jet_GGF_Tight"].inCategory = true; 
+                setInCategory(id_2_Jet_GGF_Tight); 
                 return; 
             }
             else
             { 
-                categoryMap["c_2_Jet_VBF_Loose"].inCategory = true; 
+                setInCategory(id_2_Jet_VBF_Loose); 
                 return; 
             }
         }
     }
-    if(!categoryMap["c_2_Jet"].inCategory) // fails 2jet preselection enters 01 categories
+    if(!isInCategory(id_2_Jet)) // fails 2jet preselection enters 01 categories
     {
-        categoryMap["c_01_Jet"].inCategory = true;
-        if(vars.dimuCand->pt > cDimuPtMin01T){ categoryMap["c_01_Jet_Tight"].inCategory = true;}
-        else{ categoryMap["c_01_Jet_Loose"].inCategory = true; }
+        setInCategory(id_01_Jet);
+        if(vars.dimuCand->pt > cDimuPtMin01T){ setInCategory(id_01_Jet_Tight);}
+        else{ setInCategory(id_01_Jet_Loose); }
     }
 
 }
@@ -740,6 +883,20 @@ void CategorySelectionFEWZ::initCategoryMap()
     categoryMap["c_Central_Central_Narrow"] = Category("c_Central_Central_Narrow");
     categoryMap["c_Central_Not_Central_Narrow"] = Category("c_Central_Not_Central_Narrow");
     categoryMap["c_1Jet_Narrow"] = Category("c_1Jet_Narrow");
+
+    // dense ids for evaluate
+    indexCategories();
+    id_Wide                       = categoryId("c_Wide");
+    id_Narrow                     = categoryId("c_Narrow");
+    id_Central_Central            = categoryId("c_Central_Central");
+    id_Central_Not_Central        = categoryId("c_Central_Not_Central");
+    id_1Jet                       = categoryId("c_1Jet");
+    id_Central_Central_Wide       = categoryId("c_Central_Central_Wide");
+    id_Central_Not_Central_Wide   = categoryId("c_Central_Not_Central_Wide");
+    id_1Jet_Wide                  = categoryId("c_1Jet_Wide");
+    id_Central_Central_Narrow     = categoryId("c_Central_Central_Narrow");
+    id_Central_Not_Central_Narrow = categoryId("c_Central_Not_Central_Narrow");
+    id_1Jet_Narrow                = categoryId("c_1Jet_Narrow");
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -815,29 +972,29 @@ void CategorySelectionFEWZ::evaluate(VarSet& vars)
 
     // Should cut out all events that don't fall into the wide mass window in earlier selection stage
     // All events that pass are in window of min to max
-    categoryMap["c_Wide"].inCategory = true;
+    setInCategory(id_Wide);
 
     // Narrow goes from min to cMassSplit
-    if(dimu_mass < cMassSplit) categoryMap["c_Narrow"].inCategory = true;
+    if(dimu_mass < cMassSplit) setInCategory(id_Narrow);
 
     // Both central
-    if(TMath::Abs(eta0) < 0.8 && TMath::Abs(eta1) < 0.8) categoryMap["c_Central_Central"].inCategory = true;
+    if(TMath::Abs(eta0) < 0.8 && TMath::Abs(eta1) < 0.8) setInCategory(id_Central_Central);
 
     // Not both, but at least one is central
-    else if(TMath::Abs(eta0) < 0.8 || TMath::Abs(eta1) < 0.8) categoryMap["c_Central_Not_Central"].inCategory = true;
+    else if(TMath::Abs(eta0) < 0.8 || TMath::Abs(eta1) < 0.8) setInCategory(id_Central_Not_Central);
 
     // One category that passes basic selections and has exactly one jet
-    if(njets == 1) categoryMap["c_1Jet"].inCategory = true; 
+    if(njets == 1) setInCategory(id_1Jet); 
 
     // Final Categories ///////////////////////////////////////////////////////
-    if(categoryMap["c_Wide"].inCategory && categoryMap["c_Central_Central"].inCategory) categoryMap["c_Central_Central_Wide"].inCategory = true;
-    if(categoryMap["c_Narrow"].inCategory && categoryMap["c_Central_Central"].inCategory) categoryMap["c_Central_Central_Narrow"].inCategory = true;
+    if(isInCategory(id_Wide) && isInCategory(id_Central_Central)) setInCategory(id_Central_Central_Wide);
+    if(isInCategory(id_Narrow) && isInCategory(id_Central_Central)) setInCategory(id_Central_Central_Narrow);
 
-    if(categoryMap["c_Wide"].inCategory && categoryMap["c_Central_Not_Central"].inCategory) categoryMap["c_Central_Not_Central_Wide"].inCategory = true;
-    if(categoryMap["c_Narrow"].inCategory && categoryMap["c_Central_Not_Central"].inCategory) categoryMap["c_Central_Not_Central_Narrow"].inCategory = true;
+    if(isInCategory(id_Wide) && isInCategory(id_Central_Not_Central)) setInCategory(id_Central_Not_Central_Wide);
+    if(isInCategory(id_Narrow) && isInCategory(id_Central_Not_Central)) setInCategory(id_Central_Not_Central_Narrow);
 
-    if(categoryMap["c_Wide"].inCategory && categoryMap["c_1Jet"].inCategory) categoryMap["c_1Jet_Wide"].inCategory = true;
-    if(categoryMap["c_Narrow"].inCategory && categoryMap["c_1Jet"].inCategory) categoryMap["c_1Jet_Narrow"].inCategory = true;
+    if(isInCategory(id_Wide) && isInCategory(id_1Jet)) setInCategory(id_1Jet_Wide);
+    if(isInCategory(id_Narrow) && isInCategory(id_1Jet)) setInCategory(id_1Jet_Narrow);
 
     return;
 }
@@ -939,6 +1096,65 @@ void LotsOfCategoriesRun2::initCategoryMap()
 
     ///////////////// FAIL PRESELECTION //////////////////////////////
     categoryMap["c_Preselection_Fail"] = Category("c_Preselection_Fail");
+
+    // dense ids for evaluate
+    indexCategories();
+    id_ALL                       = categoryId("c_ALL");
+    id_BB                        = categoryId("c_BB");
+    id_BO                        = categoryId("c_BO");
+    id_BE                        = categoryId("c_BE");
+    id_OO                        = categoryId("c_OO");
+    id_OE                        = categoryId("c_OE");
+    id_EE                        = categoryId("c_EE");
+    id_Preselection_Pass         = categoryId("c_Preselection_Pass");
+    id_1b                        = categoryId("c_1b");
+    id_1b_TTH                    = categoryId("c_1b_TTH");
+    id_1b_TTH_2e                 = categoryId("c_1b_TTH_2e");
+    id_1b_TTH_1e_1mu             = categoryId("c_1b_TTH_1e_1mu");
+    id_1b_TTH_2mu                = categoryId("c_1b_TTH_2mu");
+    id_1b_TTH_BBH                = categoryId("c_1b_TTH_BBH");
+    id_1b_TTH_BBH_Tight          = categoryId("c_1b_TTH_BBH_Tight");
+    id_1b_TTH_BBH_V_Hadronic_H   = categoryId("c_1b_TTH_BBH_V_Hadronic_H");
+    id_1b_Leftovers              = categoryId("c_1b_Leftovers");
+    id_0b                        = categoryId("c_0b");
+    id_0b_nonVlH                 = categoryId("c_0b_nonVlH");
+    id_0b_nonVlH_2j              = categoryId("c_0b_nonVlH_2j");
+    id_0b_nonVlH_2j_VBF_Tight    = categoryId("c_0b_nonVlH_2j_VBF_Tight");
+    id_0b_nonVlH_2j_VBF_Loose    = categoryId("c_0b_nonVlH_2j_VBF_Loose");
+    id_0b_nonVlH_2j_V_Hadronic_H = categoryId("c_0b_nonVlH_2j_V_Hadronic_H");
+    id_0b_nonVlH_2j_gF           = categoryId("c_0b_nonVlH_2j_gF");
+    id_0b_nonVlH_01j             = categoryId("c_0b_nonVlH_01j");
+    id_0b_nonVlH_01j_ZvvH        = categoryId("c_0b_nonVlH_01j_ZvvH");
+    id_0b_nonVlH_01j_gF_Tight    = categoryId("c_0b_nonVlH_01j_gF_Tight");
+    id_0b_nonVlH_01j_gF_Tight_BB = categoryId("c_0b_nonVlH_01j_gF_Tight_BB");
+    id_0b_nonVlH_01j_gF_Tight_BO = categoryId("c_0b_nonVlH_01j_gF_Tight_BO");
+    id_0b_nonVlH_01j_gF_Tight_BE = categoryId("c_0b_nonVlH_01j_gF_Tight_BE");
+    id_0b_nonVlH_01j_gF_Tight_OO = categoryId("c_0b_nonVlH_01j_gF_Tight_OO");
+    id_0b_nonVlH_01j_gF_Tight_OE = categoryId("c_0b_nonVlH_01j_gF_Tight_OE");
+    id_0b_nonVlH_01j_gF_Tight_EE = categoryId("c_0b_nonVlH_01j_gF_Tight_EE");
+    id_0b_nonVlH_01j_gF_Loose    = categoryId("c_0b_nonVlH_01j_gF_Loose");
+    id_0b_nonVlH_01j_gF_Loose_BB = categoryId("c_0b_nonVlH_01j_gF_Loose_BB");
+    id_0b_nonVlH_01j_gF_Loose_BO = categoryId("c_0b_nonVlH_01j_gF_Loose_BO");
+    id_0b_nonVlH_01j_gF_Loose_BE = categoryId("c_0b_nonVlH_01j_gF_Loose_BE");
+    id_0b_nonVlH_01j_gF_Loose_OO = categoryId("c_0b_nonVlH_01j_gF_Loose_OO");
+    id_0b_nonVlH_01j_gF_Loose_OE = categoryId("c_0b_nonVlH_01j_gF_Loose_OE");
+    id_0b_nonVlH_01j_gF_Loose_EE = categoryId("c_0b_nonVlH_01j_gF_Loose_EE");
+    id_0b_VlH                    = categoryId("c_0b_VlH");
+    id_0b_VlH_We                 = categoryId("c_0b_VlH_We");
+    id_0b_VlH_Wmu                = categoryId("c_0b_VlH_Wmu");
+    id_0b_VlH_Ztautau            = categoryId("c_0b_VlH_Ztautau");
+    id_0b_VlH_Zmumu              = categoryId("c_0b_VlH_Zmumu");
+    id_0b_VlH_Zee                = categoryId("c_0b_VlH_Zee");
+    id_0b_VlH_Leftovers          = categoryId("c_0b_VlH_Leftovers");
+    id_Preselection_Fail         = categoryId("c_Preselection_Fail");
+
+    // geometric categories in geometricNames order
+    for(unsigned int g=0; g<geometricNames.size(); g++)
+    {
+        idGeo[g]        = categoryId("c_"+geometricNames[g]);
+        idGFTightGeo[g] = categoryId("c_0b_nonVlH_01j_gF_Tight_"+geometricNames[g]);
+        idGFLooseGeo[g] = categoryId("c_0b_nonVlH_01j_gF_Loose_"+geometricNames[g]);
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1027,49 +1243,49 @@ void LotsOfCategoriesRun2::evaluateMuonGeometry(VarSet& vars)
     // Geometric Categories
     // Barrel Barrel
     if(TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) < c_geo_bmax && TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) < c_geo_bmax) 
-        categoryMap["c_BB"].inCategory = true;
+        setInCategory(id_BB);
 
     // Overlap Overlap
     if(TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta)>=c_geo_bmax 
       && TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta)<c_geo_omax 
       && TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta)>=c_geo_bmax 
       && TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta)<c_geo_omax) 
-        categoryMap["c_OO"].inCategory = true;
+        setInCategory(id_OO);
 
     // Endcap Endcap
     if(TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) >= c_geo_omax 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) >= c_geo_omax) 
-        categoryMap["c_EE"].inCategory = true;
+        setInCategory(id_EE);
 
     // Barrel Overlap
     if(TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) < c_geo_bmax 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) >= c_geo_bmax 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) < c_geo_omax) 
-        categoryMap["c_BO"].inCategory = true;
+        setInCategory(id_BO);
 
     if(TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) < c_geo_bmax 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) >= c_geo_bmax 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) < c_geo_omax) 
-        categoryMap["c_BO"].inCategory = true;
+        setInCategory(id_BO);
 
     // Barrel Endcap
     if(TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) < c_geo_bmax 
       && TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) >= c_geo_omax) 
-        categoryMap["c_BE"].inCategory = true;
+        setInCategory(id_BE);
 
     if(TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) < c_geo_bmax && TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) >= c_geo_omax) 
-        categoryMap["c_BE"].inCategory = true;
+        setInCategory(id_BE);
 
     // Overlap Endcap
     if(TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) >= c_geo_bmax 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) < c_geo_omax 
       && TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) >= c_geo_omax) 
-        categoryMap["c_OE"].inCategory = true;
+        setInCategory(id_OE);
 
     if(TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) >= c_geo_bmax 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu2).eta) < c_geo_omax 
        && TMath::Abs(vars.muons->at(vars.dimuCand->iMu1).eta) >= c_geo_omax) 
-        categoryMap["c_OE"].inCategory = true;
+        setInCategory(id_OE);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1079,7 +1295,7 @@ void LotsOfCategoriesRun2::evaluateMuonGeometry(VarSet& vars)
 void LotsOfCategoriesRun2::evaluate(VarSet& vars)
 {
     ///////////////// INCLUSIVE //////////////////////////////
-    categoryMap["c_ALL"].inCategory = true;
+    setInCategory(id_ALL);
 
     // figure out bb,oo,ee,bo,be,oe
     ///////////////// MUON GEOMETRY //////////////////////////////
@@ -1087,94 +1303,94 @@ void LotsOfCategoriesRun2::evaluate(VarSet& vars)
 
     ///////////////// PRESELECTION //////////////////////////////
     if(vars.validExtraMuons.size() + vars.validElectrons.size() <= c_pre_numExtraLeptonsMax) 
-        categoryMap["c_Preselection_Pass"].inCategory = true;
+        setInCategory(id_Preselection_Pass);
     else
-        categoryMap["c_Preselection_Fail"].inCategory = true;
+        setInCategory(id_Preselection_Fail);
 
    // Determine whether we are in the at least 1b-jet categories or 0b-jet categories
-   if(categoryMap["c_Preselection_Pass"].inCategory)
+   if(isInCategory(id_Preselection_Pass))
    {
        //std::cout << "    pass preselection..." << std::endl;
        if(vars.validBJets.size() >= c_pre_numBJetsMin) 
-           categoryMap["c_1b"].inCategory = true;
+           setInCategory(id_1b);
        else
-           categoryMap["c_0b"].inCategory = true;
+           setInCategory(id_0b);
    }
 
        ///////////////// 1b CATEGORIES //////////////////////////////
-       if(categoryMap["c_1b"].inCategory)
+       if(isInCategory(id_1b))
        {
            //std::cout << "    pass 1b..." << std::endl;
            if(vars.validExtraMuons.size() + vars.validElectrons.size() == c_1b_numExtraLeptons_tth)
-               categoryMap["c_1b_TTH"].inCategory = true;
+               setInCategory(id_1b_TTH);
            else if(vars.validExtraMuons.size() + vars.validElectrons.size() == c_1b_numExtraLeptons_tth_bbh)
-               categoryMap["c_1b_TTH_BBH"].inCategory = true;
+               setInCategory(id_1b_TTH_BBH);
            else 
-               categoryMap["c_1b_Leftovers"].inCategory = true;
+               setInCategory(id_1b_Leftovers);
        }
            ///////////////// 1b-TTH (2 extra lept) CATEGORIES //////////////////////////////
-           if(categoryMap["c_1b_TTH"].inCategory)
+           if(isInCategory(id_1b_TTH))
            {
                //std::cout << "    pass 1b TTH..." << std::endl;
            }
            ///////////////// 1b_TTH_BBH (0 extra lept) CATEGORIES //////////////////////////////
-           if(categoryMap["c_1b_TTH_BBH"].inCategory)
+           if(isInCategory(id_1b_TTH_BBH))
            {
                //std::cout << "    pass 1b TTH_BBH..." << std::endl;
            }
 
        ///////////////// 0b CATEGORIES //////////////////////////////
-       if(categoryMap["c_0b"].inCategory)
+       if(isInCategory(id_0b))
        {
            //std::cout << "    pass 0b..." << std::endl;
            // output event information  here to debug... we have 70% in this category for N_valid_whatevers in data
            if(vars.validExtraMuons.size() + vars.validElectrons.size() >= c_0b_numExtraLeptonsMin)
-               categoryMap["c_0b_VlH"].inCategory = true;
+               setInCategory(id_0b_VlH);
            else
-               categoryMap["c_0b_nonVlH"].inCategory = true;
+               setInCategory(id_0b_nonVlH);
        }
            ///////////////// 0b-VlH    (1,2 extra lept) CATEGORIES //////////////////////////////
-           if(categoryMap["c_0b_VlH"].inCategory)
+           if(isInCategory(id_0b_VlH))
            {
                //std::cout << "    pass 0b_VlH..." << std::endl;
                if(vars.met->pt >= c_0b_VlH_MET_min)
                {
                     if(vars.validElectrons.size() == c_0b_VlH_We_num_e && vars.validExtraMuons.size() == c_0b_VlH_We_num_mu)    
-                        categoryMap["c_0b_VlH_We"].inCategory = true;
+                        setInCategory(id_0b_VlH_We);
 
                     else if(vars.validElectrons.size() == c_0b_VlH_Wmu_num_e && vars.validExtraMuons.size() == c_0b_VlH_Wmu_num_mu)    
-                        categoryMap["c_0b_VlH_Wmu"].inCategory = true;
+                        setInCategory(id_0b_VlH_Wmu);
 
                     else if(vars.validElectrons.size() == c_0b_VlH_Ztautau_num_e && vars.validExtraMuons.size() == c_0b_VlH_Ztautau_num_mu)    
-                        categoryMap["c_0b_VlH_Ztautau"].inCategory = true;
+                        setInCategory(id_0b_VlH_Ztautau);
 
                     else    
-                        categoryMap["c_0b_VlH_Leftovers"].inCategory = true;
+                        setInCategory(id_0b_VlH_Leftovers);
                }
                else
                {
                     if(vars.validElectrons.size() == c_0b_VlH_Zmumu_num_e && vars.validExtraMuons.size() == c_0b_VlH_Zmumu_num_mu)    
-                        categoryMap["c_0b_VlH_Zmumu"].inCategory = true;
+                        setInCategory(id_0b_VlH_Zmumu);
 
                     else if(vars.validElectrons.size() == c_0b_VlH_Zee_num_e && vars.validExtraMuons.size() == c_0b_VlH_Zee_num_mu)    
-                        categoryMap["c_0b_VlH_Zee"].inCategory = true;
+                        setInCategory(id_0b_VlH_Zee);
 
                     else    
-                        categoryMap["c_0b_VlH_Leftovers"].inCategory = true;
+                        setInCategory(id_0b_VlH_Leftovers);
                }
            }
 
            ///////////////// 0b-nonVlH (0 extra lept) CATEGORIES //////////////////////////////
-           if(categoryMap["c_0b_nonVlH"].inCategory)
+           if(isInCategory(id_0b_nonVlH))
            {
                //std::cout << "    pass 0b_non_VlH..." << std::endl;
                if(vars.validJets.size() >= c_0b_nonVlH_njetsMin)
-                   categoryMap["c_0b_nonVlH_2j"].inCategory = true;
+                   setInCategory(id_0b_nonVlH_2j);
                else
-                   categoryMap["c_0b_nonVlH_01j"].inCategory = true;
+                   setInCategory(id_0b_nonVlH_01j);
            }
                ///////////////// 0b-nonVlH_2j (0 extra lept) CATEGORIES //////////////////////////////
-               if(categoryMap["c_0b_nonVlH_2j"].inCategory)
+               if(isInCategory(id_0b_nonVlH_2j))
                {
                    //std::cout << "    pass 0b_non_VlHi_2j..." << std::endl;
                    TLorentzVector leadJet    = vars.validJets[0];
@@ -1186,40 +1402,70 @@ void LotsOfCategoriesRun2::evaluate(VarSet& vars)
                    float dEtajjMuMu = TMath::Abs(dijet.Eta() - vars.dimuCand->eta); 
 
                    if(dijetMass > c_0b_nonVlH_2j_mjj_min_vbfTight && dEta > c_0b_nonVlH_2j_dEtajj_min_vbfTight)
-                       categoryMap["c_0b_nonVlH_2j_VBF_Tight"].inCategory = true; 
+                       setInCategory(id_0b_nonVlH_2j_VBF_Tight); 
 
                    else if(dijetMass > c_0b_nonVlH_2j_mjj_min_vbfLoose && dEta > c_0b_nonVlH_2j_dEtajj_min_vbfLoose)
-                       categoryMap["c_0b_nonVlH_2j_VBF_Loose"].inCategory = true; 
+                       setInCategory(id_0b_nonVlH_2j_VBF_Loose); 
 
                    else if(dijetMass > c_0b_nonVlH_2j_mjj_min_VhH && dijetMass < c_0b_nonVlH_2j_mjj_max_VhH && dEtajjMuMu < c_0b_nonVlH_2j_dEtajjMuMu_max_VhH)
-                       categoryMap["c_0b_nonVlH_2j_V_Hadronic_H"].inCategory = true; 
+                       setInCategory(id_0b_nonVlH_2j_V_Hadronic_H); 
 
                    else
-                       categoryMap["c_0b_nonVlH_2j_gF"].inCategory = true; 
+                       setInCategory(id_0b_nonVlH_2j_gF); 
                }
 
                ///////////////// 0b-nonVlH_01j (0 extra lept) CATEGORIES //////////////////////////////
-               if(categoryMap["c_0b_nonVlH_01j"].inCategory)
+               if(isInCategory(id_0b_nonVlH_01j))
                {
                    //std::cout << "    pass 0b_nonVlH_01j..." << std::endl;
                    if(vars.met->pt > c_0b_nonVlH_01j_MET_min_ZvvH)
-                       categoryMap["c_0b_nonVlH_01j_ZvvH"].inCategory = true; 
+                       setInCategory(id_0b_nonVlH_01j_ZvvH); 
 
                    else if(vars.dimuCand->pt >= c_0b_nonVlH_01j_dimuPt_min_gfTight)
-                       categoryMap["c_0b_nonVlH_01j_gF_Tight"].inCategory = true; 
+                       setInCategory(id_0b_nonVlH_01j_gF_Tight); 
 
                    else
-                       categoryMap["c_0b_nonVlH_01j_gF_Loose"].inCategory = true; 
+                       setInCategory(id_0b_nonVlH_01j_gF_Loose); 
                }
                    ///////////////// Geometrized 0b-nonVlH_01j_gF CATEGORIES //////////////////////////////
-                   if(categoryMap["c_0b_nonVlH_01j_gF_Tight"].inCategory)
+                   if(isInCategory(id_0b_nonVlH_01j_gF_Tight))
                    {
-                       for(auto& geoName: geometricNames)
-                           if(categoryMap["c_"+geoName].inCategory) categoryMap["c_0b_nonVlH_01j_gF_Tight_"+geoName].inCategory = true;
+                       for(unsigned int g=0; g<geometricNames.size(); g++)
+                           if(isInCategory(idGeo[g])) setInCategory(idGFTightGeo[g]);
                    }
-                   if(categoryMap["c_0b_nonVlH_01j_gF_Loose"].inCategory)
+                   if(isInCategory(id_0b_nonVlH_01j_gF_Loose))
                    {
-                       for(auto& geoName: geometricNames)
-                           if(categoryMap["c_"+geoName].inCategory) categoryMap["c_0b_nonVlH_01j_gF_Loose_"+geoName].inCategory = true;
+                       for(unsigned int g=0; g<geometricNames.size(); g++)
+                           if(isInCategory(idGeo[g])) setInCategory(idGFLooseGeo[g]);
                    }
 }
+
+///////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////
+// _______________________Generated Categorizer Plugins__________________//
+///////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////
+
+Categorizer* loadCategorizerPlugin(TString name, TString dir)
+{
+// the library stays loaded for the rest of the run, dlopen counts the references
+// so every thread can load the same plugin
+    if(dir != "" && !dir.EndsWith("/")) dir += "/";
+    TString libname = dir+"lib"+name+".so";
+
+    void* lib = dlopen(libname.Data(), RTLD_NOW);
+    if(lib == 0)
+    {
+        std::cout << Form("  !!! could not load categorizer plugin %s: %s \n", libname.Data(), dlerror());
+        return 0;
+    }
+
+    TString factoryName = "createCategorizer_"+name;
+    CategorizerFactory factory = (CategorizerFactory) dlsym(lib, factoryName.Data());
+    if(factory == 0)
+    {
+        std::cout << Form("  !!! %s has no %s \n", libname.Data(), factoryName.Data());
+        return 0;
+    }
+    return factory();
+}
@@ -7,6 +7,8 @@
 // structure. We keep track of the different categories in the           //
 // in the categorizer via categoryMap<TString, Category>. Each category  //
 // tracks its historams with histoMap<TString, TH1D*> and some TLists.   //
+// The categories are also given dense integer ids, evaluate sets the    //
+// ids in a per event bitset and the fill loops visit only those ids.    //
 //                                                                       //
 ///////////////////////////////////////////////////////////////////////////
 
@@ -76,6 +78,9 @@ class Category
        // Book-keeping
        TString key;
        TString name = "";
+
+       // dense integer id assigned by Categorizer::indexCategories, -1 if not indexed
+       int id = -1;
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -87,6 +92,9 @@ class Categorizer
 // This class evaluates the event and determines which category or categories it belongs to
 
     public:
+        // deleted through Categorizer* once the histos are merged
+        virtual ~Categorizer(){};
+
         // the categories the event may fall into
         std::map<TString, Category> categoryMap;
 
@@ -96,11 +104,64 @@ class Categorizer
         // Determine which category the event belongs to
         virtual void evaluate(VarSet& vars) = 0;
 
-        // reset the boolean values for the categories
-        void reset()
+        // The categories also get dense integer ids so that evaluate and the fill loops
+        // can skip the categoryMap lookups. The names are only needed for booking and output.
+        std::vector<Category*> categories;   // id -> category in categoryMap
+        std::vector<ULong64_t> inBits;       // bit id is set if the event is in category id
+        std::vector<int> inIds;              // ids of the categories the event is in, visit these in the fill loop
+
+        // assign the ids in categoryMap order, call after the categoryMap is filled
+        void indexCategories()
         {
+            categories.clear();
             for(auto &entry : categoryMap)
-                entry.second.inCategory = false;
+            {
+                entry.second.id = categories.size();
+                categories.push_back(&entry.second);
+            }
+            inBits.assign((categories.size()+63)/64, 0);
+            inIds.clear();
+            inIds.reserve(categories.size());
+        };
+
+        // id of a category from its key, for setup only, -1 if there is no such category
+        int categoryId(const TString& key)
+        {
+            auto it = categoryMap.find(key);
+            if(it == categoryMap.end()) return -1;
+            return it->second.id;
+        };
+
+        // put the event in category id, inCategory is kept in sync for the code that reads it
+        void setInCategory(int id)
+        {
+            ULong64_t bit = 1ULL << (id & 63);
+            if(inBits[id >> 6] & bit) return;
+            inBits[id >> 6] |= bit;
+            inIds.push_back(id);
+            categories[id]->inCategory = true;
+        };
+
+        bool isInCategory(int id) const
+        {
+            return inBits[id >> 6] & (1ULL << (id & 63));
+        };
+
+        // reset the boolean values for the categories, only the ones that were set
+        void reset()
+        {
+            if(categories.size() == 0)
+            {
+                for(auto &entry : categoryMap)
+                    entry.second.inCategory = false;
+                return;
+            }
+            for(int id : inIds)
+            {
+                inBits[id >> 6] = 0;
+                categories[id]->inCategory = false;
+            }
+            inIds.clear();
         };
 
         // output the category selection results
@@ -162,6 +223,17 @@ class CategoryNode
         double significanceSquared;
 };
 
+// The XML tree compiled into an array, the daughters are indices into the array
+// and the split variable is resolved to a VarSet handle. Terminal nodes have left = right = -1.
+struct FlatCategoryNode
+{
+    int category = -1;             // Category id
+    int left = -1;
+    int right = -1;
+    VarSet::VarHandle splitVar;
+    double splitVal = -999;
+};
+
 // XMLCategorizer reads in an XML Decision Tree as the categorization.
 class XMLCategorizer : public Categorizer
 {
@@ -179,6 +251,18 @@ class XMLCategorizer : public Categorizer
         void loadFromXMLRecursive(TXMLEngine* xml, XMLNodePointer_t xnode, CategoryNode* cnode);
         CategoryNode* filterEvent(VarSet& vars);
         CategoryNode* filterEventRecursive(VarSet& vars);
+
+        // flat version of the tree made by loadFromXML, used by evaluate
+        std::vector<FlatCategoryNode> flatNodes;
+        std::vector<TString> flatSplitVarNames;     // split variable name for each node, resolved on the first evaluate
+        bool flatResolved = false;
+
+        void compile();
+        int compileRecursive(CategoryNode* cnode);
+
+        // walk the flat tree, set inCategory for the nodes on the path, and return the
+        // path as a bitset, bit d is set if the event went right at depth d
+        ULong64_t evaluateFlat(VarSet& vars);
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -194,7 +278,7 @@ class CategorySelectionHybrid : public XMLCategorizer
         CategorySelectionHybrid(TString xmlfile){ initCategoryMap(); loadFromXML(xmlfile); }; 
 
         // Determine which category the event belongs to
-        void evaluate(VarSet& vars){ evaluateRecursive(vars, rootNode); };
+        void evaluate(VarSet& vars){ evaluateFlat(vars); };
         void initCategoryMap(){};
 };
 
@@ -207,9 +291,18 @@ class CategorySelectionBDT : public Categorizer
     public:
         CategorySelectionBDT(); 
 
+        // category ids, set in initCategoryMap
+        int idAll;
+        int idC[15];
+
         // Determine which category the event belongs to
         void evaluate(VarSet& vars);
         void initCategoryMap();
+
+    private:
+        VarSet::VarHandle hBdtScore;
+        VarSet::VarHandle hMaxAbsEta;
+        bool resolved = false;
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -241,6 +334,15 @@ class CategorySelectionRun1 : public Categorizer
         // 01Tight
         float cDimuPtMin01T; 
 
+        // category ids, set in initCategoryMap
+        int id_ALL, id_2_Jet, id_01_Jet, id_2_Jet_VBF_Tight;
+        int id_2_Jet_VBF_Loose, id_2_Jet_GGF_Tight, id_01_Jet_Tight, id_01_Jet_Loose;
+        int id_BB, id_BO, id_BE, id_OO;
+        int id_OE, id_EE, id_01_Jet_Tight_BB, id_01_Jet_Tight_BO;
+        int id_01_Jet_Tight_BE, id_01_Jet_Tight_OO, id_01_Jet_Tight_OE, id_01_Jet_Tight_EE;
+        int id_01_Jet_Loose_BB, id_01_Jet_Loose_BO, id_01_Jet_Loose_BE, id_01_Jet_Loose_OO;
+        int id_01_Jet_Loose_OE, id_01_Jet_Loose_EE;
+
         // Determine which category the event belongs to
         // result stored in isVBFTight, isGGFTight, etc 
         void evaluate(VarSet& vars);
@@ -276,6 +378,10 @@ class CategorySelectionSynch : public Categorizer
         // 01Tight
         float cDimuPtMin01T; 
 
+        // category ids, set in initCategoryMap
+        int id_ALL, id_2_Jet, id_01_Jet, id_2_Jet_VBF_Tight;
+        int id_2_Jet_VBF_Loose, id_2_Jet_GGF_Tight, id_01_Jet_Tight, id_01_Jet_Loose;
+
         // Determine which category the event belongs to
         // result stored in isVBFTight, isGGFTight, etc 
         void evaluate(VarSet& vars);
@@ -363,6 +469,21 @@ class LotsOfCategoriesRun2 : public Categorizer
 
         // list of geometric categories
         std::vector<TString> geometricNames;
+        int idGeo[6], idGFTightGeo[6], idGFLooseGeo[6];    // category ids in geometricNames order
+
+        // category ids, set in initCategoryMap
+        int id_ALL, id_BB, id_BO, id_BE;
+        int id_OO, id_OE, id_EE, id_Preselection_Pass;
+        int id_1b, id_1b_TTH, id_1b_TTH_2e, id_1b_TTH_1e_1mu;
+        int id_1b_TTH_2mu, id_1b_TTH_BBH, id_1b_TTH_BBH_Tight, id_1b_TTH_BBH_V_Hadronic_H;
+        int id_1b_Leftovers, id_0b, id_0b_nonVlH, id_0b_nonVlH_2j;
+        int id_0b_nonVlH_2j_VBF_Tight, id_0b_nonVlH_2j_VBF_Loose, id_0b_nonVlH_2j_V_Hadronic_H, id_0b_nonVlH_2j_gF;
+        int id_0b_nonVlH_01j, id_0b_nonVlH_01j_ZvvH, id_0b_nonVlH_01j_gF_Tight, id_0b_nonVlH_01j_gF_Tight_BB;
+        int id_0b_nonVlH_01j_gF_Tight_BO, id_0b_nonVlH_01j_gF_Tight_BE, id_0b_nonVlH_01j_gF_Tight_OO, id_0b_nonVlH_01j_gF_Tight_OE;
+        int id_0b_nonVlH_01j_gF_Tight_EE, id_0b_nonVlH_01j_gF_Loose, id_0b_nonVlH_01j_gF_Loose_BB, id_0b_nonVlH_01j_gF_Loose_BO;
+        int id_0b_nonVlH_01j_gF_Loose_BE, id_0b_nonVlH_01j_gF_Loose_OO, id_0b_nonVlH_01j_gF_Loose_OE, id_0b_nonVlH_01j_gF_Loose_EE;
+        int id_0b_VlH, id_0b_VlH_We, id_0b_VlH_Wmu, id_0b_VlH_Ztautau;
+        int id_0b_VlH_Zmumu, id_0b_VlH_Zee, id_0b_VlH_Leftovers, id_Preselection_Fail;
 
         // Determine which category the event belongs to
         void evaluate(VarSet& vars);
@@ -392,10 +513,24 @@ class CategorySelectionFEWZ : public Categorizer
         float cJetPtMin;
         float cJetEtaMax;
 
+        // category ids, set in initCategoryMap
+        int id_Wide, id_Narrow, id_Central_Central, id_Central_Not_Central;
+        int id_1Jet, id_Central_Central_Wide, id_Central_Not_Central_Wide, id_1Jet_Wide;
+        int id_Central_Central_Narrow, id_Central_Not_Central_Narrow, id_1Jet_Narrow;
+
         // Determine which category the event belongs to
         void evaluate(VarSet& vars);
         void initCategoryMap();
 };
 
+//////////////////////////////////////////////////////////////////////////
+//// ________Generated Categorizer Plugins______________________________//
+//////////////////////////////////////////////////////////////////////////
+
+// bin/generateCategorizer turns a categorization XML into a Categorizer subclass
+// with the splits written out as code. It is built into dir/lib<name>.so, which
+// exports createCategorizer_<name>. Returns 0 if the plugin can't be loaded.
+typedef Categorizer* (*CategorizerFactory)();
+Categorizer* loadCategorizerPlugin(TString name, TString dir = "plugins/");
 
 #endif
@@ -89,6 +89,33 @@ bool Run2EventSelectionCuts::evaluate(VarSet& vars)
 //-----------------------------------------------------------------------------
 ///////////////////////////////////////////////////////////////////////////////
 
+unsigned int Run2EventSelectionCuts::evaluateCuts(VarSet& vars)
+{
+// evaluate all of the cuts, on or off, bit i of the result is set if cuts[i] passed
+    MuonInfo& mu1 = vars.muons->at(vars.dimuCand->iMu1);
+    MuonInfo& mu2 = vars.muons->at(vars.dimuCand->iMu2);
+
+    // the pt of the leading hlt matched muon, -1 if neither muon is matched
+    bool mu1Matched = mu1.isHltMatched[2] || mu1.isHltMatched[3];
+    bool mu2Matched = mu2.isHltMatched[2] || mu2.isHltMatched[3];
+    float trigMuPt = -1;
+    if(mu1Matched) trigMuPt = mu1.pt;
+    if(mu2Matched && mu2.pt > trigMuPt) trigMuPt = mu2.pt;
+
+    bool trigPassed = (mu1Matched && mu1.pt > cTrigMuPtMin) || (mu2Matched && mu2.pt > cTrigMuPtMin);
+
+    unsigned int mask = 0;
+    mask |= cutset.setResult(0, mu1.charge != mu2.charge, mu1.charge != mu2.charge);
+    mask |= cutset.setResult(1, trigMuPt, trigPassed);
+    mask |= cutset.setResult(2, vars.dimuCand->mass, vars.dimuCand->mass > cDimuMassMin);
+
+    return mask;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
 TString Run2EventSelectionCuts::string()
 {
     return TString("Run2_Event_Selection");
@@ -330,6 +357,39 @@ bool FEWZCompareCuts::evaluate(VarSet& vars)
 //-----------------------------------------------------------------------------
 ///////////////////////////////////////////////////////////////////////////////
 
+unsigned int FEWZCompareCuts::evaluateCuts(VarSet& vars)
+{
+// evaluate all of the cuts, on or off, bit i of the result is set if cuts[i] passed
+    int mu1 = vars.dimuCand->iMu1;
+    int mu2 = vars.dimuCand->iMu2;
+
+    float leadPt = TMath::Max(vars.muons->at(mu1).pt, vars.muons->at(mu2).pt);
+    float subleadPt = TMath::Min(vars.muons->at(mu1).pt, vars.muons->at(mu2).pt);
+    float eta0 = TMath::Abs(vars.muons->at(mu1).eta);
+    float eta1 = TMath::Abs(vars.muons->at(mu2).eta);
+    float dimu_mass = vars.dimuCand->mass;
+    bool oppositeCharge = vars.muons->at(mu1).charge != vars.muons->at(mu2).charge;
+    float iso0 = vars.muons->at(mu1).iso();
+    float iso1 = vars.muons->at(mu2).iso();
+
+    unsigned int mask = 0;
+    mask |= cutset.setResult(0, leadPt, leadPt > cLeadPtMin);
+    mask |= cutset.setResult(1, subleadPt, subleadPt > cSubleadPtMin);
+    mask |= cutset.setResult(2, eta0, eta0 < cMaxEta);
+    mask |= cutset.setResult(3, eta1, eta1 < cMaxEta);
+    mask |= cutset.setResult(4, dimu_mass, dimu_mass > cDimuMassMin);
+    mask |= cutset.setResult(5, dimu_mass, dimu_mass < cDimuMassMax);
+    mask |= cutset.setResult(6, oppositeCharge, oppositeCharge);
+    mask |= cutset.setResult(7, iso0, iso0 <= cMaxRelIso);
+    mask |= cutset.setResult(8, iso1, iso1 <= cMaxRelIso);
+
+    return mask;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
 TString FEWZCompareCuts::string()
 {
     return TString("FEWZ_Comparison_Cuts");
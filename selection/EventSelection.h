@@ -25,6 +25,7 @@ class Run2EventSelectionCuts : public Cut
 
         void makeCutSet();
         bool evaluate(VarSet& vars);
+        unsigned int evaluateCuts(VarSet& vars);
         TString string();
 };
 
@@ -61,6 +62,7 @@ class FEWZCompareCuts : public Cut
         void makeCutSet();
         bool evaluate(VarSet& vars);
         bool evaluate(_MuonInfo& recoMu, int m);
+        unsigned int evaluateCuts(VarSet& vars);
         TString string();
 };
 #endif
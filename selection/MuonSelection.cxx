@@ -88,6 +88,28 @@ bool Run2MuonSelectionCuts::evaluate(VarSet& vars)
 //-----------------------------------------------------------------------------
 ///////////////////////////////////////////////////////////////////////////////
 
+unsigned int Run2MuonSelectionCuts::evaluateCuts(VarSet& vars)
+{
+// evaluate all of the cuts, on or off, bit i of the result is set if cuts[i] passed
+    MuonInfo& mu1 = vars.muons->at(vars.dimuCand->iMu1); 
+    MuonInfo& mu2 = vars.muons->at(vars.dimuCand->iMu2); 
+
+    unsigned int mask = 0;
+    mask |= cutset.setResult(0, mu1.pt, mu1.pt > cMinPt);
+    mask |= cutset.setResult(1, TMath::Abs(mu1.eta), TMath::Abs(mu1.eta) < cMaxEta);
+    mask |= cutset.setResult(2, mu1.iso(), mu1.iso() <= cMaxRelIso);
+
+    mask |= cutset.setResult(3, mu2.pt, mu2.pt > cMinPt);
+    mask |= cutset.setResult(4, TMath::Abs(mu2.eta), TMath::Abs(mu2.eta) < cMaxEta);
+    mask |= cutset.setResult(5, mu2.iso(), mu2.iso() <= cMaxRelIso);
+
+    return mask;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
 TString Run2MuonSelectionCuts::string()
 {
     return TString("Run2_Muon_Selection_Cuts");
@@ -25,6 +25,7 @@ class Run2MuonSelectionCuts : public Cut
 
         void makeCutSet();
         bool evaluate(VarSet& vars);
+        unsigned int evaluateCuts(VarSet& vars);
         TString string();
 };
 
@@ -13,8 +13,11 @@
 
 #include "VarSet.h"
 #include "TLorentzVector.h"
+#include "TMath.h"
 #include "ParticleTools.h"
 #include <vector>
+#include <cmath>
+#include <algorithm>
 #include <iostream>
 
 class CollectionCleaner
@@ -22,53 +25,146 @@ class CollectionCleaner
     public:
         CollectionCleaner(){};
         ~CollectionCleaner(){};
+
+        static void markOverlapsDR2(const double* cleanEta, const double* cleanPhi, unsigned int nclean,
+                                    const double* fromEta, const double* fromPhi, unsigned int nfrom,
+                                    double dR2min, unsigned char* overlap)
+        {
+        // flag overlap[j] for each item j in the clean arrays that is within dR of any item in the from arrays.
+        // compares dR^2 = deta^2 + dphi^2 with the wrapped dphi, so there is no sqrt and no branch
+        // in the inner loop and the compiler is free to vectorize it
+            for(unsigned int i=0; i<nfrom; i++)
+            {
+                const double feta = fromEta[i];
+                const double fphi = fromPhi[i];
+                for(unsigned int j=0; j<nclean; j++)
+                {
+                    double deta = cleanEta[j] - feta;
+                    double dphi = std::fabs(cleanPhi[j] - fphi);
+                    dphi = std::min(dphi, 2*TMath::Pi() - dphi);
+                    overlap[j] |= (unsigned char)(deta*deta + dphi*dphi < dR2min);
+                }
+            }
+        };
+
+        static bool overlapsDR2(double eta, double phi, const double* fromEta, const double* fromPhi,
+                                unsigned int nfrom, double dR2min)
+        {
+        // same dR^2 test as above for a single candidate, used when the candidates are
+        // accepted one at a time and the from arrays grow as we go
+            unsigned char overlap = 0;
+            for(unsigned int i=0; i<nfrom; i++)
+            {
+                double deta = eta - fromEta[i];
+                double dphi = std::fabs(phi - fromPhi[i]);
+                dphi = std::min(dphi, 2*TMath::Pi() - dphi);
+                overlap |= (unsigned char)(deta*deta + dphi*dphi < dR2min);
+            }
+            return overlap;
+        };
+
+        template<class T>
+        static void compact(std::vector<T>& cleanThis, const unsigned char* overlap)
+        {
+        // remove the flagged items in one pass, keeping the order of the survivors
+            unsigned int n = 0;
+            for(unsigned int j=0; j<cleanThis.size(); j++)
+            {
+                if(overlap[j]) continue;
+                if(n != j) cleanThis[n] = cleanThis[j];
+                n++;
+            }
+            cleanThis.resize(n);
+        };
+
         static void cleanByDR(std::vector<TLorentzVector>& cleanThis, std::vector<TLorentzVector>& fromThis, float dRmin, bool print=false)
         {
         // remove items from cleanThis if they are too close in dR to any item in fromThis
-            for(unsigned int i=0; i<fromThis.size(); i++)
-            {   
-                if(print) std::cout << Form("Checking against > %s \n", ParticleTools::output4vecInfo(fromThis[i]).Data());
-                for(unsigned int j=0; j<cleanThis.size(); j++)
-                {
-                    if(print) std::cout << Form("    Candidate > %s, dR: %7.3f\n", ParticleTools::output4vecInfo(cleanThis[j]).Data(), 
-                                          cleanThis[j].DeltaR(fromThis[i]));
+            if(cleanThis.size() == 0 || fromThis.size() == 0) return;
+
+            // eta requires a log and a sqrt, so compute it once per object
+            // rather than once per pair
+            DRScratch& s = scratch();
+            s.load(cleanThis, fromThis);
 
-                    if(cleanThis[j].DeltaR(fromThis[i]) < dRmin) 
+            markOverlapsDR2(s.cleanEta.data(), s.cleanPhi.data(), cleanThis.size(),
+                            s.fromEta.data(), s.fromPhi.data(), fromThis.size(),
+                            (double)dRmin*dRmin, s.overlap.data());
+
+            if(print)
+            {
+                for(unsigned int i=0; i<fromThis.size(); i++)
+                {
+                    std::cout << Form("Checking against > %s \n", ParticleTools::output4vecInfo(fromThis[i]).Data());
+                    for(unsigned int j=0; j<cleanThis.size(); j++)
                     {
-                        if(print) std::cout << Form("    Removing candidate > %s, dR: %7.3f\n", ParticleTools::output4vecInfo(cleanThis[j]).Data(),
-                                                    cleanThis[j].DeltaR(fromThis[i]));
-
-                        // remove the item and make decrement j
-                        // since the next item will fall back into
-                        // the same index (j-- then j++ leaves j the same)
-                        cleanThis.erase(cleanThis.begin()+j); 
-                        j--;
+                        double dR = cleanThis[j].DeltaR(fromThis[i]);
+                        std::cout << Form("    Candidate > %s, dR: %7.3f\n", ParticleTools::output4vecInfo(cleanThis[j]).Data(), dR);
+                        if(dR < dRmin)
+                            std::cout << Form("    Removing candidate > %s, dR: %7.3f\n", ParticleTools::output4vecInfo(cleanThis[j]).Data(), dR);
                     }
                 }
-            }   
+            }
 
+            compact(cleanThis, s.overlap.data());
         };
+
         template<class T, class U>
         static void cleanByDR(std::vector<T>& cleanThis, std::vector<U>& fromThis, float dRmin)
         {
         // remove items from cleanThis if they are too close in dR to any item in fromThis
-            for(unsigned int i=0; i<fromThis.size(); i++)
-            {   
-                TLorentzVector fromThis4vec = fromThis[i].get4vec();
+        // same kernel as above, the analyzer objects are converted to eta/phi once each
+            if(cleanThis.size() == 0 || fromThis.size() == 0) return;
+
+            DRScratch& s = scratch();
+            s.load(cleanThis, fromThis);
+
+            markOverlapsDR2(s.cleanEta.data(), s.cleanPhi.data(), cleanThis.size(),
+                            s.fromEta.data(), s.fromPhi.data(), fromThis.size(),
+                            (double)dRmin*dRmin, s.overlap.data());
+
+            compact(cleanThis, s.overlap.data());
+        };
+
+    private:
+        // contiguous eta/phi arrays for the kernel, kept per thread so that
+        // they are only reallocated when a collection grows past its old size
+        struct DRScratch
+        {
+            std::vector<double> cleanEta, cleanPhi, fromEta, fromPhi;
+            std::vector<unsigned char> overlap;
+
+            static double eta(TLorentzVector& v) { return v.Eta(); };
+            static double phi(TLorentzVector& v) { return v.Phi(); };
+            template<class T> static double eta(T& t) { return t.get4vec().Eta(); };
+            template<class T> static double phi(T& t) { return t.get4vec().Phi(); };
+
+            template<class T, class U>
+            void load(std::vector<T>& cleanThis, std::vector<U>& fromThis)
+            {
+                cleanEta.resize(cleanThis.size());
+                cleanPhi.resize(cleanThis.size());
+                fromEta.resize(fromThis.size());
+                fromPhi.resize(fromThis.size());
+                overlap.assign(cleanThis.size(), 0);
+
                 for(unsigned int j=0; j<cleanThis.size(); j++)
                 {
-                    TLorentzVector cleanThis4vec = cleanThis[j].get4vec();
-                    if(cleanThis4vec.DeltaR(fromThis4vec) < dRmin) 
-                    {
-                        // remove the item and make decrement j
-                        // since the next item will fall back into
-                        // the same index (j-- then j++ leaves j the same)
-                        cleanThis.erase(cleanThis.begin()+j); 
-                        j--;
-                    }
+                    cleanEta[j] = eta(cleanThis[j]);
+                    cleanPhi[j] = phi(cleanThis[j]);
                 }
-            }   
+                for(unsigned int i=0; i<fromThis.size(); i++)
+                {
+                    fromEta[i] = eta(fromThis[i]);
+                    fromPhi[i] = phi(fromThis[i]);
+                }
+            };
+        };
 
+        static DRScratch& scratch()
+        {
+            static thread_local DRScratch s;
+            return s;
         };
 };
 
@@ -0,0 +1,221 @@
+///////////////////////////////////////////////////////////////////////////
+//                         FusedCollectionCleaner.cxx                    //
+//=======================================================================//
+//                                                                       //
+//        Select valid muons, electrons, jets and bjets and remove the   //
+//        overlaps between them in a single pass over each collection.   //
+//        Does the same job as the Muon/Ele/JetCollectionCleaners        //
+//        followed by the cleanByDR calls.                               //
+//                                                                       //
+///////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////
+// _______________________Includes_______________________________________//
+///////////////////////////////////////////////////////////////////////////
+
+#include "FusedCollectionCleaner.h"
+#include "TMath.h"
+#include "TLorentzVector.h"
+
+///////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////
+// ___________________FusedCollectionCleaner_____________________________//
+///////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////
+
+FusedCollectionCleaner::FusedCollectionCleaner()
+{
+// same defaults as the individual cleaners and the dR used in categorize
+    cMuonSelectionPtMin = 10;
+    cMuonSelectionEtaMax = 2.4;
+    cMuonSelectionIsoMax = 0.25;
+    cMuonSelectionID = 1;
+    cUseMedium2016 = false;
+
+    cElectronSelectionPtMin = 10;
+    cElectronSelectionEtaMax = 2.5;
+    cElectronSelectionIsoMax = 0.15;
+    cElectronSelectionID = 1;
+
+    cJetSelectionPtMin = 30;
+    cJetSelectionEtaMax = 4.7;
+    cJetSelectionBTagMin = 0.8484;
+    cJetSelectionBJetEtaMax = 2.4;
+
+    cOverlapdRMin = 0.4;
+    cCleanJetsFromElectrons = true;
+    cCleanBJetsFromLeptons = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+FusedCollectionCleaner::FusedCollectionCleaner(JetCollectionCleaner& jetCleaner, MuonCollectionCleaner& muonCleaner,
+                                               EleCollectionCleaner& eleCleaner, float overlapdRMin)
+{
+// copy the settings from already configured cleaners
+    cMuonSelectionPtMin = muonCleaner.cMuonSelectionPtMin;
+    cMuonSelectionEtaMax = muonCleaner.cMuonSelectionEtaMax;
+    cMuonSelectionIsoMax = muonCleaner.cMuonSelectionIsoMax;
+    cMuonSelectionID = muonCleaner.cMuonSelectionID;
+    cUseMedium2016 = muonCleaner.cUseMedium2016;
+
+    cElectronSelectionPtMin = eleCleaner.cElectronSelectionPtMin;
+    cElectronSelectionEtaMax = eleCleaner.cElectronSelectionEtaMax;
+    cElectronSelectionIsoMax = eleCleaner.cElectronSelectionIsoMax;
+    cElectronSelectionID = eleCleaner.cElectronSelectionID;
+
+    cJetSelectionPtMin = jetCleaner.cJetSelectionPtMin;
+    cJetSelectionEtaMax = jetCleaner.cJetSelectionEtaMax;
+    cJetSelectionBTagMin = jetCleaner.cJetSelectionBTagMin;
+    cJetSelectionBJetEtaMax = jetCleaner.cJetSelectionBJetEtaMax;
+
+    cOverlapdRMin = overlapdRMin;
+    cCleanJetsFromElectrons = true;
+    cCleanBJetsFromLeptons = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+bool FusedCollectionCleaner::muonID(MuonInfo& mu)
+{
+    if(cMuonSelectionID == 0) return mu.isTightID;
+    if(cMuonSelectionID == 1 && cUseMedium2016)  return mu.isMediumID2016;
+    if(cMuonSelectionID == 1 && !cUseMedium2016) return mu.isMediumID;
+    if(cMuonSelectionID == 2) return mu.isLooseID;
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+bool FusedCollectionCleaner::electronID(EleInfo& ele)
+{
+    if(cElectronSelectionID == 0) return ele.isTightID;
+    if(cElectronSelectionID == 1) return ele.isMediumID;
+    if(cElectronSelectionID == 2) return ele.isLooseID;
+    if(cElectronSelectionID == 3) return ele.isVetoID;
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+void FusedCollectionCleaner::getValidCollections(VarSet& vars, bool print)
+{
+// muons first, then electrons that are away from the valid muons, then jets that
+// are away from the valid muons and the valid electrons. Each raw collection is
+// visited once and the overlap removal is done as the objects are accepted.
+
+    vars.validMuons.clear();
+    vars.validExtraMuons.clear();
+    vars.validElectrons.clear();
+    vars.validJets.clear();
+    vars.validBJets.clear();
+    vars.validJetsIdx.clear();
+
+    muEta.clear();
+    muPhi.clear();
+    eleEta.clear();
+    elePhi.clear();
+
+    double dR2min = (double)cOverlapdRMin*cOverlapdRMin;
+
+    // muons ---------------------------------------------------------------
+    MuonInfo* muons = vars.muons->data();
+    unsigned int nmuons = vars.muons->size();
+    for(unsigned int j=0; j<nmuons; j++)
+    {
+        MuonInfo& mu = muons[j];
+
+        // Pt, Eta, ID and isolation
+        if(!(mu.pt > cMuonSelectionPtMin && TMath::Abs(mu.eta) < cMuonSelectionEtaMax && muonID(mu)))
+            continue;
+        if(!(mu.iso() <= cMuonSelectionIsoMax))
+            continue;
+
+        TLorentzVector mu4vec = mu.get4vec();
+        vars.validMuons.push_back(mu4vec);
+        if(j!=vars.dimuCand->iMu1 && j!=vars.dimuCand->iMu2) vars.validExtraMuons.push_back(mu4vec);
+
+        muEta.push_back(mu.eta);
+        muPhi.push_back(mu.phi);
+    }
+
+    // electrons -----------------------------------------------------------
+    EleInfo* electrons = vars.electrons->data();
+    unsigned int nelectrons = vars.electrons->size();
+    for(unsigned int j=0; j<nelectrons; j++)
+    {
+        EleInfo& ele = electrons[j];
+
+        // crack in the hcal
+        double eta = TMath::Abs(ele.eta);
+        if(!(eta < 1.4442 || (eta > 1.566 && eta < cElectronSelectionEtaMax)))
+            continue;
+
+        // Pt, Eta, ID, conversion veto, missing inner hits and isolation
+        if(!(ele.pt > cElectronSelectionPtMin && eta < cElectronSelectionEtaMax && electronID(ele)))
+            continue;
+        if(!ele.passConversionVeto)
+            continue;
+        if(!(TMath::Abs(ele.missingInnerHits) <= 1))
+            continue;
+        if(!(ele.iso() <= cElectronSelectionIsoMax))
+            continue;
+
+        // overlap with a valid muon
+        if(overlapsDR2(ele.eta, ele.phi, muEta.data(), muPhi.data(), muEta.size(), dR2min))
+        {
+            if(print) std::cout << Form("Removing electron near muon > %s\n", ele.outputInfo().Data());
+            continue;
+        }
+
+        vars.validElectrons.push_back(ele.get4vec());
+        eleEta.push_back(ele.eta);
+        elePhi.push_back(ele.phi);
+    }
+
+    // jets and bjets ------------------------------------------------------
+    SlimJetInfo* jets = vars.jets->data();
+    unsigned int njets = vars.jets->size();
+    for(unsigned int j=0; j<njets; j++)
+    {
+        SlimJetInfo& jet = jets[j];
+        if(print) std::cout << Form("Checking > %s\n", jet.outputInfo().Data());
+
+        // Pt and Eta selections for a regular jet
+        double eta = TMath::Abs(jet.eta);
+        if(!(jet.pt > cJetSelectionPtMin && eta < cJetSelectionEtaMax))
+            continue;
+
+        // further selections for a bjet, eta should be tighter since we need the tracker
+        bool isB = jet.CSV > cJetSelectionBTagMin && eta < cJetSelectionBJetEtaMax;
+
+        bool overlap = overlapsDR2(jet.eta, jet.phi, muEta.data(), muPhi.data(), muEta.size(), dR2min);
+        if(cCleanJetsFromElectrons && !overlap)
+            overlap = overlapsDR2(jet.eta, jet.phi, eleEta.data(), elePhi.data(), eleEta.size(), dR2min);
+
+        if(!overlap || (isB && !cCleanBJetsFromLeptons))
+        {
+            TLorentzVector jet4vec = jet.get4vec();
+            if(!overlap)
+            {
+                if(print) std::cout << Form("Adding to jets > %s\n", jet.outputInfo().Data());
+                vars.validJets.push_back(jet4vec);
+                vars.validJetsIdx.push_back(j);
+            }
+            if(isB)
+            {
+                if(print) std::cout << Form("Adding to bjets > %s\n", jet.outputInfo().Data());
+                vars.validBJets.push_back(jet4vec);
+            }
+        }
+        else if(print) std::cout << Form("Removing jet near lepton > %s\n", jet.outputInfo().Data());
+    }
+}
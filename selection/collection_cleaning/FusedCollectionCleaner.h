@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////
+//                         FusedCollectionCleaner.h                      //
+//=======================================================================//
+//                                                                       //
+//        Select valid muons, electrons, jets and bjets and remove the   //
+//        overlaps between them in a single pass over each collection.   //
+//        Does the same job as the Muon/Ele/JetCollectionCleaners        //
+//        followed by the cleanByDR calls.                               //
+//                                                                       //
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_FUSEDCOLLECTIONCLEANER
+#define ADD_FUSEDCOLLECTIONCLEANER
+
+#include "VarSet.h"
+#include <vector>
+#include "CollectionCleaner.hxx"
+#include "JetCollectionCleaner.h"
+#include "MuonCollectionCleaner.h"
+#include "EleCollectionCleaner.h"
+
+class FusedCollectionCleaner : public CollectionCleaner
+{
+    public:
+        FusedCollectionCleaner();
+        FusedCollectionCleaner(JetCollectionCleaner& jetCleaner, MuonCollectionCleaner& muonCleaner,
+                               EleCollectionCleaner& eleCleaner, float overlapdRMin);
+
+        // muon selection, same meaning as in MuonCollectionCleaner
+        float cMuonSelectionPtMin;
+        float cMuonSelectionEtaMax;
+        float cMuonSelectionIsoMax;
+        int   cMuonSelectionID;
+        bool  cUseMedium2016;
+
+        // electron selection, same meaning as in EleCollectionCleaner
+        float cElectronSelectionPtMin;
+        float cElectronSelectionEtaMax;
+        float cElectronSelectionIsoMax;
+        int   cElectronSelectionID;
+
+        // jet selection, same meaning as in JetCollectionCleaner
+        float cJetSelectionPtMin;
+        float cJetSelectionEtaMax;
+        float cJetSelectionBTagMin;
+        float cJetSelectionBJetEtaMax;
+
+        // overlap removal
+        float cOverlapdRMin;              // remove electrons, jets within this dR of a valid muon/electron
+        bool  cCleanJetsFromElectrons;    // also remove jets near a valid electron
+        bool  cCleanBJetsFromLeptons;     // apply the overlap removal to the bjets as well
+
+        // clears and fills vars.validMuons, validExtraMuons, validElectrons, validJets, validBJets
+        // and validJetsIdx so that the dijet pairing can use the analyzer's jetPairs
+        void getValidCollections(VarSet& vars, bool print=false);
+
+        bool muonID(MuonInfo& mu);
+        bool electronID(EleInfo& ele);
+
+    private:
+        // eta/phi of the accepted leptons, the jets are checked against these
+        std::vector<double> muEta, muPhi, eleEta, elePhi;
+};
+
+#endif
@@ -49,6 +49,11 @@ JetCollectionCleaner::JetCollectionCleaner(float jetSelectionPtMin, float jetSel
 void JetCollectionCleaner::getValidJets(VarSet& vars, std::vector<TLorentzVector>& jetvec, std::vector<TLorentzVector>& bjetvec, bool print)
 {
 // Determine the number of valid jets using the given cuts
+
+    // we don't keep track of the raw jet indices here and the jets may be
+    // cleaned afterwards, so don't let the dijet pairing use an old mapping
+    vars.validJetsIdx.clear();
+
     for(unsigned int j=0; j < vars.jets->size(); ++j)
     {
         if(print) std::cout << Form("Checking > %s\n", vars.jets->at(j).outputInfo().Data());
@@ -76,6 +81,11 @@ void JetCollectionCleaner::getValidJets(VarSet& vars, std::vector<TLorentzVector
 void JetCollectionCleaner::getValidJets(VarSet& vars, std::vector<TLorentzVector>& jetvec, bool require_b)
 {
 // Determine the number of valid jets using the given cuts
+
+    // we don't keep track of the raw jet indices here and the jets may be
+    // cleaned afterwards, so don't let the dijet pairing use an old mapping
+    vars.validJetsIdx.clear();
+
     for(unsigned int j=0; j < vars.jets->size(); ++j)
     {
         // bjet selection
@@ -0,0 +1,352 @@
+///////////////////////////////////////////////////////////////////////////
+//                           BDTForest.cxx                              //
+//=======================================================================//
+//                                                                       //
+//        Evaluate a TMVA BDT/BDTG from its weights xml without a        //
+//        TMVA::Reader. See BDTForest.h.                                 //
+//                                                                       //
+///////////////////////////////////////////////////////////////////////////
+
+#include "BDTForest.h"
+#include <cmath>
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+namespace
+{
+    TString getAttr(TXMLEngine* xml, XMLNodePointer_t node, const char* name)
+    {
+        const char* val = xml->GetAttr(node, name);
+        return val ? TString(val) : TString("");
+    }
+
+    XMLNodePointer_t findChild(TXMLEngine* xml, XMLNodePointer_t node, TString name)
+    {
+        XMLNodePointer_t child = xml->GetChild(node);
+        while(child != 0)
+        {
+            if(name == xml->GetNodeName(child)) return child;
+            child = xml->GetNext(child);
+        }
+        return 0;
+    }
+
+    // labels of the children of node called childname, e.g. the Label of each Variable in Variables
+    void getChildAttrs(TXMLEngine* xml, XMLNodePointer_t node, TString childname, const char* attname, std::vector<TString>& out)
+    {
+        if(node == 0) return;
+        XMLNodePointer_t child = xml->GetChild(node);
+        while(child != 0)
+        {
+            if(childname == xml->GetNodeName(child)) out.push_back(getAttr(xml, child, attname));
+            child = xml->GetNext(child);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+bool BDTForest::loadFromXML(TString weightfile)
+{
+// Read the variables, classes, and trees from a TMVA BDT weights xml file.
+// Only forests without variable transformations and without fisher cuts are supported.
+
+    loaded = false;
+    methodName = "";
+    varnames.clear();
+    spectators.clear();
+    classes.clear();
+    nodes.clear();
+    roots.clear();
+    boostWeights.clear();
+    sumBoostWeights = 0;
+    isGrad = false;
+    isMulticlass = false;
+    useYesNoLeaf = true;
+
+    TXMLEngine* xml = new TXMLEngine;
+    XMLDocPointer_t xmldoc = xml->ParseFile(weightfile);
+    if(xmldoc == 0)
+    {
+        std::cout << "  !!! BDTForest: could not parse " << weightfile << std::endl;
+        delete xml;
+        return false;
+    }
+
+    XMLNodePointer_t mainnode = xml->DocGetRootElement(xmldoc);
+    methodName = getAttr(xml, mainnode, "Method");
+    if(methodName.Contains("::")) methodName = methodName(methodName.Index("::")+2, methodName.Length());
+
+    bool ok = true;
+    XMLNodePointer_t weights = 0;
+    XMLNodePointer_t node = xml->GetChild(mainnode);
+    while(node != 0)
+    {
+        TString nname = xml->GetNodeName(node);
+        if(nname == "GeneralInfo")
+        {
+            XMLNodePointer_t info = xml->GetChild(node);
+            while(info != 0)
+            {
+                if(getAttr(xml, info, "name") == "AnalysisType" && getAttr(xml, info, "value") == "Multiclass") isMulticlass = true;
+                info = xml->GetNext(info);
+            }
+        }
+        else if(nname == "Options")
+        {
+            XMLNodePointer_t option = xml->GetChild(node);
+            while(option != 0)
+            {
+                TString oname = getAttr(xml, option, "name");
+                TString value = xml->GetNodeContent(option) ? xml->GetNodeContent(option) : "";
+                if(oname == "BoostType")    isGrad = (value == "Grad");
+                if(oname == "UseYesNoLeaf") useYesNoLeaf = (value == "True");
+                option = xml->GetNext(option);
+            }
+        }
+        else if(nname == "Variables")  getChildAttrs(xml, node, "Variable", "Label", varnames);
+        else if(nname == "Spectators") getChildAttrs(xml, node, "Spectator", "Label", spectators);
+        else if(nname == "Classes")    getChildAttrs(xml, node, "Class", "Name", classes);
+        else if(nname == "Transformations")
+        {
+            if(getAttr(xml, node, "NTransformations").Atoi() != 0)
+            {
+                std::cout << "  !!! BDTForest: " << weightfile << " uses variable transformations, not supported" << std::endl;
+                ok = false;
+            }
+        }
+        else if(nname == "Weights") weights = node;
+        node = xml->GetNext(node);
+    }
+
+    nvars = varnames.size();
+    nclasses = classes.size();
+
+    if(ok && weights == 0)
+    {
+        std::cout << "  !!! BDTForest: " << weightfile << " has no Weights" << std::endl;
+        ok = false;
+    }
+
+    if(ok)
+    {
+        int analysisType = getAttr(xml, weights, "AnalysisType").Atoi();
+        XMLNodePointer_t tree = xml->GetChild(weights);
+        while(ok && tree != 0)
+        {
+            if(TString("BinaryTree") == xml->GetNodeName(tree))
+            {
+                XMLNodePointer_t root = findChild(xml, tree, "Node");
+                if(root == 0) { tree = xml->GetNext(tree); continue; }
+
+                double w = getAttr(xml, tree, "boostWeight").Atof();
+                roots.push_back(nodes.size());
+                boostWeights.push_back(w);
+                sumBoostWeights += w;
+                nodes.push_back(Node());
+                ok = loadNodeXML(xml, root, roots.back(), analysisType);
+            }
+            tree = xml->GetNext(tree);
+        }
+    }
+
+    if(ok && isMulticlass && (nclasses == 0 || roots.size()%nclasses != 0))
+    {
+        std::cout << "  !!! BDTForest: " << weightfile << " has " << roots.size() << " trees for " << nclasses << " classes" << std::endl;
+        ok = false;
+    }
+
+    xml->FreeDoc(xmldoc);
+    delete xml;
+
+    if(!ok)
+    {
+        nodes.clear();
+        roots.clear();
+        boostWeights.clear();
+        return false;
+    }
+
+    loaded = true;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+bool BDTForest::loadNodeXML(TXMLEngine* xml, XMLNodePointer_t xnode, int n, int analysisType)
+{
+// Fill nodes[n] from xnode and recurse into its daughters. The daughters of a node
+// are reserved as a pair so they sit next to each other in the array.
+
+    if(getAttr(xml, xnode, "NCoef").Atoi() != 0)
+    {
+        std::cout << "  !!! BDTForest: fisher cuts are not supported" << std::endl;
+        return false;
+    }
+
+    XMLNodePointer_t xleft = 0;
+    XMLNodePointer_t xright = 0;
+    XMLNodePointer_t child = xml->GetChild(xnode);
+    while(child != 0)
+    {
+        if(TString("Node") == xml->GetNodeName(child))
+        {
+            TString pos = getAttr(xml, child, "pos");
+            if(pos == "l") xleft = child;
+            else if(pos == "r") xright = child;
+        }
+        child = xml->GetNext(child);
+    }
+
+    // leaf, same response as DecisionTree::CheckEvent
+    if(xleft == 0 || xright == 0)
+    {
+        float response;
+        if(analysisType == 1)                response = getAttr(xml, xnode, "res").Atof();
+        else if(useYesNoLeaf && !isGrad)     response = getAttr(xml, xnode, "nType").Atoi();
+        else                                 response = getAttr(xml, xnode, "purity").Atof();
+
+        nodes[n].cut = response;
+        nodes[n].var = -1;
+        nodes[n].left = -1;
+        return true;
+    }
+
+    int var = getAttr(xml, xnode, "IVar").Atoi();
+    if(var < 0 || var >= (int)nvars)
+    {
+        std::cout << "  !!! BDTForest: node uses variable " << var << " but there are only " << nvars << " variables" << std::endl;
+        return false;
+    }
+
+    // TMVA goes right for x >= cut when cType is 1 and left otherwise
+    int cType = getAttr(xml, xnode, "cType").Atoi();
+    XMLNodePointer_t xlow  = (cType == 1) ? xleft  : xright;
+    XMLNodePointer_t xhigh = (cType == 1) ? xright : xleft;
+
+    int left = nodes.size();
+    nodes.resize(left+2);
+    nodes[n].cut = (float) getAttr(xml, xnode, "Cut").Atof();
+    nodes[n].var = var;
+    nodes[n].left = left;
+
+    return loadNodeXML(xml, xlow, left, analysisType) && loadNodeXML(xml, xhigh, left+1, analysisType);
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+double BDTForest::finalize(double sum) const
+{
+// Gradient boost maps the sum onto (-1,1), the others are weighted averages
+
+    if(isGrad) return 2.0/(1.0+std::exp(-2.0*sum)) - 1.0;
+    return (sumBoostWeights > 0) ? sum/sumBoostWeights : 0;
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+float BDTForest::evaluate(const float* x) const
+{
+// Same as TMVA::Reader::EvaluateMVA for a binary classification forest
+
+    double sum = 0;
+    if(isGrad)
+    {
+        for(unsigned int t=0; t<roots.size(); t++)
+            sum += nodes[walk(roots[t], x)].cut;
+    }
+    else
+    {
+        for(unsigned int t=0; t<roots.size(); t++)
+            sum += boostWeights[t]*nodes[walk(roots[t], x)].cut;
+    }
+    return finalize(sum);
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+void BDTForest::evaluateMulticlass(const float* x, float* out) const
+{
+// Same as TMVA::Reader::EvaluateMulticlass, tree i belongs to class i%nclasses
+
+    std::vector<double> sums(nclasses, 0);
+    for(unsigned int t=0; t<roots.size(); t++)
+        sums[t%nclasses] += nodes[walk(roots[t], x)].cut;
+
+    for(unsigned int i=0; i<nclasses; i++)
+    {
+        double norm = 0;
+        for(unsigned int j=0; j<nclasses; j++)
+            if(j != i) norm += std::exp(sums[j]-sums[i]);
+        out[i] = 1.0/(1.0+norm);
+    }
+}
+
+std::vector<float> BDTForest::evaluateMulticlass(const float* x) const
+{
+    std::vector<float> out(nclasses, 0);
+    evaluateMulticlass(x, out.data());
+    return out;
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+void BDTForest::evaluateBatch(const float* x, unsigned int nevents, float* out) const
+{
+// Trees in the outer loop, events in the inner loop, so each tree's nodes
+// stay in cache while the whole batch goes through it
+
+    std::vector<double> sums(nevents, 0);
+    for(unsigned int t=0; t<roots.size(); t++)
+    {
+        int root = roots[t];
+        double w = isGrad ? 1.0 : boostWeights[t];
+        for(unsigned int e=0; e<nevents; e++)
+            sums[e] += w*nodes[walk(root, x + e*nvars)].cut;
+    }
+
+    for(unsigned int e=0; e<nevents; e++)
+        out[e] = finalize(sums[e]);
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+void BDTForest::evaluateMulticlassBatch(const float* x, unsigned int nevents, float* out) const
+{
+    std::vector<double> sums(nevents*nclasses, 0);
+    for(unsigned int t=0; t<roots.size(); t++)
+    {
+        int root = roots[t];
+        unsigned int c = t%nclasses;
+        for(unsigned int e=0; e<nevents; e++)
+            sums[e*nclasses + c] += nodes[walk(root, x + e*nvars)].cut;
+    }
+
+    for(unsigned int e=0; e<nevents; e++)
+    {
+        double* s = &sums[e*nclasses];
+        for(unsigned int i=0; i<nclasses; i++)
+        {
+            double norm = 0;
+            for(unsigned int j=0; j<nclasses; j++)
+                if(j != i) norm += std::exp(s[j]-s[i]);
+            out[e*nclasses + i] = 1.0/(1.0+norm);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////
+//                           BDTForest.h                                //
+//=======================================================================//
+//                                                                       //
+//        Evaluate a TMVA BDT/BDTG from its weights xml without a        //
+//        TMVA::Reader. The trees are read into flat node arrays and     //
+//        walked with one compare per level. Single events and batches   //
+//        of events, binary and multiclass. Gives the same output as     //
+//        Reader::EvaluateMVA and Reader::EvaluateMulticlass.            //
+//                                                                       //
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_BDTFOREST
+#define ADD_BDTFOREST
+
+#include <vector>
+#include <iostream>
+
+#include "TXMLEngine.h"
+#include "TString.h"
+
+class BDTForest
+{
+    public:
+        BDTForest(){};
+        BDTForest(TString weightfile){ loadFromXML(weightfile); };
+        ~BDTForest(){};
+
+        // information from the weights file
+        TString methodName;
+        std::vector<TString> varnames;       // training variables in input order
+        std::vector<TString> spectators;     // spectator variables, not used in the evaluation
+        std::vector<TString> classes;
+        unsigned int nvars = 0;
+        unsigned int nclasses = 0;
+        bool isGrad = false;                 // BoostType=Grad, sum of the responses then 2/(1+exp(-2*sum))-1
+        bool isMulticlass = false;
+        bool useYesNoLeaf = true;            // for the non gradient boosted classification forests
+        bool loaded = false;
+
+        unsigned int ntrees() const { return roots.size(); };
+        unsigned int nnodes() const { return nodes.size(); };
+
+        bool loadFromXML(TString weightfile);
+
+        // x holds the nvars training variables in the order of varnames
+        float evaluate(const float* x) const;
+        void  evaluateMulticlass(const float* x, float* out) const;       // out has nclasses entries
+        std::vector<float> evaluateMulticlass(const float* x) const;
+
+        // x holds nevents rows of nvars, out holds nevents (binary) or nevents*nclasses (multiclass) results
+        void evaluateBatch(const float* x, unsigned int nevents, float* out) const;
+        void evaluateMulticlassBatch(const float* x, unsigned int nevents, float* out) const;
+
+    private:
+        friend class FusedClassifier;
+
+        // Nodes of all trees in one array. For an intermediate node the daughters are at
+        // left and left+1, the event goes to left+1 if x[var] >= cut. Trees with cType=0
+        // have their daughters swapped when they are loaded so the compare is always the same.
+        // For a leaf var = -1 and cut holds the response of the leaf.
+        struct Node
+        {
+            float cut;
+            int var;
+            int left;
+        };
+
+        std::vector<Node> nodes;
+        std::vector<int> roots;              // index of the root node of each tree
+        std::vector<double> boostWeights;
+        double sumBoostWeights = 0;
+
+        bool loadNodeXML(TXMLEngine* xml, XMLNodePointer_t xnode, int n, int analysisType);
+        int walk(int n, const float* x) const
+        {
+            const Node* nd = nodes.data();
+            while(nd[n].var >= 0)
+                n = nd[n].left + (x[nd[n].var] >= nd[n].cut);
+            return n;
+        };
+        double finalize(double sum) const;
+};
+
+#endif
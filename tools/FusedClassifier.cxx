@@ -0,0 +1,185 @@
+///////////////////////////////////////////////////////////////////////////
+//                           FusedClassifier.cxx                        //
+//=======================================================================//
+//                                                                       //
+//        Several BDTForests evaluated in one pass over one shared       //
+//        input array. See FusedClassifier.h.                            //
+//                                                                       //
+///////////////////////////////////////////////////////////////////////////
+
+#include "FusedClassifier.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+bool FusedClassifier::build(const std::vector< std::shared_ptr<const BDTForest> >& forests)
+{
+// Copy the trees of all of the forests into one node array with the variable indices
+// remapped onto the union of the inputs
+
+    built = false;
+    varnames.clear();
+    spectators.clear();
+    outputOffset.clear();
+    outputNames.clear();
+    nodes.clear();
+    response.clear();
+    trees.clear();
+    forestInfo.clear();
+    noutputs = 0;
+
+    for(auto& forest: forests)
+    {
+        if(!forest || !forest->loaded)
+        {
+            std::cout << "  !!! FusedClassifier: forest is not loaded" << std::endl;
+            return false;
+        }
+
+        // slot of each of this forest's variables in the shared inputs
+        std::vector<int> slot;
+        for(auto& var: forest->varnames)
+        {
+            auto it = std::find(varnames.begin(), varnames.end(), var);
+            slot.push_back(it - varnames.begin());
+            if(it == varnames.end()) varnames.push_back(var);
+        }
+        for(auto& var: forest->spectators)
+            if(std::find(spectators.begin(), spectators.end(), var) == spectators.end()) spectators.push_back(var);
+
+        Output info;
+        info.isGrad = forest->isGrad;
+        info.isMulticlass = forest->isMulticlass;
+        info.nclasses = forest->isMulticlass ? forest->nclasses : 1;
+        info.norm = forest->sumBoostWeights;
+        forestInfo.push_back(info);
+        outputOffset.push_back(noutputs);
+        for(unsigned int c=0; c<info.nclasses; c++)
+            outputNames.push_back(info.isMulticlass && c < forest->classes.size() ? forest->classes[c] : TString(""));
+
+        for(unsigned int t=0; t<forest->roots.size(); t++)
+        {
+            int first = forest->roots[t];
+            int last = (t+1 < forest->roots.size()) ? forest->roots[t+1] : forest->nodes.size();
+            int shift = (int)nodes.size() - first;
+
+            for(int n=first; n<last; n++)
+            {
+                const BDTForest::Node& in = forest->nodes[n];
+                Node out;
+                if(in.var < 0)
+                {
+                    out.cut = std::numeric_limits<float>::quiet_NaN();   // x >= NaN is always false
+                    out.var = 0;
+                    out.left = n + shift;
+                    response.push_back(in.cut);
+                }
+                else
+                {
+                    out.cut = in.cut;
+                    out.var = slot[in.var];
+                    out.left = in.left + shift;
+                    response.push_back(0);
+                }
+                nodes.push_back(out);
+            }
+
+            Tree tree;
+            tree.root = first + shift;
+            tree.output = noutputs + (info.isMulticlass ? t%info.nclasses : 0);
+            tree.weight = (info.isGrad || info.isMulticlass) ? 1.0 : forest->boostWeights[t];
+            trees.push_back(tree);
+        }
+        noutputs += info.nclasses;
+    }
+
+    if(noutputs > kMaxOutputs)
+    {
+        std::cout << "  !!! FusedClassifier: " << noutputs << " outputs, at most " << kMaxOutputs << " are supported" << std::endl;
+        return false;
+    }
+
+    for(auto& tree: trees)
+        tree.depth = treeDepth(tree.root);
+    std::stable_sort(trees.begin(), trees.end(), [](const Tree& a, const Tree& b){ return a.depth < b.depth; });
+
+    nvars = varnames.size();
+    built = true;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+int FusedClassifier::treeDepth(int n) const
+{
+    if(nodes[n].left == n) return 0;
+    return 1 + std::max(treeDepth(nodes[n].left), treeDepth(nodes[n].left+1));
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+void FusedClassifier::evaluate(const float* x, float* out) const
+{
+// Walk kLanes trees at once for as many steps as the deepest of them, trees that reach
+// a leaf early stay there. Then the same transforms as BDTForest for each forest.
+
+    double sums[kMaxOutputs] = {0};
+    const Node* nd = nodes.data();
+    unsigned int ntrees = trees.size();
+    unsigned int t = 0;
+
+    for(; t+kLanes <= ntrees; t += kLanes)
+    {
+        const Tree* tr = &trees[t];
+        int n0 = tr[0].root;
+        int n1 = tr[1].root;
+        int n2 = tr[2].root;
+        int n3 = tr[3].root;
+        int depth = tr[kLanes-1].depth;
+        for(int d=0; d<depth; d++)
+        {
+            n0 = nd[n0].left + (x[nd[n0].var] >= nd[n0].cut);
+            n1 = nd[n1].left + (x[nd[n1].var] >= nd[n1].cut);
+            n2 = nd[n2].left + (x[nd[n2].var] >= nd[n2].cut);
+            n3 = nd[n3].left + (x[nd[n3].var] >= nd[n3].cut);
+        }
+        sums[tr[0].output] += tr[0].weight*response[n0];
+        sums[tr[1].output] += tr[1].weight*response[n1];
+        sums[tr[2].output] += tr[2].weight*response[n2];
+        sums[tr[3].output] += tr[3].weight*response[n3];
+    }
+
+    for(; t < ntrees; t++)
+    {
+        int n = trees[t].root;
+        for(int d=0; d<trees[t].depth; d++)
+            n = nd[n].left + (x[nd[n].var] >= nd[n].cut);
+        sums[trees[t].output] += trees[t].weight*response[n];
+    }
+
+    for(unsigned int f=0; f<forestInfo.size(); f++)
+    {
+        const Output& info = forestInfo[f];
+        unsigned int o = outputOffset[f];
+        if(info.isMulticlass)
+        {
+            for(unsigned int i=0; i<info.nclasses; i++)
+            {
+                double norm = 0;
+                for(unsigned int j=0; j<info.nclasses; j++)
+                    if(j != i) norm += std::exp(sums[o+j]-sums[o+i]);
+                out[o+i] = 1.0/(1.0+norm);
+            }
+        }
+        else if(info.isGrad) out[o] = 2.0/(1.0+std::exp(-2.0*sums[o])) - 1.0;
+        else out[o] = (info.norm > 0) ? sums[o]/info.norm : 0;
+    }
+}
@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////
+//                           FusedClassifier.h                          //
+//=======================================================================//
+//                                                                       //
+//        Several BDTForests, e.g. the binary and the multiclass         //
+//        classifier, evaluated in one pass over one shared input        //
+//        array. The trees of all of the forests are walked a few at a   //
+//        time in lock step so the independent node loads overlap.       //
+//                                                                       //
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ADD_FUSEDCLASSIFIER
+#define ADD_FUSEDCLASSIFIER
+
+#include <vector>
+#include <memory>
+#include <iostream>
+
+#include "TString.h"
+#include "BDTForest.h"
+
+class FusedClassifier
+{
+    public:
+        FusedClassifier(){};
+        FusedClassifier(const std::vector< std::shared_ptr<const BDTForest> >& forests){ build(forests); };
+        ~FusedClassifier(){};
+
+        static const unsigned int kMaxOutputs = 32;
+
+        std::vector<TString> varnames;                 // union of the training variables of all forests, the input order
+        std::vector<TString> spectators;
+        std::vector<unsigned int> outputOffset;        // first output of each forest, binary forests have one output
+        std::vector<TString> outputNames;              // class name of each output, "" for the binary forests
+        unsigned int nvars = 0;
+        unsigned int noutputs = 0;
+        bool built = false;
+
+        bool build(const std::vector< std::shared_ptr<const BDTForest> >& forests);
+
+        // x holds the nvars inputs in the order of varnames, out gets noutputs scores
+        void evaluate(const float* x, float* out) const;
+
+    private:
+        static const unsigned int kLanes = 4;          // trees walked together, evaluate is written out for four
+
+        // Same layout as BDTForest::Node, except that a leaf points back at itself with a cut
+        // that no value passes, so every tree can be walked a fixed number of steps without a branch.
+        // The leaf responses are in a separate array.
+        struct Node
+        {
+            float cut;
+            int var;
+            int left;
+        };
+
+        struct Tree
+        {
+            int root;
+            int depth;
+            int output;          // accumulator the leaf response is added to
+            double weight;
+        };
+
+        struct Output
+        {
+            bool isGrad;
+            bool isMulticlass;
+            unsigned int nclasses;
+            double norm;         // sum of the boost weights for the non gradient boosted forests
+        };
+
+        std::vector<Node> nodes;
+        std::vector<float> response;
+        std::vector<Tree> trees;          // sorted by depth so that the trees walked together have about the same depth
+        std::vector<Output> forestInfo;
+
+        int treeDepth(int n) const;
+};
+
+#endif
@@ -7,6 +7,7 @@
 ///////////////////////////////////////////////////////////////////////////
 
 #include "TMVATools.h"
+#include <mutex>
 
 //////////////////////////////////////////////////////////////////
 //---------------------------------------------------------------
@@ -184,3 +185,222 @@ std::vector<float> TMVATools::getMulticlassScores(TMVA::Reader* reader, TString
       return reader->EvaluateMulticlass(methodName);
 }
 
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+void TMVATools::bindInputs(const std::vector<TString>& tvars, const std::vector<TString>& svars, VarSet& varset, ClassifierInputs& inputs)
+{
+// resolve each label to a VarSet handle once, slot i of values/spectators belongs to tvars[i]/svars[i].
+// Labels that VarSet doesn't know get an invalid handle and read as -999, same as VarSet::getValue.
+
+    inputs.varnames = tvars;
+    inputs.spectatorNames = svars;
+    inputs.handles.clear();
+    inputs.spectatorHandles.clear();
+
+    for(auto& var: tvars)
+    {
+        inputs.handles.push_back(varset.getHandle(var.Data()));
+        if(!inputs.handles.back().valid())
+            std::cout << Form("  !!! TMVATools: training variable %s is not in VarSet \n", var.Data());
+    }
+    for(auto& var: svars)
+        inputs.spectatorHandles.push_back(varset.getHandle(var.Data()));
+
+    inputs.values.assign(tvars.size(), -999);
+    inputs.spectators.assign(svars.size(), -999);
+    inputs.bound = true;
+}
+
+void TMVATools::bindInputs(const BDTForest& classifier, VarSet& varset, ClassifierInputs& inputs)
+{
+    bindInputs(classifier.varnames, classifier.spectators, varset, inputs);
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+TMVA::Reader* TMVATools::bookVars(TString methodName, TString weightfile, ClassifierInputs& inputs, VarSet& varset)
+{
+// Same as the map version above, but the reader reads straight from the slots in inputs.
+// inputs must not be rebound while the reader is in use.
+
+   std::vector<TString> tvars;
+   std::vector<TString> svars;
+   getVarNames(weightfile, tvars, svars);
+   bindInputs(tvars, svars, varset, inputs);
+
+   TMVA::Reader *reader = new TMVA::Reader("!Color:!Silent");    
+
+   for(unsigned int v=0; v<tvars.size(); v++)
+       reader->AddVariable(tvars[v], &inputs.values[v]);
+
+   for(unsigned int v=0; v<svars.size(); v++)
+       reader->AddSpectator(svars[v], &inputs.spectators[v]);
+
+   reader->BookMVA( methodName, weightfile );  
+
+   return reader;
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+float TMVATools::getClassifierScore(TMVA::Reader* reader, TString methodName, ClassifierInputs& inputs, VarSet& varset)
+{
+// the reader was booked on the slots of inputs with bookVars, gather the values and evaluate
+
+      inputs.gather(varset);
+      return reader->EvaluateMVA(methodName);
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+std::vector<float> TMVATools::getMulticlassScores(TMVA::Reader* reader, TString methodName, ClassifierInputs& inputs, VarSet& varset)
+{
+      inputs.gather(varset);
+      return reader->EvaluateMulticlass(methodName);
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const BDTForest> TMVATools::getClassifier(TString weightfile)
+{
+// load the forest for the weights file the first time it is asked for, afterwards
+// hand out the same object. Returns a null pointer if the file can't be loaded.
+
+    static std::mutex lock;
+    static std::map<TString, std::shared_ptr<const BDTForest> > classifiers;
+
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = classifiers.find(weightfile);
+    if(it != classifiers.end()) return it->second;
+
+    std::shared_ptr<BDTForest> forest = std::make_shared<BDTForest>();
+    if(!forest->loadFromXML(weightfile))
+    {
+        std::cout << Form("  !!! TMVATools: could not load the classifier from %s \n", weightfile.Data());
+        forest.reset();
+    }
+    classifiers[weightfile] = forest;
+    return forest;
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+float TMVATools::getClassifierScore(const BDTForest& classifier, ClassifierInputs& inputs, VarSet& varset)
+{
+// get the classifier score from the shared forest, inputs is the calling thread's scratch space
+
+      if(!inputs.bound) bindInputs(classifier, varset, inputs);
+      inputs.gather(varset);
+      return classifier.evaluate(inputs.values.data());
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+std::vector<float> TMVATools::getMulticlassScores(const BDTForest& classifier, ClassifierInputs& inputs, VarSet& varset)
+{
+// get the multiclass scores from the shared forest, inputs is the calling thread's scratch space
+
+      if(!inputs.bound) bindInputs(classifier, varset, inputs);
+      inputs.gather(varset);
+      return classifier.evaluateMulticlass(inputs.values.data());
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+float TMVATools::getClassifierScore(const BDTForest& classifier, ClassifierInputs& inputs, VarSet& varset,
+                                    ScoreCache* cache, long long entry, int candidate)
+{
+// only the misses gather the inputs and walk the forest
+
+      float score = 0;
+      if(cache && cache->get(entry, candidate, score)) return score;
+
+      score = getClassifierScore(classifier, inputs, varset);
+      if(cache) cache->put(entry, candidate, score);
+      return score;
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const FusedClassifier> TMVATools::getFusedClassifier(const std::vector<TString>& weightfiles)
+{
+// fuse the forests for the weights files the first time this list is asked for, afterwards
+// hand out the same object. Returns a null pointer if any of the files can't be loaded.
+
+    std::vector< std::shared_ptr<const BDTForest> > forests;
+    TString key = "";
+    for(auto& weightfile: weightfiles)
+    {
+        forests.push_back(getClassifier(weightfile));
+        if(!forests.back()) return std::shared_ptr<const FusedClassifier>();
+        key += weightfile+";";
+    }
+
+    static std::mutex lock;
+    static std::map<TString, std::shared_ptr<const FusedClassifier> > classifiers;
+
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = classifiers.find(key);
+    if(it != classifiers.end()) return it->second;
+
+    std::shared_ptr<FusedClassifier> fused = std::make_shared<FusedClassifier>();
+    if(!fused->build(forests)) fused.reset();
+    classifiers[key] = fused;
+    return fused;
+}
+
+//////////////////////////////////////////////////////////////////
+//---------------------------------------------------------------
+//////////////////////////////////////////////////////////////////
+
+void TMVATools::setClassifierScores(const FusedClassifier& classifier, ClassifierInputs& inputs, VarSet& varset)
+{
+// The first forest is the binary classifier, its output goes to bdt_out. The multiclass outputs
+// go to bdt_<class>_out by the class names of the weights file, e.g. ggH -> bdt_ggh_out.
+// The inputs are gathered once for all of the forests.
+
+      if(!inputs.bound)
+      {
+          bindInputs(classifier.varnames, classifier.spectators, varset, inputs);
+          inputs.outputs.assign(classifier.noutputs, 0);
+          for(unsigned int o=0; o<classifier.noutputs; o++)
+          {
+              TString name = classifier.outputNames[o];
+              name.ToLower();
+              if(name == "" && o == 0) inputs.outputs[o] = &VarSet::bdt_out;
+              else if(name == "ggh") inputs.outputs[o] = &VarSet::bdt_ggh_out;
+              else if(name == "vbf") inputs.outputs[o] = &VarSet::bdt_vbf_out;
+              else if(name == "vh")  inputs.outputs[o] = &VarSet::bdt_vh_out;
+              else if(name == "ewk") inputs.outputs[o] = &VarSet::bdt_ewk_out;
+              else if(name == "top") inputs.outputs[o] = &VarSet::bdt_top_out;
+              else if(classifier.outputNames[o] != "")
+                  std::cout << Form("  !!! TMVATools: no VarSet member for the class %s, not stored \n", classifier.outputNames[o].Data());
+          }
+      }
+      inputs.gather(varset);
+
+      float out[FusedClassifier::kMaxOutputs];
+      classifier.evaluate(inputs.values.data(), out);
+
+      for(unsigned int o=0; o<classifier.noutputs; o++)
+          if(inputs.outputs[o] != 0) varset.*inputs.outputs[o] = out[o];
+}
@@ -12,11 +12,37 @@
 #include <vector>
 #include <map>
 #include <iostream>
+#include <memory>
 
 #include "TXMLEngine.h"
 #include "TMVA/Reader.h"
 #include "TString.h"
 #include "VarSet.h"
+#include "BDTForest.h"
+#include "FusedClassifier.h"
+#include "ScoreCache.hxx"
+
+// The classifier inputs resolved to VarSet handles once. Each event the values are
+// gathered into contiguous float arrays in the order of the training/spectator variables.
+struct ClassifierInputs
+{
+    std::vector<TString> varnames;
+    std::vector<TString> spectatorNames;
+    std::vector<VarSet::VarHandle> handles;
+    std::vector<VarSet::VarHandle> spectatorHandles;
+    std::vector<float> values;
+    std::vector<float> spectators;
+    std::vector<double VarSet::*> outputs;    // VarSet member of each classifier output, 0 if it isn't stored
+    bool bound = false;
+
+    void gather(VarSet& varset)
+    {
+        for(unsigned int v=0; v<handles.size(); v++)
+            values[v] = varset.getValue(handles[v]);
+        for(unsigned int v=0; v<spectatorHandles.size(); v++)
+            spectators[v] = varset.getValue(spectatorHandles[v]);
+    }
+};
 
 class TMVATools
 {
@@ -32,5 +58,30 @@ class TMVATools
         static TMVA::Reader* bookVars(TString methodName, TString weightfile, std::map<TString, Float_t>& tmap, std::map<TString, Float_t>& smap);
         static float getClassifierScore(TMVA::Reader* reader, TString methodName, std::map<TString, Float_t>& tmap, VarSet& varset);
         static std::vector<float> getMulticlassScores(TMVA::Reader* reader, TString methodName, std::map<TString, Float_t>& tmap, VarSet& varset);
+
+        // Resolve the training and spectator variables to VarSet handles and slots in inputs
+        static void bindInputs(const std::vector<TString>& tvars, const std::vector<TString>& svars, VarSet& varset, ClassifierInputs& inputs);
+        static void bindInputs(const BDTForest& classifier, VarSet& varset, ClassifierInputs& inputs);
+
+        // Reader booked on the slots of inputs, getClassifierScore then only gathers the values
+        static TMVA::Reader* bookVars(TString methodName, TString weightfile, ClassifierInputs& inputs, VarSet& varset);
+        static float getClassifierScore(TMVA::Reader* reader, TString methodName, ClassifierInputs& inputs, VarSet& varset);
+        static std::vector<float> getMulticlassScores(TMVA::Reader* reader, TString methodName, ClassifierInputs& inputs, VarSet& varset);
+
+        // The forest for a weights file is parsed once per process and shared read only between
+        // threads and systematics. Each thread keeps its own ClassifierInputs, bound on first use.
+        static std::shared_ptr<const BDTForest> getClassifier(TString weightfile);
+        static float getClassifierScore(const BDTForest& classifier, ClassifierInputs& inputs, VarSet& varset);
+        static std::vector<float> getMulticlassScores(const BDTForest& classifier, ClassifierInputs& inputs, VarSet& varset);
+
+        // Binary and multiclass classifiers fused into one pass, shared read only like getClassifier.
+        // setClassifierScores writes bdt_out and the multiclass bdt_ggh_out ... bdt_top_out into varset,
+        // the multiclass outputs by the class names in the weights file.
+        static std::shared_ptr<const FusedClassifier> getFusedClassifier(const std::vector<TString>& weightfiles);
+        static void setClassifierScores(const FusedClassifier& classifier, ClassifierInputs& inputs, VarSet& varset);
+
+        // score for the entry and dimuon candidate from the cache, evaluated and added to the cache if it isn't there
+        static float getClassifierScore(const BDTForest& classifier, ClassifierInputs& inputs, VarSet& varset,
+                                        ScoreCache* cache, long long entry, int candidate);
 };
 #endif